@@ -0,0 +1,50 @@
+#ifndef PROJECT_BATCH_SIMULATION_H
+#define PROJECT_BATCH_SIMULATION_H
+
+#include <ifc/cutter/cutter.h>
+#include <ifc/material/material_box.h>
+
+#include <memory>
+
+namespace ifc {
+
+class HeightMap;
+class StockSnapshot;
+
+/**
+ * Runs programs on a height map without rendering,
+ * e.g. to find stock left by previous cutters.
+ * Height map has the same dimensions and precision as material box,
+ * programs are run one after another on the same stock.
+ */
+class BatchSimulation {
+public:
+
+    BatchSimulation(MaterialBoxCreateParams params);
+    /**
+     * Starts from stock of previous operations.
+     */
+    BatchSimulation(const StockSnapshot& snapshot);
+    ~BatchSimulation();
+
+    HeightMap* height_map(){return height_map_.get();}
+    const MaterialBoxDimensions& dimensions(){return params_.dimensions;}
+
+    /**
+     * Runs all instructions of the cutter (cutter itself is not modified).
+     * Returns FINISHED or the error that stopped the program.
+     */
+    CutterStatus Run(std::shared_ptr<Cutter> cutter);
+
+    std::shared_ptr<StockSnapshot> Snapshot();
+
+private:
+    MaterialBoxCreateParams params_;
+    std::unique_ptr<HeightMap> height_map_;
+
+    // Distance [mm] between consecutive cuts, half of the cell.
+    float line_delta_;
+};
+}
+
+#endif //PROJECT_BATCH_SIMULATION_H
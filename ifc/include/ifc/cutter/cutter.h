@@ -64,13 +64,32 @@ public:
         Move();
     }
 
+    /**
+     * Longest part of an air move [mm] crossed in one update.
+     * Unlimited by default, real time playback keeps it at feed rate.
+     */
+    void max_air_distance(float distance){max_air_distance_ = distance;}
+
     int current_instruction(){return current_intruction_;}
     CutterStatus last_status(){return last_status_;}
 
     float GetProgress();
 
     void Update(MaterialBox* material_box, float t_delta);
+    /**
+     * Moves and cuts height map only, render object is optional.
+     */
+    void Update(HeightMap* height_map,
+                const MaterialBoxDimensions& dimensions, float t_delta);
     bool Finished();
+    /**
+     * Cutter reached the end of the current instruction.
+     */
+    bool InstructionFinished();
+    /**
+     * Moves cutter to the start of the instruction, without cutting.
+     */
+    void Seek(int instruction);
 
     /**
      * Saves cutter to file as set of instructions.
@@ -80,10 +99,16 @@ public:
                                  float diameter);
 
 private:
-    CutterStatus CheckErrors(MaterialBox* material_box);
+    CutterStatus CheckErrors(const MaterialBoxDimensions& dimensions);
 
     void MaybeChangeInstruction();
     void ChangeInstruction();
+    /**
+     * Part of the current instruction above stock within cutter reach,
+     * from its start or to its end, z changes linearly along it.
+     */
+    void FindAirMove(HeightMap* height_map,
+                     const MaterialBoxDimensions& dimensions);
 
     void UpdateT(float t_delta);
     void ComputeCurrentPosition();
@@ -101,6 +126,10 @@ private:
 
     int current_intruction_;
     InstructionVectorEquation current_vector_equation_;
+    // [t] range of the current instruction that does not cut.
+    float air_t_begin_;
+    float air_t_end_;
+    float max_air_distance_;
     // position of the edge of cutter.
     glm::vec3 current_position_;
 
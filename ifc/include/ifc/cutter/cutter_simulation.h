@@ -3,6 +3,7 @@
 
 #include <vr/simulation.h>
 #include <ifc/cutter/cutter.h>
+#include <ifc/cutter/machining_time.h>
 #include <ifc/material/material_box.h>
 #include <rendering/scene/scene.h>
 
@@ -10,6 +11,9 @@
 
 namespace ifc {
 
+class SimulationTimeline;
+class HeightUndoLog;
+
 struct Trajectory {
     std::shared_ptr<ifx::RenderObject> view;
     std::vector<glm::vec3> positions;
@@ -24,31 +28,91 @@ public:
     std::shared_ptr<MaterialBox> material_box(){return material_box_;}
     std::shared_ptr<Cutter> cutter(){return cutter_;}
 
-    float* time_delta_ptr(){return &time_delta_;}
+    float* speed_ptr(){return &speed_;}
+    float* frame_budget_ms_ptr(){return &frame_budget_ms_;}
     float* line_delta_ptr(){return &line_delta_;}
 
-    float time_delta() {return time_delta_;}
-    float time_delta(float t) {time_delta_ = t;}
+    float speed(){return speed_;}
+    void speed(float speed){speed_ = speed;}
+
+    float frame_budget_ms(){return frame_budget_ms_;}
+    void frame_budget_ms(float budget){frame_budget_ms_ = budget;}
 
     float line_delta(){return line_delta_;}
     void line_delta(float d){line_delta_ = d;}
 
     float total_time_s(){return total_time_s_;}
+    float machine_time_s(){return machine_time_s_;}
 
     bool show_trajectory();
     void show_trajectory(bool v);
 
     void SetMaterialBox(std::shared_ptr<MaterialBox> material_box);
     void SetCutter(std::shared_ptr<Cutter> cutter);
-
+    /**
+     * Replaces cutter with a changed version of its program.
+     * Stock is restored from the last keyframe before the first changed
+     * instruction and re-simulated up to where the previous program was.
+     * Different tool resets the simulation, as SetCutter.
+     */
+    void ReloadCutter(std::shared_ptr<Cutter> cutter);
+
+    /**
+     * Advances machine time by frame time * speed, moving at feed rates
+     * of instructions. Steps stop when frame budget is used up,
+     * then the rest of machine time is dropped.
+     */
     void Update() override;
     bool CanUpdate();
 
     void UpdateAllAtOnce();
+    /**
+     * Runs to the end within frame budget, without blocking frames.
+     */
+    void FastForward();
+
+    /**
+     * Restores stock of the closest keyframe before the instruction
+     * and replays the program from there, without rendering.
+     * Seeking forward continues from the current instruction.
+     */
+    void Seek(int instruction);
+
+    /**
+     * Cuts the rest of the current instruction.
+     */
+    void StepForward();
+    /**
+     * Restores stock from before the current (or last finished)
+     * instruction and moves cutter to its start.
+     */
+    void StepBack();
 private:
     void Reset();
 
-    bool SatisfiesTimeDelta();
+    /**
+     * Cuts up to the instruction without rendering.
+     */
+    void Replay(int instruction);
+
+    /**
+     * Wall time since the last frame [s].
+     */
+    float FrameTime();
+    /**
+     * Steps until machine time is used or frame budget runs out.
+     * Returns true if cutter moved.
+     */
+    bool Advance();
+    /**
+     * Feed rate of the move starting at the instruction [mm/s].
+     */
+    float FeedRate(int instruction);
+    /**
+     * Machine time of instructions up to the cutter position,
+     * after it was moved other than by Update.
+     */
+    void UpdateMachineTime();
 
     void UpdateTrajectory();
     void UpdateTrajectoryView();
@@ -58,16 +122,30 @@ private:
 
     std::shared_ptr<ifx::Scene> scene_;
 
-    float time_delta_;
     float current_update_time_;
     float last_update_time_;
     float total_time_s_;
 
+    // Machine time per wall time.
+    float speed_;
+    // CPU time of steps per frame [ms].
+    float frame_budget_ms_;
+    const MachiningFeedRates feed_rates_;
+    double machine_time_s_;
+    // Machine time not stepped yet, negative after an overshoot.
+    double pending_time_s_;
+    bool fast_forward_;
+
     float line_delta_;
 
     CutterStatus status;
 
     Trajectory trajectory_;
+
+    // Stock keyframes of the current cutter.
+    std::unique_ptr<SimulationTimeline> timeline_;
+    // Heights overwritten by the cutter, for stepping back.
+    std::unique_ptr<HeightUndoLog> undo_log_;
 };
 }
 
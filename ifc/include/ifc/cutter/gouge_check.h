@@ -0,0 +1,51 @@
+#ifndef PROJECT_GOUGE_CHECK_H
+#define PROJECT_GOUGE_CHECK_H
+
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/instruction.h>
+
+#include <vector>
+
+namespace ifc {
+
+class DistanceField;
+
+/**
+ * Depth in millimeters, first_gouge_instruction is -1 if there is none.
+ */
+struct GougeReport{
+    int position_count;
+    int gouge_count;
+    float max_depth;
+    int first_gouge_instruction;
+};
+
+/**
+ * Number of points on a circle of radius, so that the circle is
+ * no further than tolerance from the polygon through them.
+ */
+int RingSamples(float radius, float tolerance);
+
+/**
+ * Distance [mm] between cutter at tip position and the model,
+ * negative if it cuts into the model. Saturates at the band of the field.
+ * Sphere: distance of the center minus radius.
+ * Flat: smallest distance of the bottom face: center, rim and an interior
+ * ring sampled for tolerance [mm], refined along -gradient of the field.
+ */
+float ToolClearance(const DistanceField& distance_field,
+                    CutterType type, float radius, const glm::vec3& tip,
+                    float tolerance = 0.05f);
+
+/**
+ * Samples tool positions along instructions, step [mm] apart,
+ * and counts those cutting into the model deeper than tolerance [mm].
+ */
+GougeReport CheckGouges(const DistanceField& distance_field,
+                        CutterType type, float radius,
+                        const std::vector<Instruction>& instructions,
+                        float step = 0.5f, float tolerance = 0.05f);
+
+}
+
+#endif //PROJECT_GOUGE_CHECK_H
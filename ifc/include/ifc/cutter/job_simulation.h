@@ -0,0 +1,118 @@
+#ifndef PROJECT_JOB_SIMULATION_H
+#define PROJECT_JOB_SIMULATION_H
+
+#include <ifc/cutter/batch_simulation.h>
+#include <ifc/cutter/cutter.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ifc {
+
+class StockSnapshot;
+
+/**
+ * Result of a single program of the job.
+ * status - FINISHED, error that stopped the program,
+ *          or NONE if the program was not run.
+ * removed_volume [mm^3], simulation_ms - time spent simulating,
+ * machining_time_s - estimated time on the machine.
+ */
+struct ToolReport{
+    std::string program;
+    CutterType type;
+    float diameter;
+    CutterStatus status;
+    int error_instruction;
+    float removed_volume;
+    double simulation_ms;
+    float machining_time_s;
+};
+
+/**
+ * Runs programs of a job one after another on the same stock,
+ * as the machine would with tool changes in between.
+ * Job stops at the first program with an error.
+ *
+ * Cutters are applied with stencils: cells around the tip the cutter
+ * may cover, precomputed for each tool and for STENCIL_SUBDIVISIONS^2
+ * sub cells of the tip inside a cell. Heights of the cutter bottom are
+ * computed from the exact position of the tip.
+ * Stencils are kept between programs and jobs.
+ */
+class JobSimulation {
+public:
+
+    JobSimulation(MaterialBoxCreateParams params);
+    /**
+     * Starts from stock of previous operations.
+     */
+    JobSimulation(const StockSnapshot& snapshot);
+    ~JobSimulation();
+
+    HeightMap* height_map(){return simulation_.height_map();}
+    std::shared_ptr<StockSnapshot> Snapshot(){return simulation_.Snapshot();}
+    /**
+     * Replaces stock, keeping stencils of previous jobs.
+     * Snapshot has to be of the same material box.
+     */
+    bool Restore(const StockSnapshot& snapshot);
+
+    /**
+     * Program paths, one per line. Empty lines and lines starting
+     * with # are skipped.
+     */
+    static std::vector<std::string> LoadJob(std::string filename);
+
+    /**
+     * Cutter type and diameter come from the extension of each program,
+     * as in CutterLoader.
+     */
+    std::vector<ToolReport> Run(const std::vector<std::string>& programs);
+    ToolReport Run(std::shared_ptr<Cutter> cutter, std::string program);
+
+    static void PrintReport(const std::vector<ToolReport>& reports);
+
+private:
+    // Cell (i + di, j + dj) of the tip in cell (i, j).
+    struct StencilCell{
+        int di;
+        int dj;
+    };
+    typedef std::vector<StencilCell> Stencil;
+
+    /**
+     * Stencils for all sub cells of the tip. Each holds the cells
+     * closer than radius to some point of its sub cell.
+     */
+    const std::vector<Stencil>& GetStencils(CutterType type,
+                                            float diameter);
+
+    CutterStatus CheckErrors(CutterType type, const glm::vec3& start,
+                             const glm::vec3& end, const glm::vec3& tip);
+    void Cut(const std::vector<Stencil>& stencils,
+             CutterType type, float radius, const glm::vec3& tip);
+
+    float StockVolume();
+
+    BatchSimulation simulation_;
+    const MaterialBoxDimensions dimensions_;
+
+    // Cell (0, 0) and distance between cells [mm].
+    glm::vec2 origin_;
+    glm::vec2 spacing_;
+    int width_;
+    int height_;
+
+    std::map<std::pair<CutterType, float>, std::vector<Stencil>> stencils_;
+
+    static const int STENCIL_SUBDIVISIONS = 4;
+    // As in Cutter.
+    const float max_depth_tolerance_ = 1.0f;
+};
+}
+
+#endif //PROJECT_JOB_SIMULATION_H
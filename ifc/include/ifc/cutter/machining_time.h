@@ -0,0 +1,39 @@
+#ifndef PROJECT_MACHINING_TIME_H
+#define PROJECT_MACHINING_TIME_H
+
+#include <ifc/cutter/instruction.h>
+
+#include <vector>
+
+namespace ifc {
+
+/**
+ * Feed rates in mm/min.
+ */
+struct MachiningFeedRates{
+    float normal;
+    float fast;
+};
+
+const MachiningFeedRates DEFAULT_FEED_RATES{1200.0f, 6000.0f};
+
+/**
+ * Distances in millimeters, time in seconds.
+ */
+struct MachiningTimeEstimate{
+    float normal_distance;
+    float fast_distance;
+    float time_s;
+};
+
+/**
+ * Estimates time needed to execute instructions.
+ * Move to instruction k uses speed mode of instruction k.
+ */
+MachiningTimeEstimate EstimateMachiningTime(
+        const std::vector<Instruction>& instructions,
+        const MachiningFeedRates& feed_rates = DEFAULT_FEED_RATES);
+
+}
+
+#endif //PROJECT_MACHINING_TIME_H
@@ -0,0 +1,108 @@
+#ifndef PROJECT_PROGRAM_VERIFIER_H
+#define PROJECT_PROGRAM_VERIFIER_H
+
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/instruction.h>
+#include <ifc/material/material_box.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+class DistanceField;
+class HeightMap;
+class ThreadPool;
+
+/**
+ * GOUGE               - cutter cuts into the model.
+ * FLAT_PLUNGE         - flat cutter moves straight down into the stock.
+ * RAPID_THROUGH_STOCK - FAST move below the stock.
+ * MAX_DEPTH           - cutter below maximum depth of the material box.
+ */
+enum class ProgramIssueType{
+    GOUGE, FLAT_PLUNGE, RAPID_THROUGH_STOCK, MAX_DEPTH
+};
+
+std::string ToString(ProgramIssueType type);
+
+/**
+ * Move ending at the instruction, value is the worst depth [mm]
+ * of the violation along the move.
+ */
+struct ProgramIssue{
+    ProgramIssueType type;
+    int instruction_id;
+    float value;
+};
+
+/**
+ * Clearance [mm] of each move from the model, the smallest
+ * along the move; negative is a gouge.
+ * Move i ends at instruction i, move 0 is the starting position.
+ */
+struct ProgramVerification{
+    std::vector<ProgramIssue> issues;
+    std::vector<float> clearances;
+    float min_clearance;
+    int min_clearance_instruction_id;
+};
+
+/**
+ * Checks a whole program without simulating it, moves are verified
+ * in parallel. Positions are sampled along each move, step [mm] apart.
+ *
+ * Stock is taken from the height map as it was before the program,
+ * or is the full material box if there is none.
+ * Material removed by the program itself is not taken into account,
+ * so stock related issues are conservative.
+ */
+class ProgramVerifier {
+public:
+
+    ProgramVerifier(std::shared_ptr<DistanceField> distance_field,
+                    const MaterialBoxDimensions& dimensions,
+                    HeightMap* stock = nullptr);
+    ~ProgramVerifier();
+
+    ProgramVerification Verify(CutterType type, float diameter,
+                               const std::vector<Instruction>& instructions,
+                               ThreadPool& pool,
+                               int batch_size = 256) const;
+    ProgramVerification Verify(std::shared_ptr<Cutter> cutter,
+                               ThreadPool& pool) const;
+
+    /**
+     * Prints issue counts of each type and the first few issues.
+     */
+    void PrintReport(const ProgramVerification& verification) const;
+
+private:
+    struct MoveCheck{
+        float clearance;
+        std::vector<ProgramIssue> issues;
+    };
+
+    MoveCheck CheckMove(CutterType type, float radius,
+                        const std::vector<Instruction>& instructions,
+                        int index,
+                        const std::function<float(const glm::vec3&)>&
+                        stock_height) const;
+
+    bool InsideBox(const glm::vec3& position, float margin) const;
+
+    std::shared_ptr<DistanceField> distance_field_;
+    MaterialBoxDimensions dimensions_;
+    HeightMap* stock_;
+
+    const float step_ = 0.5f;
+    const float tolerance_ = 0.05f;
+    // As in Cutter.
+    const float max_depth_tolerance_ = 1.0f;
+    const int printed_issue_count_ = 10;
+};
+}
+
+#endif //PROJECT_PROGRAM_VERIFIER_H
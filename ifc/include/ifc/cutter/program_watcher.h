@@ -0,0 +1,61 @@
+#ifndef PROJECT_PROGRAM_WATCHER_H
+#define PROJECT_PROGRAM_WATCHER_H
+
+#include <ifc/cutter/instruction.h>
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+/**
+ * Index of the first instruction that differs in position or speed mode,
+ * or size of the shorter program if one is a prefix of the other.
+ * -1 if programs are the same.
+ */
+int FirstChangedInstruction(const std::vector<Instruction>& previous,
+                            const std::vector<Instruction>& current);
+
+/**
+ * Polls modification time and size of a program file.
+ * A change is reported once the file stops changing for one poll,
+ * so that a program still being written is not loaded.
+ */
+class ProgramWatcher {
+public:
+
+    ProgramWatcher(std::string filepath, float poll_interval_s = 0.5f);
+    ~ProgramWatcher();
+
+    const std::string& filepath(){return filepath_;}
+
+    /**
+     * True once after the file changed.
+     * Checks the file at most once per poll interval.
+     */
+    bool Changed();
+
+private:
+    struct FileState{
+        bool exists;
+        std::time_t modification_time;
+        long long size;
+
+        bool operator==(const FileState& other) const;
+        bool operator!=(const FileState& other) const;
+    };
+
+    FileState Stat();
+
+    const std::string filepath_;
+    const std::chrono::duration<float> poll_interval_;
+
+    std::chrono::steady_clock::time_point last_poll_;
+    FileState state_;
+    bool pending_;
+};
+}
+
+#endif //PROJECT_PROGRAM_WATCHER_H
@@ -0,0 +1,83 @@
+#ifndef PROJECT_SIMULATION_TIMELINE_H
+#define PROJECT_SIMULATION_TIMELINE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+
+/**
+ * Keyframes of the stock recorded while a program runs,
+ * so that any instruction can be reached by restoring the closest
+ * keyframe before it and replaying only the rest.
+ *
+ * Keyframes are recorded at least interval instructions apart.
+ * Each one holds the cells changed since the previous keyframe,
+ * or the whole stock if more than a quarter of cells changed.
+ * When keyframes use more than memory budget [bytes], every second one
+ * is merged into the next one and the interval doubles.
+ */
+class SimulationTimeline {
+public:
+
+    /**
+     * Current stock is the keyframe of instruction 0.
+     */
+    SimulationTimeline(HeightMap* height_map,
+                       size_t memory_budget = 64 << 20,
+                       int interval = 256);
+    ~SimulationTimeline();
+
+    int keyframe_count(){return keyframes_.size();}
+    size_t memory_usage(){return memory_usage_;}
+    int interval(){return interval_;}
+
+    /**
+     * Records stock of the instruction if it is at least interval
+     * after the last keyframe.
+     */
+    void Record(int instruction, HeightMap* height_map);
+
+    /**
+     * Restores stock of the last keyframe at or before the instruction.
+     * Returns instruction of that keyframe.
+     */
+    int Restore(int instruction, HeightMap* height_map);
+
+    /**
+     * Restores like Restore and drops later keyframes,
+     * recording continues from the restored one.
+     * Used when the program changed after the instruction.
+     */
+    int Rewind(int instruction, HeightMap* height_map);
+
+private:
+    struct Keyframe{
+        int instruction;
+        bool full;
+        // Only for sparse keyframes, heights of whole stock otherwise.
+        std::vector<int> cells;
+        std::vector<float> heights;
+    };
+
+    size_t Size(const Keyframe& keyframe);
+
+    /**
+     * Merges sparse keyframe into the next one, later heights win.
+     */
+    void Merge(const Keyframe& keyframe, Keyframe& next);
+    void Thin();
+
+    std::vector<Keyframe> keyframes_;
+    // Stock of the last keyframe, not counted in memory usage.
+    std::vector<float> last_heights_;
+
+    const size_t memory_budget_;
+    size_t memory_usage_;
+    int interval_;
+};
+}
+
+#endif //PROJECT_SIMULATION_TIMELINE_H
@@ -0,0 +1,96 @@
+#ifndef PROJECT_DISTANCE_FIELD_H
+#define PROJECT_DISTANCE_FIELD_H
+
+#include <ifc/geometry/triangle_bvh.h>
+
+#include <math/math_ifx.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+class ThreadPool;
+
+/**
+ * Sparse narrow band signed distance field of a triangulated model.
+ * Negative below the top of the model (as seen by 3-axis cutter),
+ * positive above it.
+ *
+ * Distances are sampled in bricks of 8x8x8 cells, stored only
+ * within band of some triangle. Lookups are trilinear inside one brick,
+ * outside of the band they return +-band.
+ * Positions in millimeters, z is the height.
+ */
+class DistanceField {
+public:
+
+    DistanceField(const std::vector<Triangle>& triangles,
+                  float cell_size, float band, ThreadPool& pool);
+    ~DistanceField();
+
+    /**
+     * Loads field from cache_prefix<hash>.sdf,
+     * builds and saves it if triangles or parameters have changed.
+     */
+    static std::shared_ptr<DistanceField> LoadOrBuild(
+            const std::vector<Triangle>& triangles,
+            float cell_size, float band, ThreadPool& pool,
+            std::string cache_prefix = "distance_field_");
+
+    float cell_size() const {return cell_size_;}
+    float band() const {return band_;}
+    int brick_count() const {return values_.size() / BRICK_NODE_COUNT;}
+
+    float Distance(const glm::vec3& position) const;
+    /**
+     * Central differences, cell_size / 2 apart.
+     */
+    glm::vec3 Gradient(const glm::vec3& position) const;
+
+    bool Save(std::string filename) const;
+
+private:
+    static const int BRICK_CELLS = 8;
+    static const int BRICK_NODES = BRICK_CELLS + 1;
+    static const int BRICK_NODE_COUNT = BRICK_NODES * BRICK_NODES
+                                        * BRICK_NODES;
+
+    DistanceField();
+    bool Load(std::string filename);
+
+    void ComputeTopHeights(const TriangleBVH& bvh);
+    void ComputeBrick(const TriangleBVH& bvh, int brick, int bx, int by,
+                      int bz);
+
+    /**
+     * Height of the highest triangle at (x, y), -FLT_MAX if none.
+     */
+    float TopHeight(const TriangleBVH& bvh, const glm::vec2& position);
+    /**
+     * Top height at the closest sampled (x, y).
+     */
+    float GetTopHeight(const glm::vec3& position) const;
+
+    static std::uint64_t Hash(const std::vector<Triangle>& triangles,
+                              float cell_size, float band);
+
+    float cell_size_;
+    float band_;
+    glm::vec3 origin_;
+
+    // Bricks along x, y, z.
+    int brick_counts_[3];
+    // Index of brick in values_, -1 if brick is outside of the band.
+    std::vector<int> bricks_;
+    std::vector<float> values_;
+
+    // Nodes along x, y.
+    int top_counts_[2];
+    std::vector<float> top_heights_;
+};
+}
+
+#endif //PROJECT_DISTANCE_FIELD_H
@@ -0,0 +1,132 @@
+#ifndef PROJECT_PATCH_BVH_H
+#define PROJECT_PATCH_BVH_H
+
+#include <math/math_ifx.h>
+
+#include <cfloat>
+#include <utility>
+#include <vector>
+
+class Surface;
+
+namespace ifc {
+
+/**
+ * Axis aligned bounding box.
+ */
+struct AABB{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    static AABB Empty();
+
+    void Expand(const glm::vec3& point);
+    void Expand(const AABB& box);
+    bool Overlaps(const AABB& box) const;
+    AABB Intersection(const AABB& box) const;
+    glm::vec3 Center() const;
+    int LongestAxis() const;
+};
+
+/**
+ * Point of a patch with its first and second derivatives.
+ */
+struct PatchPoint{
+    glm::vec3 point;
+    glm::vec3 du;
+    glm::vec3 dv;
+    glm::vec3 duu;
+    glm::vec3 duv;
+    glm::vec3 dvv;
+};
+
+/**
+ * Closest point of a surface, patch = -1 if none was found.
+ * params - u,v in [0,1] of the patch.
+ */
+struct PatchProjection{
+    int patch;
+    glm::vec2 params;
+    glm::vec3 point;
+    float distance;
+};
+
+/**
+ * Bounding volume hierarchy over bicubic bezier patches of a surface.
+ * Patch lies in the convex hull of its control points,
+ * so box of the control points bounds the patch.
+ */
+class PatchBVH {
+public:
+
+    PatchBVH(Surface* surface);
+    ~PatchBVH();
+
+    int patch_count(){return patches_.size();}
+    const AABB& bounds(int patch){return patches_[patch].bounds;}
+
+    /**
+     * u,v in [0,1] of the patch.
+     */
+    glm::vec3 Evaluate(int patch, float u, float v) const;
+    PatchPoint EvaluateDerivatives(int patch, float u, float v) const;
+
+    /**
+     * Closest point of the surface not further than max_distance.
+     * Patches are visited from the closest bounds, each is seeded
+     * from a coarse grid and refined with Newton iteration.
+     */
+    PatchProjection Project(const glm::vec3& point,
+                            float max_distance = FLT_MAX) const;
+
+    /**
+     * Pairs (patch of this, patch of other) with overlapping bounds.
+     */
+    std::vector<std::pair<int, int>> FindOverlaps(PatchBVH& other);
+
+private:
+    struct Patch{
+        glm::vec3 points[4][4];
+        AABB bounds;
+    };
+
+    /**
+     * Leaf holds patches [first, first + count) of patch_order_.
+     */
+    struct Node{
+        AABB bounds;
+        int left;
+        int right;
+        int first;
+        int count;
+    };
+
+    int Build(int first, int count);
+    void ProjectOnPatch(const glm::vec3& point, int patch,
+                        PatchProjection& projection) const;
+    void FindOverlaps(PatchBVH& other, int node, int other_node,
+                      std::vector<std::pair<int, int>>& overlaps);
+
+    std::vector<Patch> patches_;
+    std::vector<int> patch_order_;
+    std::vector<Node> nodes_;
+    // Seeds of projection, (seed_samples_ + 1)^2 points of each patch.
+    std::vector<glm::vec3> seeds_;
+
+    const int max_leaf_size_ = 2;
+    const int seed_samples_ = 4;
+    const int newton_iterations_ = 8;
+};
+
+/**
+ * One seed (world space) for each connected group of overlapping patches,
+ * placed in the middle of the closest pair of points of the two surfaces
+ * in that group. Groups where surfaces are further apart than tolerance
+ * are skipped.
+ */
+std::vector<glm::vec3> FindIntersectionSeeds(PatchBVH& bvh1, PatchBVH& bvh2,
+                                             float tolerance = 1e-3f);
+
+}
+
+#endif //PROJECT_PATCH_BVH_H
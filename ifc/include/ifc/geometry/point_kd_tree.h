@@ -0,0 +1,76 @@
+#ifndef PROJECT_POINT_KD_TREE_H
+#define PROJECT_POINT_KD_TREE_H
+
+#include <math/math_ifx.h>
+
+#include <vector>
+
+namespace ifc {
+
+/**
+ * Static k-d tree over 3D points.
+ * Nodes are stored implicitly: median of range [first, last) is the node,
+ * left and right halves are its subtrees.
+ */
+class PointKDTree {
+public:
+
+    PointKDTree(const std::vector<glm::vec3>& points);
+    ~PointKDTree();
+
+    int size() const {return points_.size();}
+    const glm::vec3& point(int index) const {return points_[index];}
+
+    /**
+     * True if any point lies within radius (inclusive) of position.
+     */
+    bool HasPointWithin(const glm::vec3& position, float radius) const;
+
+    /**
+     * Indices of all points within radius (inclusive) of position.
+     */
+    std::vector<int> FindWithin(const glm::vec3& position, float radius) const;
+
+    /**
+     * Index of the closest point, the smallest index on ties.
+     * -1 if tree is empty.
+     */
+    int FindNearest(const glm::vec3& position) const;
+
+private:
+    void Build(int first, int last);
+
+    bool HasPointWithin(int first, int last, const glm::vec3& position,
+                        float radius_squared) const;
+    void FindWithin(int first, int last, const glm::vec3& position,
+                    float radius_squared, std::vector<int>& found) const;
+    void FindNearest(int first, int last, const glm::vec3& position,
+                     int& nearest, float& nearest_distance_squared) const;
+
+    float DistanceSquared(int index, const glm::vec3& position) const;
+
+    std::vector<glm::vec3> points_;
+    // Point indices in tree order.
+    std::vector<int> order_;
+    // Split axis of node at each position of order_.
+    std::vector<int> axes_;
+};
+
+struct ClosestPair{
+    int index1;
+    int index2;
+    float distance;
+};
+
+/**
+ * Closest pair between points1 and points2[first2, last2).
+ * Indices refer to the full vectors. On ties the smallest index1,
+ * then the smallest index2 is returned.
+ * Both indices are -1 if either range is empty.
+ */
+ClosestPair FindClosestPair(const std::vector<glm::vec3>& points1,
+                            const std::vector<glm::vec3>& points2,
+                            int first2, int last2);
+}
+
+#endif //PROJECT_POINT_KD_TREE_H
@@ -0,0 +1,56 @@
+#ifndef PROJECT_SURFACE_PROJECTOR_H
+#define PROJECT_SURFACE_PROJECTOR_H
+
+#include <ifc/geometry/patch_bvh.h>
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <vector>
+
+class Surface;
+
+namespace ifc {
+
+class ThreadPool;
+
+/**
+ * Closest point over all surfaces, surface = -1 if none was found.
+ * patch, params - as in PatchProjection.
+ */
+struct SurfaceProjection{
+    int surface;
+    int patch;
+    glm::vec2 params;
+    glm::vec3 point;
+    float distance;
+};
+
+/**
+ * Projects points onto a set of surfaces (closest point).
+ * Surfaces are indexed by PatchBVH each, in the same space
+ * as surface control points (i.e. Surface::compute).
+ */
+class SurfaceProjector {
+public:
+
+    SurfaceProjector(const std::vector<Surface*>& surfaces);
+    ~SurfaceProjector();
+
+    int surface_count(){return bvhs_.size();}
+
+    SurfaceProjection Project(const glm::vec3& point) const;
+
+    /**
+     * Projections of all points, batches are computed on the pool.
+     */
+    std::vector<SurfaceProjection> Project(
+            const std::vector<glm::vec3>& points,
+            ThreadPool& pool, int batch_size = 4096) const;
+
+private:
+    std::vector<std::unique_ptr<PatchBVH>> bvhs_;
+};
+}
+
+#endif //PROJECT_SURFACE_PROJECTOR_H
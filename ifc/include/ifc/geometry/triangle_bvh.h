@@ -0,0 +1,71 @@
+#ifndef PROJECT_TRIANGLE_BVH_H
+#define PROJECT_TRIANGLE_BVH_H
+
+#include <ifc/geometry/patch_bvh.h>
+
+#include <math/math_ifx.h>
+
+#include <vector>
+
+namespace ifc {
+
+struct Triangle{
+    glm::vec3 vertices[3];
+};
+
+/**
+ * Point of the triangle closest to the point.
+ */
+glm::vec3 ClosestPoint(const Triangle& triangle, const glm::vec3& point);
+
+/**
+ * Bounding volume hierarchy over triangles, for vertical queries:
+ * triangles are found by (x, y) box, z is the height.
+ */
+class TriangleBVH {
+public:
+
+    TriangleBVH(const std::vector<Triangle>& triangles);
+    ~TriangleBVH();
+
+    int triangle_count() const {return triangles_.size();}
+    const Triangle& triangle(int i) const {return triangles_[i];}
+    const AABB& bounds(int i) const {return bounds_[i];}
+
+    /**
+     * Triangles with (x, y) bounds overlapping box [min, max],
+     * reaching at least min_height.
+     */
+    void FindTriangles(const glm::vec2& min, const glm::vec2& max,
+                       float min_height, std::vector<int>& triangles) const;
+
+    /**
+     * Triangles with bounds overlapping the box.
+     */
+    void FindTriangles(const AABB& box, std::vector<int>& triangles) const;
+
+private:
+    /**
+     * Leaf holds triangles [first, first + count) of triangle_order_.
+     */
+    struct Node{
+        AABB bounds;
+        int left;
+        int right;
+        int first;
+        int count;
+    };
+
+    int Build(int first, int count);
+
+    std::vector<Triangle> triangles_;
+    std::vector<AABB> bounds_;
+    std::vector<int> triangle_order_;
+    std::vector<Node> nodes_;
+
+    const int max_leaf_size_ = 4;
+};
+
+}
+
+#endif //PROJECT_TRIANGLE_BVH_H
@@ -2,6 +2,8 @@
 #define PROJECT_PATH_GENERATION_GUI_H
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace ifx{
 class Scene;
@@ -11,9 +13,12 @@ namespace ifc {
 
 struct CADModelLoaderResult;
 
+class Cutter;
 class CutterSimulation;
+class DeviationMap;
 class MaterialBox;
 class PathGenerator;
+class IntersectionService;
 
 class PathGenerationGUI {
 public:
@@ -28,12 +33,21 @@ private:
     void RenderMainWindow();
     void RenderLoadModel();
     void RenderPathGeneration();
+    void RenderProgramVerification();
 
     void GenerateSignaturePath();
 
     std::shared_ptr<ifx::Scene> scene_;
     std::shared_ptr<CutterSimulation> simulation_;
     std::shared_ptr<PathGenerator> path_generator_;
+    // Outlives path generators, so that intersections are traced once.
+    std::shared_ptr<IntersectionService> intersection_service_;
+    // Cutters of the last Generate All, input of rest machining.
+    std::vector<std::shared_ptr<Cutter>> previous_cutters_;
+    // Issue counts of the last verified program.
+    std::vector<std::string> verification_summary_;
+    // Last deviation of Generate All paths from the model.
+    std::shared_ptr<DeviationMap> deviation_map_;
 
     std::shared_ptr<CADModelLoaderResult> cad_model_loader_result_;
 };
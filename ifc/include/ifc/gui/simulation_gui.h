@@ -4,6 +4,8 @@
 
 #include <ifc/material/material_box.h>
 #include <ifc/cutter/cutter_simulation.h>
+#include <ifc/cutter/job_simulation.h>
+#include <ifc/cutter/program_watcher.h>
 
 #include <memory>
 
@@ -40,11 +42,14 @@ private:
 
     void RenderCutterSection();
     void RenderLoadCutter();
+    void ReloadWatchedProgram();
     void RenderShowTrajectoryCutter();
+    void RenderJob();
 
     void RenderMaterialBoxSection();
     void RenderMaterialBoxDimensions();
     void RenderMaterialBoxPrecision();
+    void RenderStockSnapshot();
 
     void ResetSimulation();
 
@@ -66,6 +71,13 @@ private:
 
     std::shared_ptr<ifx::RenderObject> plane_;
     std::shared_ptr<CutterSimulation> simulation_;
+
+    // Kept between jobs, so that stencils of tools are reused.
+    std::unique_ptr<JobSimulation> job_simulation_;
+    std::vector<ToolReport> job_reports_;
+
+    // Set while the loaded program file is watched.
+    std::unique_ptr<ProgramWatcher> program_watcher_;
 };
 
 }
@@ -0,0 +1,108 @@
+#ifndef PROJECT_DEVIATION_MAP_H
+#define PROJECT_DEVIATION_MAP_H
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+class SurfaceProjector;
+class ThreadPool;
+struct HeightMapPath;
+
+/**
+ * Deviations in millimeters, max_gouge is positive.
+ * Cells outside of [-tolerance, tolerance] are counted as gouges
+ * or leftovers.
+ */
+struct DeviationSummary{
+    int cell_count;
+    int gouge_count;
+    int leftover_count;
+    float max_gouge;
+    float max_leftover;
+    float mean;
+    float rms;
+};
+
+/**
+ * Signed deviation [mm] of simulated stock from the target, per cell of
+ * the height map: positive is material left over, negative is a gouge.
+ * Cells are indexed as in HeightMap, its border cells (sides of the box)
+ * are not measured and have zero deviation.
+ *
+ * Histogram bins are histogram_bin_width() wide and cover
+ * [-histogram_range, histogram_range], deviations outside of it are
+ * counted in the first or the last bin.
+ */
+class DeviationMap {
+public:
+
+    /**
+     * Vertical deviation from target height map,
+     * both have to be created for the same material box.
+     */
+    DeviationMap(HeightMap* stock, std::shared_ptr<HeightMapPath> target,
+                 ThreadPool& pool, float tolerance = 0.05f);
+    ~DeviationMap();
+
+    int width() const {return width_;}
+    int height() const {return height_;}
+    const std::vector<float>& deviations() const {return deviations_;}
+    const DeviationSummary& summary() const {return summary_;}
+    const std::vector<int>& histogram() const {return histogram_;}
+    float histogram_bin_width() const {return histogram_bin_width_;}
+
+    float GetDeviation(int i, int j) const;
+
+    /**
+     * Replaces deviation of cells on the model (target above base height)
+     * with distance to the closest point of the surfaces, i.e. measured
+     * along the surface normal rather than vertically.
+     * Sign is kept from the vertical deviation.
+     */
+    void ProjectOnSurfaces(const SurfaceProjector& projector,
+                           float base_height, ThreadPool& pool);
+
+    /**
+     * filename.dev - binary grid of deviations,
+     * filename.json - summary and histogram.
+     */
+    bool Save(std::string filename) const;
+
+    void PrintSummary() const;
+
+private:
+    void ComputeSummary();
+
+    bool SaveGrid(std::string filename) const;
+    bool SaveSummary(std::string filename) const;
+
+    int width_;
+    int height_;
+    // Size of the stock [mm].
+    float width_mm_;
+    float height_mm_;
+    float tolerance_;
+
+    // Top of the stock in each cell [mm].
+    std::vector<glm::vec3> stock_points_;
+    std::vector<char> measured_;
+    std::vector<float> target_heights_;
+    std::vector<float> deviations_;
+
+    DeviationSummary summary_;
+    std::vector<int> histogram_;
+
+    const float histogram_range_ = 5.0f;
+    const float histogram_bin_width_ = 0.1f;
+    // Cells computed by a single task.
+    const int batch_size_ = 4096;
+};
+}
+
+#endif //PROJECT_DEVIATION_MAP_H
@@ -4,8 +4,13 @@
 #include <shaders/data/shader_data.h>
 #include <shaders/textures/texture.h>
 
+#include <memory>
+
 namespace ifc {
 
+class HeightUndoLog;
+class HeightPyramid;
+
 struct HeightMapTextureData{
     std::shared_ptr<ifx::Texture2D> texture;
     std::vector<float> data_;
@@ -26,9 +31,14 @@ struct PositionInfo{
 class HeightMap {
 public:
 
+    /**
+     * Without texture, height map can be used outside of GL context
+     * (e.g. in BatchSimulation). Update() does nothing then.
+     */
     HeightMap(int width, int height,
               float width_mm, float height_mm,
-              float max_height);
+              float max_height,
+              bool create_texture = true);
     ~HeightMap();
 
     HeightMapTextureData* texture_data(){return &texture_data_;}
@@ -41,6 +51,27 @@ public:
     void position_info(PositionInfo position_info){
         position_info_ = position_info;
     }
+    /**
+     * Heights overwritten by SetHeight are recorded in the log,
+     * if there is one.
+     */
+    HeightUndoLog* undo_log(){return undo_log_;}
+    void undo_log(HeightUndoLog* undo_log){undo_log_ = undo_log;}
+
+    /**
+     * Max heights over blocks of cells, follows SetHeight.
+     */
+    HeightPyramid* pyramid(){return pyramid_.get();}
+    /**
+     * Has to be called after heights() are written directly.
+     */
+    void HeightsChanged();
+
+    /**
+     * Positions and position info of box centered at origin,
+     * same as set by MaterialBoxFactory.
+     */
+    void InitPositions(float width_mm, float height_mm);
 
     float row_width(){return row_width_;}
     float column_width(){return column_width_;}
@@ -53,6 +84,10 @@ public:
 
     float GetHeight(int i);
     bool SetHeight(int i, float height);
+    /**
+     * Border cells are kept at zero height to render sides of the box.
+     */
+    bool IsBorder(int i);
     void Update();
 
 private:
@@ -67,6 +102,9 @@ private:
     std::vector<glm::vec2> positions_;
 
     PositionInfo position_info_;
+
+    HeightUndoLog* undo_log_;
+    std::unique_ptr<HeightPyramid> pyramid_;
 };
 }
 
@@ -0,0 +1,81 @@
+#ifndef PROJECT_HEIGHT_PYRAMID_H
+#define PROJECT_HEIGHT_PYRAMID_H
+
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+
+/**
+ * Max heights of a height map over blocks of cells, each level
+ * halves the previous one, the last level is the whole map.
+ * Max height of a rectangle of cells descends only into blocks
+ * that are partially covered and higher than max found so far.
+ *
+ * Lowered cells mark their block, marked blocks are refreshed before
+ * the next query. Until then their max is too high, which only makes
+ * queries conservative. Heights written directly (raised) require
+ * Invalidate, the pyramid is rebuilt then.
+ */
+class HeightPyramid {
+public:
+
+    HeightPyramid(HeightMap* height_map, int block_size = 8);
+    ~HeightPyramid();
+
+    int level_count(){return levels_.size();}
+
+    void MarkLowered(int cell){
+        if(!valid_)
+            return;
+        int j = cell / width_;
+        int block = (j / block_size_) * level_widths_[0]
+                    + (cell - j * width_) / block_size_;
+        if(!dirty_[block]){
+            dirty_[block] = true;
+            dirty_blocks_.push_back(block);
+        }
+    }
+    void Invalidate(){valid_ = false;}
+
+    /**
+     * Max height (GL) of cells in [i0, i1] x [j0, j1].
+     * Rectangle is clamped to the map, lowest float if nothing is left.
+     */
+    float MaxHeight(int i0, int j0, int i1, int j1);
+
+private:
+    struct Rectangle{
+        int i0;
+        int j0;
+        int i1;
+        int j1;
+    };
+
+    void Build();
+    void Refresh();
+    void ComputeBlock(int block);
+    void ComputeNode(int level, int node);
+
+    void MaxHeight(int level, int bi, int bj,
+                   const Rectangle& rectangle, float& max_height);
+
+    HeightMap* height_map_;
+
+    const int block_size_;
+    int width_;
+    int height_;
+
+    // levels_[0] over blocks of cells, levels_[l] over 2^l x 2^l blocks.
+    std::vector<std::vector<float>> levels_;
+    std::vector<int> level_widths_;
+    std::vector<int> level_heights_;
+
+    std::vector<bool> dirty_;
+    std::vector<int> dirty_blocks_;
+    bool valid_;
+};
+}
+
+#endif //PROJECT_HEIGHT_PYRAMID_H
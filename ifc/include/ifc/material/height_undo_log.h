@@ -0,0 +1,69 @@
+#ifndef PROJECT_HEIGHT_UNDO_LOG_H
+#define PROJECT_HEIGHT_UNDO_LOG_H
+
+#include <cstddef>
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+
+/**
+ * Heights overwritten in a height map, grouped in segments
+ * (moves of the cutter). Entries of all segments are kept in one array,
+ * undoing a segment writes them back in reverse order, so it costs about
+ * as much as cutting it.
+ *
+ * Above max_entries, the oldest half of segments is forgotten.
+ */
+class HeightUndoLog {
+public:
+
+    HeightUndoLog(size_t max_entries = 16 << 20);
+    ~HeightUndoLog();
+
+    int segment_count() const {return segments_.size();}
+    size_t entry_count() const {return entries_.size();}
+
+    /**
+     * Following heights belong to the segment of the instruction.
+     * Does nothing if it is already the current segment.
+     */
+    void BeginSegment(int instruction);
+
+    /**
+     * Height stored in height map (GL) before it is overwritten.
+     */
+    void Record(int cell, float previous_height){
+        if(!segments_.empty())
+            entries_.push_back(Entry{cell, previous_height});
+    }
+
+    /**
+     * Restores heights from before the last segment and removes it.
+     * Returns instruction of the segment, -1 if there is none.
+     */
+    int Undo(HeightMap* height_map);
+
+    void Clear();
+
+private:
+    struct Entry{
+        int cell;
+        float previous_height;
+    };
+    struct Segment{
+        int instruction;
+        size_t first_entry;
+    };
+
+    void Forget();
+
+    std::vector<Entry> entries_;
+    std::vector<Segment> segments_;
+
+    const size_t max_entries_;
+};
+}
+
+#endif //PROJECT_HEIGHT_UNDO_LOG_H
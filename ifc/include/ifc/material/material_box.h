@@ -11,6 +11,7 @@ namespace ifx{
 namespace ifc {
 
 class HeightMap;
+class StockSnapshot;
 
 /*
  * Diemensions in millimeters.
@@ -51,6 +52,12 @@ public:
 
     void Update();
 
+    std::shared_ptr<StockSnapshot> Snapshot();
+    /**
+     * Replaces stock with the snapshot of the same precision.
+     */
+    bool Restore(const StockSnapshot& snapshot);
+
 private:
     std::shared_ptr<ifx::RenderObject> box_render_object_;
     std::unique_ptr<HeightMap> height_map_;
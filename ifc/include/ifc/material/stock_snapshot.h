@@ -0,0 +1,61 @@
+#ifndef PROJECT_STOCK_SNAPSHOT_H
+#define PROJECT_STOCK_SNAPSHOT_H
+
+#include <ifc/material/material_box.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+
+/**
+ * State of the stock: parameters of the material box it was cut from
+ * and heights [mm], indexed as in HeightMap.
+ * Lets the next operation start from stock left by the previous ones
+ * instead of simulating them again.
+ */
+class StockSnapshot {
+public:
+
+    StockSnapshot(const MaterialBoxCreateParams& params,
+                  HeightMap* height_map);
+    ~StockSnapshot();
+
+    const MaterialBoxCreateParams& params() const {return params_;}
+    const std::vector<float>& heights() const {return heights_;}
+
+    /**
+     * Height map has to be of the same precision.
+     */
+    bool Restore(HeightMap* height_map) const;
+
+    /**
+     * Compressed heights are quantized to quantization [mm], delta coded
+     * along rows, varint coded and LZ compressed.
+     * Otherwise heights are stored as they are.
+     */
+    bool Save(std::string filename, bool compress = true,
+              float quantization = 0.001f) const;
+    /**
+     * Returns nullptr if file can not be read.
+     */
+    static std::shared_ptr<StockSnapshot> Load(std::string filename);
+
+    /**
+     * 16-bit grayscale PNG for inspection: 0 at the bottom of the box,
+     * 65535 at its top. Rows are along x.
+     */
+    bool ExportPNG(std::string filename) const;
+
+private:
+    StockSnapshot();
+
+    MaterialBoxCreateParams params_;
+    std::vector<float> heights_;
+};
+}
+
+#endif //PROJECT_STOCK_SNAPSHOT_H
@@ -0,0 +1,119 @@
+#ifndef PROJECT_TASK_GRAPH_H
+#define PROJECT_TASK_GRAPH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace ifc {
+
+class ThreadPool;
+
+/**
+ * POOL        - executed by any ThreadPool worker.
+ * MAIN_THREAD - executed by thread calling TaskGraph::Run,
+ *               e.g. tasks creating OpenGL objects.
+ */
+enum class TaskAffinity{
+    POOL, MAIN_THREAD
+};
+
+/**
+ * Times in milliseconds since TaskGraph::Run.
+ * critical_path - duration of the longest chain of dependencies
+ * ending with this task.
+ */
+struct TaskTiming{
+    std::string name;
+    double start;
+    double end;
+    double critical_path;
+    bool failed;
+};
+
+/**
+ * Directed acyclic graph of tasks.
+ * Task is started as soon as all its dependencies have finished.
+ * If task throws, all tasks depending on it are skipped.
+ */
+class TaskGraph {
+public:
+
+    TaskGraph();
+    ~TaskGraph();
+
+    /**
+     * Dependencies are ids returned by previous AddTask calls.
+     * Returns id of the task.
+     */
+    int AddTask(std::string name, std::function<void()> work,
+                const std::vector<int>& dependencies = std::vector<int>(),
+                TaskAffinity affinity = TaskAffinity::POOL);
+
+    /**
+     * Blocks until all tasks have finished.
+     */
+    void Run(ThreadPool& pool);
+
+    TaskTiming GetTiming(int task);
+    double wall_time(){return wall_time_;}
+
+    /**
+     * Prints timing of each task and the critical path of the graph.
+     */
+    void PrintReport();
+
+private:
+    enum class TaskStatus{
+        WAITING, FINISHED, FAILED
+    };
+
+    struct Task{
+        std::string name;
+        std::function<void()> work;
+        std::vector<int> dependencies;
+        std::vector<int> dependents;
+        TaskAffinity affinity;
+
+        int remaining_dependencies;
+        TaskStatus status;
+
+        double start;
+        double end;
+        double critical_path;
+        // Dependency on the critical path, -1 if none.
+        int critical_dependency;
+    };
+
+    /**
+     * Must be called with mutex_ locked.
+     */
+    void Schedule(int task, ThreadPool& pool);
+
+    void Execute(int task, ThreadPool& pool);
+
+    /**
+     * Must be called with mutex_ locked.
+     */
+    void Complete(int task, bool failed, ThreadPool& pool);
+
+    double Now();
+
+    std::vector<Task> tasks_;
+
+    std::queue<int> main_thread_tasks_;
+    int finished_count_;
+
+    std::chrono::steady_clock::time_point start_time_;
+    double wall_time_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+}
+
+#endif //PROJECT_TASK_GRAPH_H
@@ -0,0 +1,42 @@
+#ifndef PROJECT_THREAD_POOL_H
+#define PROJECT_THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ifc {
+
+/**
+ * Fixed number of worker threads executing submitted jobs in FIFO order.
+ * Destructor finishes all submitted jobs before joining workers.
+ */
+class ThreadPool {
+public:
+
+    /**
+     * thread_count = 0 uses std::thread::hardware_concurrency.
+     */
+    ThreadPool(unsigned int thread_count = 0);
+    ~ThreadPool();
+
+    unsigned int thread_count(){return workers_.size();}
+
+    void Submit(std::function<void()> job);
+
+private:
+    void Work();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool is_stopping_;
+};
+}
+
+#endif //PROJECT_THREAD_POOL_H
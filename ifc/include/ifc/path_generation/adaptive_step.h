@@ -0,0 +1,81 @@
+#ifndef PROJECT_ADAPTIVE_STEP_H
+#define PROJECT_ADAPTIVE_STEP_H
+
+#include <math/math_ifx.h>
+
+class Surface;
+
+namespace ifc {
+
+/**
+ * Distance between neighbouring passes of ball cutter [mm] leaving
+ * scallops of given height. Curvature [1/mm] is positive on convex
+ * surface, negative on concave.
+ * s = sqrt(8hR / (1 + kR))
+ */
+float ScallopStepOver(float scallop_height, float ball_radius,
+                      float curvature);
+
+/**
+ * Length of a linear move [mm] deviating from an arc of given
+ * curvature [1/mm] by at most chordal tolerance.
+ * l = sqrt(8t / |k|)
+ */
+float ChordalStep(float chordal_tolerance, float curvature);
+
+/**
+ * Parameter steps of ball cutter passes over a surface.
+ * Passes run along v, next pass is at u + step over.
+ * Cutter center is offset along normal: normal_sign * cross(dv, du).
+ *
+ * Curvature is estimated with central differences of derivatives
+ * inside [0, 1] parameter range.
+ * Steps are clamped to [min_step, max_step] in parameter space,
+ * x for step over (u), y for step along (v).
+ */
+class AdaptiveStep {
+public:
+
+    AdaptiveStep(Surface* surface,
+                 float ball_radius, float scallop_height,
+                 float chordal_tolerance,
+                 const glm::vec2& min_step, const glm::vec2& max_step,
+                 float normal_sign = 1.0f);
+    ~AdaptiveStep();
+
+    /**
+     * Step in u to the next pass, the smallest one along
+     * the pass [v_start, v_end].
+     */
+    float StepOver(float u, float v_start, float v_end);
+
+    /**
+     * Step in v to the next point of the pass.
+     */
+    float StepAlong(float u, float v);
+
+    /**
+     * Normal curvatures [1/mm] in u and v directions.
+     */
+    float CurvatureU(float u, float v);
+    float CurvatureV(float u, float v);
+
+private:
+    glm::vec3 Normal(float u, float v);
+    float Difference(float t, float& t0, float& t1);
+
+    Surface* surface_;
+
+    const float ball_radius_;
+    const float scallop_height_;
+    const float chordal_tolerance_;
+    const glm::vec2 min_step_;
+    const glm::vec2 max_step_;
+    const float normal_sign_;
+
+    const float difference_step_ = 1e-3f;
+    const int samples_per_pass_ = 16;
+};
+}
+
+#endif //PROJECT_ADAPTIVE_STEP_H
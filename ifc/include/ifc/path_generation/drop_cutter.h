@@ -0,0 +1,74 @@
+#ifndef PROJECT_DROP_CUTTER_H
+#define PROJECT_DROP_CUTTER_H
+
+#include <ifc/cutter/cutter.h>
+#include <ifc/geometry/triangle_bvh.h>
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct CADModelLoaderResult;
+class ThreadPool;
+
+/**
+ * Triangles of all CAD model surfaces, tessellation segments per patch
+ * edge. Millimeters, z is the height.
+ */
+std::vector<Triangle> TessellateModel(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        int tessellation);
+
+/**
+ * Tool compensated heights against the tessellated CAD model.
+ * For (x, y) returns the lowest tool tip height at which the cutter
+ * touches the model without gouging: the highest contact over facets,
+ * edges and vertices of triangles under the cutter.
+ * Never below floor height.
+ *
+ * Positions and heights in millimeters, z is the height.
+ * Exact for the triangles, the model itself is approximated
+ * by tessellation segments per patch edge.
+ */
+class DropCutter {
+public:
+
+    DropCutter(std::shared_ptr<CADModelLoaderResult> model_loader_result,
+               float floor_height, int tessellation = 8);
+    DropCutter(const std::vector<Triangle>& triangles, float floor_height);
+    ~DropCutter();
+
+    int triangle_count(){return bvh_->triangle_count();}
+    float floor_height(){return floor_height_;}
+
+    float Height(const glm::vec2& position,
+                 CutterType type, float radius) const;
+
+    /**
+     * Heights of all positions, batches are computed on the pool.
+     */
+    std::vector<float> Heights(const std::vector<glm::vec2>& positions,
+                               CutterType type, float radius,
+                               ThreadPool& pool, int batch_size = 1024) const;
+
+private:
+    /**
+     * Tip height of cutter touching the triangle,
+     * -FLT_MAX if cutter does not reach it.
+     */
+    float SphereHeight(const Triangle& triangle, const glm::vec2& position,
+                       float radius) const;
+    float FlatHeight(const Triangle& triangle, const glm::vec2& position,
+                     float radius) const;
+
+    bool IsInside(const Triangle& triangle, const glm::vec2& point) const;
+
+    std::unique_ptr<TriangleBVH> bvh_;
+    float floor_height_;
+};
+}
+
+#endif //PROJECT_DROP_CUTTER_H
@@ -0,0 +1,124 @@
+#ifndef PROJECT_INTERSECTION_SERVICE_H
+#define PROJECT_INTERSECTION_SERVICE_H
+
+#include <ifc/parallel/thread_pool.h>
+#include <math/math_ifx.h>
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Surface;
+struct TracePoint;
+
+namespace ifc {
+
+struct CADModelLoaderResult;
+class PatchBVH;
+
+/**
+ * Traces intersections of CAD model surfaces on thread pool.
+ * Surfaces are identified by their index in cad_model->surfaces,
+ * or INTERSECTION_SURFACE for the material box intersection rectangle.
+ *
+ * Starting points are found automatically, one for each component
+ * of the intersection, with PatchBVH of both surfaces.
+ * A hint (model space) given by the caller overrides them.
+ *
+ * Requests with the same surfaces, seed, model matrix and control points
+ * are traced only once. Results are kept in memory as long as the service
+ * lives and stored on disk as cache_prefix<hash>.trace.
+ */
+class IntersectionService {
+public:
+
+    IntersectionService(
+            std::shared_ptr<CADModelLoaderResult> model_loader_result,
+            std::string cache_prefix = "intersection_");
+    ~IntersectionService();
+
+    static const int INTERSECTION_SURFACE = -1;
+
+    std::shared_ptr<CADModelLoaderResult> model_loader_result(){
+        return model_loader_result_;}
+
+    /**
+     * Starts tracing from the hint if the intersection is not known yet.
+     * Returns immediately.
+     */
+    std::shared_future<std::vector<TracePoint>> Request(
+            int surface1, int surface2, const glm::vec3& hint);
+
+    /**
+     * Starts tracing all components of the intersection.
+     */
+    std::vector<std::shared_future<std::vector<TracePoint>>> RequestAll(
+            int surface1, int surface2);
+
+    /**
+     * Blocks until the intersection is traced.
+     */
+    std::vector<TracePoint> Trace(int surface1, int surface2,
+                                  const glm::vec3& hint);
+
+    /**
+     * Blocks until all components are traced.
+     * Empty traces and traces of an already traced component are dropped.
+     */
+    std::vector<std::vector<TracePoint>> TraceAll(int surface1, int surface2);
+
+    /**
+     * Starting points in world space, one for each component.
+     */
+    std::vector<glm::vec3> FindSeeds(int surface1, int surface2);
+
+private:
+    std::shared_future<std::vector<TracePoint>> RequestAt(
+            int surface1, int surface2, const glm::vec3& init_point);
+
+    Surface* GetSurface(int surface);
+    std::shared_ptr<PatchBVH> GetPatchBVH(int surface);
+
+    /**
+     * True if point lies on the traced polyline.
+     */
+    bool Contains(const std::vector<TracePoint>& trace_points,
+                  const glm::vec3& point);
+
+    std::vector<TracePoint> Compute(int surface1, int surface2,
+                                    const glm::vec3& init_point,
+                                    std::string filename);
+
+    bool Load(std::string filename, std::vector<TracePoint>& trace_points);
+    void Save(std::string filename,
+              const std::vector<TracePoint>& trace_points);
+
+    /**
+     * FNV-1a hash of control points of all surfaces.
+     */
+    std::uint64_t HashModel();
+    std::uint64_t Hash(std::uint64_t hash, const void* data, int size);
+
+    std::shared_ptr<CADModelLoaderResult> model_loader_result_;
+    std::string cache_prefix_;
+
+    std::uint64_t model_hash_;
+
+    std::map<std::uint64_t,
+            std::shared_future<std::vector<TracePoint>>> intersections_;
+    std::map<int, std::shared_ptr<PatchBVH>> patch_bvhs_;
+    std::map<std::pair<int, int>, std::vector<glm::vec3>> seeds_;
+    std::mutex mutex_;
+
+    // Destroyed first, so that running traces finish
+    // while the rest of the service is still valid.
+    ThreadPool pool_;
+};
+}
+
+#endif //PROJECT_INTERSECTION_SERVICE_H
@@ -0,0 +1,106 @@
+#ifndef PROJECT_LINK_OPTIMIZER_H
+#define PROJECT_LINK_OPTIMIZER_H
+
+#include <ifc/cutter/instruction.h>
+
+#include <math/math_ifx.h>
+
+#include <vector>
+
+namespace ifc {
+
+class HeightMap;
+
+/**
+ * Cutting moves executed without interruption.
+ * Positions in millimeters, as in instructions.
+ */
+struct LinkPass{
+    std::vector<glm::vec3> positions;
+    // Pass can be cut from the last position to the first one.
+    bool reversible;
+};
+
+/**
+ * Length of links between passes [mm]: retract, traverse and plunge.
+ * Baseline links retract to the safe plane, in the original order.
+ */
+struct LinkReport{
+    float baseline_link_distance;
+    float link_distance;
+};
+
+/**
+ * Orders passes and their directions to shorten rapid moves between them.
+ * Order is found by nearest neighbour, improved with 2-opt.
+ *
+ * Rapid moves retract only to the clearance height: the highest stock
+ * within cutter radius along the move, plus safety margin.
+ * Stock is copied from height map on construction.
+ */
+class LinkOptimizer {
+public:
+
+    LinkOptimizer(HeightMap* stock, float cutter_radius,
+                  float safety_margin = 3.0f);
+    ~LinkOptimizer();
+
+    const LinkReport& report() const {return report_;}
+
+    /**
+     * Program starting and ending at start position,
+     * which should lie on the safe plane.
+     * Links are FAST, plunges into passes are NORMAL.
+     */
+    std::vector<Instruction> Link(const std::vector<LinkPass>& passes,
+                                  const glm::vec3& start, int& id);
+
+    /**
+     * Lowest safe height of a rapid move from a to b (x, y).
+     */
+    float Clearance(const glm::vec3& a, const glm::vec3& b) const;
+
+private:
+    struct LinkedPass{
+        int pass;
+        bool reversed;
+    };
+
+    std::vector<LinkedPass> FindOrder(const std::vector<LinkPass>& passes,
+                                      const glm::vec3& start);
+    void ImproveOrder(const std::vector<LinkPass>& passes,
+                      const glm::vec3& start,
+                      std::vector<LinkedPass>& order);
+
+    const glm::vec3& Entry(const std::vector<LinkPass>& passes,
+                           const LinkedPass& linked_pass);
+    const glm::vec3& Exit(const std::vector<LinkPass>& passes,
+                          const LinkedPass& linked_pass);
+
+    /**
+     * Adds moves from a to b, returns their length.
+     */
+    float AddLink(std::vector<Instruction>& instructions,
+                  const glm::vec3& a, const glm::vec3& b, int& id);
+
+    float SafePlaneLinkDistance(const glm::vec3& a, const glm::vec3& b,
+                                float safe_height);
+
+    void DilateStock(int radius_i, int radius_j);
+    float StockHeight(const glm::vec2& position) const;
+
+    const float cutter_radius_;
+    const float safety_margin_;
+
+    // Stock heights raised to the highest one within cutter radius [mm].
+    std::vector<float> heights_;
+    int width_;
+    int height_;
+    glm::vec2 origin_;
+    glm::vec2 spacing_;
+
+    LinkReport report_;
+};
+}
+
+#endif //PROJECT_LINK_OPTIMIZER_H
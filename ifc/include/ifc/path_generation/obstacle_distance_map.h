@@ -0,0 +1,60 @@
+#ifndef PROJECT_OBSTACLE_DISTANCE_MAP_H
+#define PROJECT_OBSTACLE_DISTANCE_MAP_H
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct HeightMapPath;
+
+/**
+ * Exact euclidean distance transform of obstacle mask of HeightMapPath.
+ * Obstacle is a cell above init_height.
+ * For each cell stores distance [mm] to the closest obstacle cell.
+ *
+ * Computed with two passes of lower envelope of parabolas
+ * (Felzenszwalb-Huttenlocher), linear in the number of cells.
+ */
+class ObstacleDistanceMap {
+public:
+
+    ObstacleDistanceMap(std::shared_ptr<HeightMapPath> height_map_path);
+    ~ObstacleDistanceMap();
+
+    int row_count(){return row_count_;}
+    int column_count(){return column_count_;}
+
+    /**
+     * Indices outside of the map are clamped to the border.
+     * If there are no obstacles, returns very large distance.
+     */
+    float GetDistance(int i, int j);
+
+    bool IsObstacle(int i, int j){return GetDistance(i, j) == 0.0f;}
+
+private:
+    /**
+     * Intersection of parabolas rooted at q and v.
+     */
+    float Intersection(const std::vector<float>& f, int q, int v,
+                       float spacing);
+
+    /**
+     * Squared distance transform of f sampled every spacing [mm].
+     */
+    void Transform1D(const std::vector<float>& f, float spacing,
+                     std::vector<float>& result);
+
+    int row_count_;
+    int column_count_;
+
+    std::vector<float> distances_;
+
+    // Work buffers of Transform1D.
+    std::vector<int> envelope_;
+    std::vector<float> boundaries_;
+};
+}
+
+#endif //PROJECT_OBSTACLE_DISTANCE_MAP_H
@@ -0,0 +1,67 @@
+#ifndef PROJECT_OFFSET_CURVE_H
+#define PROJECT_OFFSET_CURVE_H
+
+#include <math/math_ifx.h>
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Surface;
+struct TracePoint;
+
+namespace ifc {
+
+/**
+ * Intersection curve offset along normals of its two surfaces.
+ * Normals are evaluated once per trace point in the constructor,
+ * offsets are created on first request and kept for later ones.
+ *
+ * Normal of a surface is normalize(cross(dv, du)) at trace point params,
+ * multiplied by its sign. Surface1 uses params (x, y), surface2 (z, w).
+ * Surface2 may be null, its normals are zero then.
+ */
+class OffsetCurve {
+public:
+
+    OffsetCurve(const std::vector<TracePoint>& trace_points,
+                float radius,
+                std::shared_ptr<Surface> surface1, float normal_sign1 = 1.0f,
+                std::shared_ptr<Surface> surface2 = nullptr,
+                float normal_sign2 = 1.0f,
+                float min_height = -std::numeric_limits<float>::max());
+    ~OffsetCurve();
+
+    int size() const {return trace_points_.size();}
+    const std::vector<TracePoint>& trace_points() const {return trace_points_;}
+
+    /**
+     * Trace points moved by factor1 * radius along normal of surface1
+     * and factor2 * radius along normal of surface2.
+     * Height (y) is clamped to min_height.
+     */
+    const std::vector<TracePoint>& Offset(float factor1, float factor2 = 0.0f);
+
+    /**
+     * Single offset point, without creating the whole curve.
+     */
+    glm::vec3 OffsetPoint(int index, float factor1, float factor2 = 0.0f) const;
+
+private:
+    std::vector<glm::vec3> ComputeNormals(Surface* surface, float normal_sign,
+                                          bool use_second_params);
+
+    std::vector<TracePoint> trace_points_;
+    const float radius_;
+    const float min_height_;
+
+    std::vector<glm::vec3> normals1_;
+    std::vector<glm::vec3> normals2_;
+
+    std::map<std::pair<float, float>, std::vector<TracePoint>> offsets_;
+};
+}
+
+#endif //PROJECT_OFFSET_CURVE_H
@@ -6,6 +6,8 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 class SurfaceC2Cylind;
 
@@ -19,9 +21,14 @@ struct HeightMapPath;
 class Cutter;
 class MaterialBox;
 class RoughingPath;
+class ZLevelRoughingPath;
 class FlatAroundHMPath;
+class ContourFlatPath;
 class FlatAroundIntersectionPath;
 class ParametrizationPath;
+class RestMachiningPath;
+class IntersectionService;
+class DeviationMap;
 struct CADModelLoaderResult;
 
 /**
@@ -34,23 +41,70 @@ struct Paths{
     std::shared_ptr<Cutter> parametrization_cutter;
 };
 
+/**
+ * Files to which consecutive paths are saved, empty filename is skipped.
+ */
+struct PathFilenames{
+    std::string rough;
+    std::string flat_heighmap;
+    std::string flat_intersection;
+    std::string parametrization;
+};
+
 class PathGenerator {
 public:
 
     PathGenerator(std::shared_ptr<CADModelLoaderResult> result,
                   std::shared_ptr<MaterialBox> material_box,
-                  std::shared_ptr<ifx::Scene> scene);
+                  std::shared_ptr<ifx::Scene> scene,
+                  std::shared_ptr<IntersectionService> intersection_service);
     ~PathGenerator();
 
-    Paths GenerateAll();
+    /**
+     * Runs independent steps concurrently: roughing and flat heightmap
+     * on thread pool, intersection based steps on the calling thread
+     * (they create render objects).
+     * Each path is saved to file as soon as it is generated.
+     * Generated paths are checked for gouges against the model.
+     */
+    Paths GenerateAll(const PathFilenames& filenames);
     std::shared_ptr<Cutter> GenerateRoughingPath();
+    /**
+     * Reports estimated machining time against GenerateRoughingPath.
+     */
+    std::shared_ptr<Cutter> GenerateZLevelRoughingPath(float step_down);
     std::shared_ptr<Cutter> GenerateFlatHeightmapPath();
+    /**
+     * Reports estimated machining time against GenerateFlatHeightmapPath.
+     */
+    std::shared_ptr<Cutter> GenerateContourFlatPath();
     std::shared_ptr<Cutter> GenerateFlatIntersectionPath();
     std::shared_ptr<Cutter> GenerateParametrizationPath();
+    /**
+     * Cuts material left by previous cutters (e.g. from GenerateAll),
+     * found by simulating them on a copy of the material box.
+     */
+    std::shared_ptr<Cutter> GenerateRestMachiningPath(
+            const std::vector<std::shared_ptr<Cutter>>& previous_cutters);
+
+    /**
+     * Simulates cutters one after another without rendering and compares
+     * the stock with the model. Saved to filename.dev and filename.json,
+     * unless filename is empty.
+     */
+    std::shared_ptr<DeviationMap> GenerateDeviationMap(
+            const std::vector<std::shared_ptr<Cutter>>& cutters,
+            std::string filename);
 
 private:
     std::shared_ptr<HeightMapPath> GenerateRequirements();
 
+    /**
+     * Prints gouges of each path, found in distance field of the model
+     * (cached on disk).
+     */
+    void ReportGouges(const Paths& paths);
+
     std::vector<glm::vec3> GenerateSamplePoints(
             std::shared_ptr<CADModelLoaderResult> model_loader_result);
     std::vector<glm::vec3> GenerateSamplePoints(
@@ -77,12 +131,19 @@ private:
 
     // Step 1
     std::shared_ptr<RoughingPath> roughing_path_;
+    std::shared_ptr<ZLevelRoughingPath> z_level_roughing_path_;
     // Step 2
     std::shared_ptr<FlatAroundHMPath> flat_around_hm_path_;
+    std::shared_ptr<ContourFlatPath> contour_flat_path_;
     // Step 3
     std::shared_ptr<FlatAroundIntersectionPath> flat_around_intersection_path_;
     // Step 4
     std::shared_ptr<ParametrizationPath> parametrization_path_;
+    // Step 5
+    std::shared_ptr<RestMachiningPath> rest_machining_path_;
+
+    const int gouge_tessellation_ = 4;
+    const float gouge_cell_size_ = 1.0f;
 
 };
 }
@@ -0,0 +1,100 @@
+#ifndef PROJECT_CONTOUR_FLAT_PATH_H
+#define PROJECT_CONTOUR_FLAT_PATH_H
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct CADModelLoaderResult;
+struct HeightMapPath;
+class ObstacleDistanceMap;
+class MaterialBox;
+class Cutter;
+class Instruction;
+
+/**
+ * Contour parallel flat path around height map.
+ * Footprint of the model (obstacle mask of height map) is offset outward
+ * by iso-contours of ObstacleDistanceMap, radius_ apart,
+ * starting radius_ + epsilon from the model and ending at the material box
+ * border. Loops are cut from the border inwards, linked at the floor height.
+ * Cutter retracts only if a link would touch the model.
+ * Flat 10mm.
+ */
+class ContourFlatPath {
+public:
+
+    ContourFlatPath(std::shared_ptr<CADModelLoaderResult> model_loader_result,
+                    std::shared_ptr<MaterialBox> material_box);
+    ~ContourFlatPath();
+
+    std::shared_ptr<Cutter> Generate(std::shared_ptr<HeightMapPath> height_map);
+private:
+    /**
+     * Closed loops of points in height map grid coordinates (i,j),
+     * where distance to the model equals level.
+     * Outside of the height map distance is assumed to be infinite,
+     * so that loops are closed along the border.
+     * Border loop is obtained with level = std::numeric_limits<float>::max()
+     */
+    std::vector<std::vector<glm::vec2>> CreateContours(
+            std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+            float level);
+
+    /**
+     * Removes points closer than tolerance [mm] to the line
+     * between its kept neighbours.
+     */
+    std::vector<glm::vec2> SimplifyContour(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            const std::vector<glm::vec2>& contour, float tolerance);
+
+    /**
+     * Orders contours of each level by nearest neighbour
+     * and links them into single path.
+     */
+    std::vector<Instruction> LinkContours(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+            std::vector<std::vector<std::vector<glm::vec2>>>& levels,
+            float save_height, float floor_height);
+
+    /**
+     * True if cutter moving along straight line between a and b
+     * touches the model.
+     */
+    bool IsLinkColliding(
+            std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+            const glm::vec2& a, const glm::vec2& b);
+
+    /**
+     * Distance in millimeters between grid coordinates.
+     */
+    float Distance(std::shared_ptr<HeightMapPath> height_map_path,
+                   const glm::vec2& a, const glm::vec2& b);
+
+    /**
+     * Grid coordinates to GL position.
+     */
+    glm::vec2 Position(std::shared_ptr<HeightMapPath> height_map_path,
+                       const glm::vec2& p);
+
+    void AddInstruction(std::vector<Instruction>& instructions,
+                        const glm::vec2& v, float height,
+                        bool fast = false);
+
+    std::shared_ptr<CADModelLoaderResult> model_loader_result_;
+    std::shared_ptr<MaterialBox> material_box_;
+
+    const float diameter_ = 10.0f;
+    const float radius_ = diameter_ / 2.0f;
+    const float epsilon_ = 0.5f;
+
+    int id_;
+};
+}
+
+#endif //PROJECT_CONTOUR_FLAT_PATH_H
@@ -10,6 +10,7 @@ namespace ifc {
 
 struct CADModelLoaderResult;
 struct HeightMapPath;
+class ObstacleDistanceMap;
 class MaterialBox;
 class Cutter;
 class Instruction;
@@ -32,21 +33,26 @@ private:
 
     std::vector<Instruction> CreatePathFirstHalf(
             std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
             float save_height, float start_height, float radius,
             int n, int m,
             int skip_rows, int skip_columns,
-            int look_ahead_radius_row, int look_ahead_radius_column);
+            float stop_distance);
     std::vector<Instruction> CreatePathSecondHalf(
             std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
             float save_height, float start_height, float radius,
             int n, int m,
             int skip_rows, int skip_columns,
-            int look_ahead_radius_row, int look_ahead_radius_column);
+            float stop_distance);
 
-    bool ShouldGoBack(int i, int j, int n, int m,
-                      int look_ahead_radius_row,
-                      int look_ahead_radius_column,
-                      std::shared_ptr<HeightMapPath> height_map_path);
+    /**
+     * True if cutter at (i,j) is closer than stop_distance to an obstacle.
+     */
+    bool ShouldGoBack(int i, int j,
+                      std::shared_ptr<ObstacleDistanceMap>
+                      obstacle_distance_map,
+                      float stop_distance);
 
 
     Instruction CreateInstruction(int id, const glm::vec2& v, float height);
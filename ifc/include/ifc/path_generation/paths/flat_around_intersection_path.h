@@ -20,6 +20,8 @@ namespace ifc {
 
 struct CADModelLoaderResult;
 
+class IntersectionService;
+class OffsetCurve;
 class MaterialBox;
 class Cutter;
 class Instruction;
@@ -29,8 +31,10 @@ struct BoxIntersectionData{
     std::shared_ptr<SurfaceC2Cylind> surface;
     std::shared_ptr<ifx::RenderObject> render_object;
 
-    std::shared_ptr<BoxIntersectionData> equally_distanced;
-    std::shared_ptr<BoxIntersectionData> double_equally_distanced;
+    /**
+     * Offset(1) is the cutter center curve, Offset(2) the next pass.
+     */
+    std::shared_ptr<OffsetCurve> offset_curve;
 };
 
 struct CutterTrajectory{
@@ -60,7 +64,8 @@ public:
     FlatAroundIntersectionPath(
             std::shared_ptr<CADModelLoaderResult> model_loader_result,
             std::shared_ptr<MaterialBox> material_box,
-            std::shared_ptr<ifx::Scene> scene);
+            std::shared_ptr<ifx::Scene> scene,
+            std::shared_ptr<IntersectionService> intersection_service);
     ~FlatAroundIntersectionPath();
 
     BoxIntersectionsData* intersections_data() {return &intersections_data_;};
@@ -68,37 +73,46 @@ public:
         return inside_hand_positions_;};
     bool generated() {return generated_;}
 
+    /**
+     * Starts tracing all needed intersections in the background.
+     */
+    void RequestIntersections();
+
     std::shared_ptr<Cutter> Generate();
 private:
-    void ComputeIntersections();
-    std::vector<TracePoint> ComputeIntersection(
-            std::shared_ptr<SurfaceC2Cylind> surface1,
-            std::shared_ptr<SurfaceC2Rect> surface2,
-            glm::vec3 start_pos);
-
     /**
-     * Compute all needed intersections.
-     * They differ in taking different surface and starting point
+     * Traces all components of the Base, Hand and Drill intersections
+     * and tells them apart by their position.
+     * False if the surfaces do not intersect as expected.
      */
-    std::shared_ptr<BoxIntersectionData> ComputeBaseTopIntersection(
-            NormalDirection normal_direction);
-    std::shared_ptr<BoxIntersectionData> ComputeBaseBottomIntersection(
+    bool ComputeIntersections();
+    std::shared_ptr<BoxIntersectionData> ComputeIntersection(
+            const std::vector<TracePoint>& trace_points,
+            int surface, std::string name,
             NormalDirection normal_direction);
 
-    std::shared_ptr<BoxIntersectionData> ComputeDrillLeftIntersection(
-            NormalDirection normal_direction);
-    std::shared_ptr<BoxIntersectionData> ComputeDrillRightIntersection(
-            NormalDirection normal_direction);
+    /**
+     * Reverses the trace so that the offset side is on the right
+     * of the direction of travel, seen from above.
+     * Components are open curves traced end to end, so all of them
+     * then follow the outline the same way round, whatever the seed.
+     */
+    void Orient(std::shared_ptr<BoxIntersectionData> intersection_data,
+                NormalDirection normal_direction);
 
-    std::shared_ptr<BoxIntersectionData> ComputeHandTopIntersection(
-            NormalDirection normal_direction);
-    std::shared_ptr<BoxIntersectionData> ComputeHandBottomIntersection(
-            NormalDirection normal_direction);
+    float GetDistance(const std::vector<TracePoint>& trace_points1,
+                      const std::vector<TracePoint>& trace_points2);
+    /**
+     * Mean distance of trace_points1 to the closest of trace_points2.
+     */
+    float GetMeanDistance(const std::vector<TracePoint>& trace_points1,
+                          const std::vector<TracePoint>& trace_points2);
 
-    std::shared_ptr<BoxIntersectionData>
-            ComputeEqualDistancedIntersections(
+    std::shared_ptr<OffsetCurve> CreateOffsetCurve(
+            std::shared_ptr<BoxIntersectionData> intersection_data,
+            NormalDirection normal_direction);
+    void AddOffsetRenderObject(
             std::shared_ptr<BoxIntersectionData> intersection_data,
-            NormalDirection normal_direction,
             float distance_scalar = 1.0f);
 
     std::shared_ptr<ifx::RenderObject> CreateRenderObject(
@@ -124,8 +138,8 @@ private:
             BoxIntersectionsData& intersections_data_);
 
     glm::vec2 GetClosestPointsIndices(
-            std::vector<TracePoint>& trace_points1,
-            std::vector<TracePoint>& trace_points2,
+            const std::vector<TracePoint>& trace_points1,
+            const std::vector<TracePoint>& trace_points2,
             int start2, int finish2);
 
     std::shared_ptr<Cutter> CreatePath(CutterTrajectory& trajectory);
@@ -136,6 +150,7 @@ private:
     std::shared_ptr<MaterialBox> material_box_;
 
     std::shared_ptr<ifx::Scene> scene_;
+    std::shared_ptr<IntersectionService> intersection_service_;
 
     BoxIntersectionsData intersections_data_;
 
@@ -15,19 +15,19 @@ class RenderObject;
 
 namespace ifc {
 
+class AdaptiveStep;
 class Cutter;
+class IntersectionService;
+class OffsetCurve;
+class PointKDTree;
 class MaterialBox;
 class Instruction;
+struct LinkPass;
 struct CADModelLoaderResult;
 
 struct IntersectionData{
     std::vector<TracePoint> trace_points;
-    std::vector<TracePoint> eq_distanced_trace_points;
-
-    std::vector<TracePoint> eq_distanced_trace_points1;
-
-    std::vector<TracePoint> eq_distanced_trace_points2;
-    std::vector<TracePoint> eq_distanced_trace_points3;
+    std::shared_ptr<OffsetCurve> offset_curve;
 
     std::shared_ptr<SurfaceC2Cylind> surface1;
     std::shared_ptr<SurfaceC2Cylind> surface2;
@@ -46,32 +46,49 @@ public:
     ParametrizationPath(
             std::shared_ptr<CADModelLoaderResult> model_loader_result,
             std::shared_ptr<MaterialBox> material_box,
-            std::shared_ptr<ifx::Scene> scene);
+            std::shared_ptr<ifx::Scene> scene,
+            std::shared_ptr<IntersectionService> intersection_service);
     ~ParametrizationPath();
 
+    /**
+     * Starts tracing all needed intersections in the background.
+     */
+    void RequestIntersections();
+
     std::shared_ptr<Cutter> Generate(std::vector<glm::vec3>& positions);
 private:
-    void ComputeIntersections();
-    std::vector<TracePoint> ComputeIntersection(
-            std::shared_ptr<SurfaceC2Cylind> surface1,
-            std::shared_ptr<SurfaceC2Cylind> surface2,
-            glm::vec3 start_pos);
-
-    std::shared_ptr<IntersectionData> ComputeBaseHandRightIntersection();
-    std::shared_ptr<IntersectionData> ComputeBaseHandLeftIntersection();
-    std::shared_ptr<IntersectionData> ComputeBaseDrillIntersection();
+    /**
+     * False if the surfaces do not intersect as expected.
+     */
+    bool ComputeIntersections();
+
+    std::shared_ptr<IntersectionData> ComputeBaseHandRightIntersection(
+            std::vector<TracePoint> trace_points);
+    std::shared_ptr<IntersectionData> ComputeBaseHandLeftIntersection(
+            std::vector<TracePoint> trace_points);
+    std::shared_ptr<IntersectionData> ComputeBaseDrillIntersection(
+            std::vector<TracePoint> trace_points);
 
     std::shared_ptr<Cutter> CreatePath(std::vector<glm::vec3>& positions);
 
+    /**
+     * Steps over surface for scallop_height_ and chordal_tolerance_.
+     * du, dv are nominal steps, limiting the adaptive ones.
+     */
+    AdaptiveStep CreateAdaptiveStep(int surface, float du, float dv,
+                                    float normal_sign = 1.0f);
+
     std::vector<glm::vec3> CreateBaseTrajectory();
     std::vector<glm::vec3> CreateHandTrajectory();
     std::vector<glm::vec3> CreateDrillTrajectory();
 
-    std::vector<Instruction> CreateBaseIntructions();
-    std::vector<Instruction> CreateHandIntructions();
-    std::vector<Instruction> CreateDrillIntructions();
-    std::vector<Instruction> CreateInsideHandInstructions(
-            std::vector<glm::vec3>& positions);
+    /**
+     * Independent passes, linked by LinkOptimizer.
+     */
+    LinkPass CreateBasePass();
+    LinkPass CreateHandPass();
+    LinkPass CreateDrillPass();
+    LinkPass CreateInsidePass(std::vector<glm::vec3>& positions);
 
     std::vector<Instruction> CreateIntersectionCurveInstructions(
             std::shared_ptr<IntersectionData>);
@@ -85,14 +102,25 @@ private:
     std::vector<TracePoint> TrimTracePoints(
             const std::vector<TracePoint>& trace_points);
 
-    bool IsColliding(const std::vector<TracePoint>& trace_points,
+    /**
+     * Indexes trace point positions for collision queries.
+     */
+    PointKDTree CreatePointKDTree(const std::vector<TracePoint>& trace_points);
+
+    bool IsColliding(const PointKDTree& trace_points,
                      const glm::vec3& point);
 
+    /**
+     * Sets colliding_point to the closest trace point if colliding.
+     */
     bool IsColliding(
-            const std::vector<TracePoint>& trace_points,
+            const PointKDTree& trace_points,
             const glm::vec3& point, glm::vec3* colliding_point);
 
-    void ComputeEqualDistanceTracePoints(
+    /**
+     * Offsets are in cutter radii along (surface1, surface2) normals.
+     */
+    std::shared_ptr<OffsetCurve> CreateOffsetCurve(
             std::shared_ptr<IntersectionData> data,
             int direction = 1);
 
@@ -100,9 +128,13 @@ private:
 
     const float diameter_ = 8;
     const float radius_ = diameter_ / 2.0f;
+    // [mm]
+    const float scallop_height_ = 0.02f;
+    const float chordal_tolerance_ = 0.01f;
     std::shared_ptr<CADModelLoaderResult> model_loader_result_;
     std::shared_ptr<MaterialBox> material_box_;
     std::shared_ptr<ifx::Scene> scene_;
+    std::shared_ptr<IntersectionService> intersection_service_;
 
     IntersectionsData intersections_data_;
 };
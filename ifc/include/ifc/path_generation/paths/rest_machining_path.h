@@ -0,0 +1,85 @@
+#ifndef PROJECT_REST_MACHINING_PATH_H
+#define PROJECT_REST_MACHINING_PATH_H
+
+#include <ifc/path_generation/link_optimizer.h>
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct CADModelLoaderResult;
+struct HeightMapPath;
+class ToolOffsetMap;
+class HeightMap;
+class MaterialBox;
+class Cutter;
+
+/**
+ * Rest machining after previous programs.
+ * Previous cutters are simulated on a copy of the material box to find
+ * the real stock. Material is removable where stock is above both
+ * the target and the lowest tool compensated height of this cutter,
+ * dropped onto the tessellated model (DropCutter).
+ * Zig-zag passes are cut only where removable material exceeds threshold
+ * (within cutter radius), linked above the simulated stock.
+ * Sphere 8mm.
+ */
+class RestMachiningPath {
+public:
+
+    RestMachiningPath(
+            std::shared_ptr<CADModelLoaderResult> model_loader_result,
+            std::shared_ptr<MaterialBox> material_box,
+            float diameter = 8.0f, float threshold = 0.5f);
+    ~RestMachiningPath();
+
+    float threshold(){return threshold_;}
+    void threshold(float threshold){threshold_ = threshold;}
+
+    std::shared_ptr<Cutter> Generate(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            const std::vector<std::shared_ptr<Cutter>>& previous_cutters);
+
+private:
+    /**
+     * Cells with removable material thicker than threshold,
+     * dilated by cutter radius. Indexed as HeightMapPath.
+     */
+    std::vector<bool> CreateRestMask(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ToolOffsetMap> tool_offset_map,
+            HeightMap* stock);
+
+    void DilateMask(std::shared_ptr<HeightMapPath> height_map_path,
+                    std::vector<bool>& mask);
+
+    /**
+     * Zig-zag rows, one pass per run of masked cells.
+     */
+    std::vector<LinkPass> CreatePasses(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ToolOffsetMap> tool_offset_map,
+            const std::vector<bool>& mask);
+
+    glm::vec3 PassPosition(std::shared_ptr<HeightMapPath> height_map_path,
+                           std::shared_ptr<ToolOffsetMap> tool_offset_map,
+                           int i, int j);
+
+    std::shared_ptr<CADModelLoaderResult> model_loader_result_;
+    std::shared_ptr<MaterialBox> material_box_;
+
+    const float diameter_;
+    const float radius_;
+    // Removable material [mm] below which cell is skipped.
+    float threshold_;
+
+    const float scallop_height_ = 0.05f;
+    // Distance [mm] between points of a pass.
+    const float point_distance_ = 1.0f;
+};
+}
+
+#endif //PROJECT_REST_MACHINING_PATH_H
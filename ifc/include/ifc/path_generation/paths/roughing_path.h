@@ -17,6 +17,7 @@ namespace ifc {
 
 struct CADModel;
 struct HeightMapPath;
+class ToolOffsetMap;
 class MaterialBox;
 class Cutter;
 class Instruction;
@@ -37,22 +38,17 @@ private:
 
     std::vector<Instruction> CreatePathFromAbove(
             std::shared_ptr<HeightMapPath> height_map_path,
-            float save_height, float start_height, float radius,
+            std::shared_ptr<ToolOffsetMap> tool_offset_map,
+            float save_height, float start_height, float allowance,
             int n, int m,
-            int skip_rows, int skip_columns,
-            int look_ahead_radius_row, int look_ahead_radius_column);
+            int skip_rows, int skip_columns);
 
     std::vector<Instruction> CreatePathZigZag(
             std::shared_ptr<HeightMapPath> height_map_path,
-            float save_height, float start_height, float radius,
+            std::shared_ptr<ToolOffsetMap> tool_offset_map,
+            float save_height, float start_height, float allowance,
             int n, int m,
-            int skip_rows, int skip_columns,
-            int look_ahead_radius_row, int look_ahead_radius_column);
-
-    float MaxHeightInVicinity(int i, int j, int n, int m,
-                              int look_ahead_radius_row,
-                              int look_ahead_radius_column,
-                              std::shared_ptr<HeightMapPath> height_map_path);
+            int skip_rows, int skip_columns);
 
     Instruction CreateInstruction(int id, const glm::vec2& v, float height);
 
@@ -0,0 +1,84 @@
+#ifndef PROJECT_Z_LEVEL_ROUGHING_PATH_H
+#define PROJECT_Z_LEVEL_ROUGHING_PATH_H
+
+#include <math/math_ifx.h>
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct CADModelLoaderResult;
+struct HeightMapPath;
+class ToolOffsetMap;
+class MaterialBox;
+class Cutter;
+class Instruction;
+
+/**
+ * Roughing in layers.
+ * Target is sliced into levels step_down apart. Each level is cleared with
+ * zig-zag following tool compensated heights, only where material
+ * was left by upper levels.
+ * Sphere 16mm.
+ */
+class ZLevelRoughingPath {
+public:
+
+    ZLevelRoughingPath(
+            std::shared_ptr<CADModelLoaderResult> model_loader_result,
+            std::shared_ptr<MaterialBox> material_box,
+            float step_down = 10.0f);
+    ~ZLevelRoughingPath();
+
+    float step_down(){return step_down_;}
+    void step_down(float step_down){step_down_ = step_down;}
+
+    std::shared_ptr<Cutter> Generate(std::shared_ptr<HeightMapPath>);
+
+private:
+    std::vector<float> CreateLevels(float min_height);
+
+    std::vector<Instruction> CreateLevelPath(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            std::shared_ptr<ToolOffsetMap> tool_offset_map,
+            float level, float previous_level, float save_height,
+            int skip_rows, int skip_columns);
+
+    /**
+     * True if any target height around (i,j) is below previous_level,
+     * i.e. upper levels did not clear that area.
+     */
+    bool HasMaterial(std::shared_ptr<ToolOffsetMap> tool_offset_map,
+                     int i, int j, int skip_rows, int skip_columns,
+                     float previous_level);
+
+    float TargetHeight(std::shared_ptr<ToolOffsetMap> tool_offset_map,
+                       int i, int j, float level);
+
+    /**
+     * Lowest height at which cutter can move in straight line
+     * between two cells.
+     */
+    float LinkHeight(std::shared_ptr<ToolOffsetMap> tool_offset_map,
+                     int i1, int j1, int i2, int j2, float level);
+
+    void AddInstruction(std::vector<Instruction>& instructions,
+                        const glm::vec2& v, float height,
+                        bool fast = false);
+
+    std::shared_ptr<CADModelLoaderResult> model_loader_result_;
+    std::shared_ptr<MaterialBox> material_box_;
+
+    float step_down_;
+
+    const float diameter_ = 16.0f;
+    const float radius_ = diameter_ / 2.0f;
+    // Material left for finishing paths.
+    const float allowance_ = 0.5f;
+
+    int id_;
+};
+}
+
+#endif //PROJECT_Z_LEVEL_ROUGHING_PATH_H
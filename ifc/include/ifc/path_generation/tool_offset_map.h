@@ -0,0 +1,94 @@
+#ifndef PROJECT_TOOL_OFFSET_MAP_H
+#define PROJECT_TOOL_OFFSET_MAP_H
+
+#include <ifc/cutter/cutter.h>
+
+#include <memory>
+#include <vector>
+
+namespace ifc {
+
+struct HeightMapPath;
+class DropCutter;
+class ThreadPool;
+
+/**
+ * Tool compensated height map.
+ * For every cell of HeightMapPath stores the lowest height at which
+ * the tip of the cutter can be placed without touching the target surface,
+ * i.e. the maximum of the surface over the footprint of the cutter.
+ *
+ * Footprint is decomposed into a stack of flat discs
+ * (one for Flat cutter, sphere_levels for Sphere cutter)
+ * and each disc into chords. Maximum along a chord is computed with
+ * van Herk/Gil-Werman running maximum, independently of chord length.
+ * Sphere profile is rounded up, so heights are never too low
+ * (error at most radius / sphere_levels).
+ *
+ * Heights are stored in GL coordinates, same as HeightMapPath.
+ */
+class ToolOffsetMap {
+public:
+
+    ToolOffsetMap(std::shared_ptr<HeightMapPath> height_map_path,
+                  CutterType type, float radius,
+                  int sphere_levels = 16);
+    /**
+     * Exact heights of the tessellated model at cell positions,
+     * computed on the pool.
+     */
+    ToolOffsetMap(std::shared_ptr<HeightMapPath> height_map_path,
+                  const DropCutter& drop_cutter,
+                  CutterType type, float radius,
+                  ThreadPool& pool);
+    ~ToolOffsetMap();
+
+    CutterType type(){return type_;}
+    float radius(){return radius_;}
+    int row_count(){return row_count_;}
+    int column_count(){return column_count_;}
+
+    /**
+     * Indices outside of the map are clamped to the border.
+     */
+    float GetHeight(int i, int j);
+
+    /**
+     * Maximum height over the cells between rows i1, i2
+     * and columns j1, j2 (inclusive), e.g. swept by a straight move.
+     */
+    float GetMaxHeight(int i1, int j1, int i2, int j2);
+
+private:
+    struct Chord{
+        int row_offset;
+        int half_width;
+        // height of the profile over the chord in GL.
+        float height;
+    };
+
+    std::vector<Chord> CreateChords(
+            std::shared_ptr<HeightMapPath> height_map_path,
+            int sphere_levels);
+    void Compute(std::shared_ptr<HeightMapPath> height_map_path,
+                 const std::vector<Chord>& chords);
+
+    /**
+     * van Herk/Gil-Werman maximum of window [j - half_width, j + half_width]
+     * for each j of every row.
+     */
+    void RowMaximum(const std::vector<float>& heights, int half_width,
+                    std::vector<float>& result);
+
+    CutterType type_;
+    // in mm
+    float radius_;
+
+    int row_count_;
+    int column_count_;
+
+    std::vector<float> heights_;
+};
+}
+
+#endif //PROJECT_TOOL_OFFSET_MAP_H
@@ -0,0 +1,51 @@
+#include "ifc/cutter/batch_simulation.h"
+
+#include <ifc/material/height_map.h>
+#include <ifc/material/stock_snapshot.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace ifc {
+
+BatchSimulation::BatchSimulation(MaterialBoxCreateParams params) :
+        params_(params){
+    height_map_.reset(new HeightMap(params_.precision.x, params_.precision.z,
+                                    params_.dimensions.x, params_.dimensions.z,
+                                    params_.dimensions.depth, false));
+    height_map_->InitPositions(params_.dimensions.x, params_.dimensions.z);
+
+    line_delta_ = 0.5f * std::min(
+            params_.dimensions.x / (float)params_.precision.x,
+            params_.dimensions.z / (float)params_.precision.z);
+}
+
+BatchSimulation::BatchSimulation(const StockSnapshot& snapshot) :
+        BatchSimulation(snapshot.params()){
+    snapshot.Restore(height_map_.get());
+}
+
+BatchSimulation::~BatchSimulation(){}
+
+CutterStatus BatchSimulation::Run(std::shared_ptr<Cutter> cutter){
+    std::vector<Instruction> instructions = cutter->instructions();
+    Cutter simulated_cutter(cutter->type(), cutter->diameter(), instructions);
+
+    while(!simulated_cutter.Finished()){
+        simulated_cutter.Update(height_map_.get(), params_.dimensions,
+                                line_delta_);
+        if(simulated_cutter.last_status() != CutterStatus::NONE){
+            std::cout << "BatchSimulation stopped at instruction: "
+            << simulated_cutter.current_instruction() << std::endl;
+            return simulated_cutter.last_status();
+        }
+    }
+    return CutterStatus::FINISHED;
+}
+
+std::shared_ptr<StockSnapshot> BatchSimulation::Snapshot(){
+    return std::shared_ptr<StockSnapshot>(
+            new StockSnapshot(params_, height_map_.get()));
+}
+
+}
@@ -2,7 +2,11 @@
 
 #include <object/render_object.h>
 #include <ifc/measures.h>
+#include <ifc/material/height_undo_log.h>
+#include <ifc/material/height_pyramid.h>
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 namespace ifc {
 
@@ -13,8 +17,12 @@ Cutter::Cutter(CutterType type, float diameter,
         radius_(diameter / 2.0f),
         instructions_(instructions),
         current_intruction_(-1),
+        air_t_begin_(0),
+        air_t_end_(0),
+        max_air_distance_(std::numeric_limits<float>::max()),
         start_position_mm_(glm::vec3(0, 0, 150)),
         last_status_(CutterStatus::NONE) {
+    current_position_ = start_position_mm_;
     ChangeInstruction();
 }
 
@@ -25,18 +33,43 @@ float Cutter::GetProgress() {
 }
 
 void Cutter::Update(MaterialBox *material_box, float t_delta) {
+    Update(material_box->height_map(), material_box->dimensions(), t_delta);
+}
+
+void Cutter::Update(HeightMap* height_map,
+                    const MaterialBoxDimensions& dimensions, float t_delta) {
     if (Finished()) {
         return;
     }
-    CutterStatus error = CheckErrors(material_box);
+    CutterStatus error = CheckErrors(dimensions);
     last_status_ = error;
     if (error != CutterStatus::NONE) return;
 
     MaybeChangeInstruction();
+    if (height_map->undo_log())
+        height_map->undo_log()->BeginSegment(current_intruction_);
+    // Single step moves are cut right away, cheaper than the query.
+    if (current_vector_equation_.t <= current_vector_equation_.t_min
+        && current_vector_equation_.distance > t_delta)
+        FindAirMove(height_map, dimensions);
+    // Moves above stock are crossed without cutting,
+    // up to max air distance at once.
+    if (current_vector_equation_.t >= air_t_begin_
+        && current_vector_equation_.t < air_t_end_) {
+        current_vector_equation_.t = std::min(air_t_end_,
+                current_vector_equation_.t
+                + max_air_distance_ / current_vector_equation_.distance);
+        if (current_vector_equation_.t < air_t_end_
+            || air_t_end_ >= current_vector_equation_.t_max) {
+            ComputeCurrentPosition();
+            Move();
+            return;
+        }
+    }
     UpdateT(t_delta);
     ComputeCurrentPosition();
     Move();
-    Cut(material_box->height_map());
+    Cut(height_map);
 }
 
 bool Cutter::Finished() {
@@ -46,6 +79,21 @@ bool Cutter::Finished() {
     return (current_intruction_ + 1 >= size);
 }
 
+bool Cutter::InstructionFinished() {
+    return current_vector_equation_.t >= current_vector_equation_.t_max;
+}
+
+void Cutter::Seek(int instruction) {
+    if (instructions_.empty()) return;
+    instruction = std::min(std::max(instruction, 0),
+                           (int)instructions_.size() - 1);
+    current_intruction_ = instruction - 1;
+    ChangeInstruction();
+    current_position_ = instructions_[instruction].position();
+    last_status_ = CutterStatus::NONE;
+    Move();
+}
+
 bool Cutter::SaveToFile(std::string filename) {
     std::ofstream file;
     filename += ".";
@@ -82,15 +130,17 @@ std::string Cutter::GetFileExtention(CutterType type,
     return extension;
 }
 
-CutterStatus Cutter::CheckErrors(MaterialBox* material_box){
-    if(current_position_.x >= -material_box->dimensions().x / 2.0f
-       && current_position_.x <= material_box->dimensions().x / 2.0f
-       && current_position_.y >= -material_box->dimensions().z / 2.0f
-       && current_position_.y <= material_box->dimensions().z / 2.0f){
+CutterStatus Cutter::CheckErrors(const MaterialBoxDimensions& dimensions){
+    if(current_position_.x >= -dimensions.x / 2.0f
+       && current_position_.x <= dimensions.x / 2.0f
+       && current_position_.y >= -dimensions.z / 2.0f
+       && current_position_.y <= dimensions.z / 2.0f){
         if(current_position_.z <
-                    material_box->dimensions().depth -
-                material_box->dimensions().max_depth - 1.0f){
-            std::cout << "Error MAX_DEPTH" << std::endl;
+                    dimensions.depth -
+                dimensions.max_depth - 1.0f){
+            // Cutter stays in error, report it once.
+            if(last_status_ != CutterStatus::MAX_DEPTH)
+                std::cout << "Error MAX_DEPTH" << std::endl;
             return CutterStatus::MAX_DEPTH;
         }
     }
@@ -109,6 +159,8 @@ void Cutter::ChangeInstruction(){
         return;
 
     current_vector_equation_.t = current_vector_equation_.t_min;
+    air_t_begin_ = current_vector_equation_.t_min;
+    air_t_end_ = current_vector_equation_.t_min;
     glm::vec3 pos1 = instructions_[current_intruction_].position();
     glm::vec3 pos2 = instructions_[current_intruction_+1].position();
 
@@ -117,6 +169,39 @@ void Cutter::ChangeInstruction(){
     current_vector_equation_.distance = ifx::EuclideanDistance(pos1, pos2);
 }
 
+void Cutter::FindAirMove(HeightMap* height_map,
+                         const MaterialBoxDimensions& dimensions){
+    const glm::vec3& start = instructions_[current_intruction_].position();
+    const glm::vec3& end = instructions_[current_intruction_ + 1].position();
+    // Too deep moves are stepped, so that CheckErrors reports them.
+    if(std::min(start.z, end.z) < dimensions.depth - dimensions.max_depth - 1.0f)
+        return;
+
+    // Look ahead of Cut around both ends, one cell more for rounding.
+    const float epsilon = 0.5f * radius_;
+    int radius_i = (radius_ + epsilon) * height_map->row_width() + 1;
+    int radius_j = (radius_ + epsilon) * height_map->column_width() + 1;
+    glm::vec2 a = height_map->GetIndices(
+            MillimetersToGL(glm::vec2(start.x, start.y)));
+    glm::vec2 b = height_map->GetIndices(
+            MillimetersToGL(glm::vec2(end.x, end.y)));
+    float stock = GLToMillimeters(height_map->pyramid()->MaxHeight(
+            std::min(a.x, b.x) - radius_i, std::min(a.y, b.y) - radius_j,
+            std::max(a.x, b.x) + radius_i, std::max(a.y, b.y) + radius_j));
+
+    // Stock only gets lower while the instruction is cut.
+    if(start.z >= stock && end.z >= stock){
+        air_t_begin_ = current_vector_equation_.t_min;
+        air_t_end_ = current_vector_equation_.t_max;
+    }else if(start.z > stock){
+        air_t_begin_ = current_vector_equation_.t_min;
+        air_t_end_ = (start.z - stock) / (start.z - end.z);
+    }else if(end.z > stock){
+        air_t_begin_ = (stock - start.z) / (end.z - start.z);
+        air_t_end_ = current_vector_equation_.t_max;
+    }
+}
+
 void Cutter::UpdateT(float t_delta){
     current_vector_equation_.t
             += t_delta * (1.0f / current_vector_equation_.distance);
@@ -130,6 +215,8 @@ void Cutter::ComputeCurrentPosition(){
 }
 
 void Cutter::Move(){
+    if(!render_object_)
+        return;
     glm::vec3 vec_gl = MillimetersToGL(current_position_);
 
     // -x so that cutter moves properly
@@ -1,19 +1,34 @@
 #include "ifc/cutter/cutter_simulation.h"
 
+#include <ifc/cutter/simulation_timeline.h>
+#include <ifc/cutter/program_watcher.h>
+#include <ifc/material/height_undo_log.h>
+
 #include <rendering/instanced_render_object.h>
 #include <GLFW/glfw3.h>
 #include <factory/program_factory.h>
 #include <factory/texture_factory.h>
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
 namespace ifc {
 
 CutterSimulation::CutterSimulation(std::shared_ptr<ifx::Scene> scene) :
         scene_(scene),
-        time_delta_(0.001),
         current_update_time_(0),
         last_update_time_(0),
         total_time_s_(0),
-        line_delta_(1.0){
+        speed_(1.0f),
+        frame_budget_ms_(8.0f),
+        feed_rates_(DEFAULT_FEED_RATES),
+        machine_time_s_(0),
+        pending_time_s_(0),
+        fast_forward_(false),
+        line_delta_(1.0),
+        undo_log_(new HeightUndoLog()){
     Pause();
 }
 
@@ -38,9 +53,11 @@ void CutterSimulation::SetMaterialBox(
     if(material_box_){
         scene_->DeleteRenderObject(
                 material_box_->box_render_object().get());
+        material_box_->height_map()->undo_log(nullptr);
     }
 
     material_box_ = material_box;
+    material_box_->height_map()->undo_log(undo_log_.get());
 
     scene_->AddRenderObject(material_box_->box_render_object());
 
@@ -62,39 +79,102 @@ void CutterSimulation::SetCutter(std::shared_ptr<Cutter> cutter){
 void CutterSimulation::Update() {
     if(cutter_ && cutter_->Finished()){
         Pause();
+        fast_forward_ = false;
         return;
     }
     if(!CanUpdate())
         return;
 
-    if(!SatisfiesTimeDelta())
+    float frame_time = FrameTime();
+    if(!running_){
+        pending_time_s_ = 0;
+        fast_forward_ = false;
         return;
+    }
+    if(fast_forward_)
+        pending_time_s_ = std::numeric_limits<double>::max();
+    else
+        pending_time_s_ += frame_time * speed_;
 
-    cutter_->Update(material_box_.get(), line_delta_);
-    material_box_->Update();
-    UpdateTrajectory();
-
-    if(cutter_ && cutter_->last_status() != CutterStatus::NONE)
-        Pause();
+    if(Advance())
+        material_box_->Update();
 }
 
 void CutterSimulation::Reset(){
     trajectory_.positions.clear();
+    machine_time_s_ = 0;
+    pending_time_s_ = 0;
+    fast_forward_ = false;
+    undo_log_->Clear();
+    timeline_.reset();
+    if(CanUpdate())
+        timeline_.reset(new SimulationTimeline(material_box_->height_map()));
 }
 
-bool CutterSimulation::SatisfiesTimeDelta(){
+float CutterSimulation::FrameTime(){
     current_update_time_ = glfwGetTime();
-    if(!running_){
-        last_update_time_ = current_update_time_;
-        return false;
+    float frame_time = current_update_time_ - last_update_time_;
+    last_update_time_ = current_update_time_;
+    if(!running_)
+        return 0;
+    total_time_s_ += frame_time;
+    return frame_time;
+}
+
+bool CutterSimulation::Advance(){
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<float, std::milli> budget(frame_budget_ms_);
+
+    bool moved = false;
+    while(pending_time_s_ > 0 && !cutter_->Finished()){
+        if(std::chrono::steady_clock::now() - start > budget){
+            // Falls behind rather than blocking frames.
+            pending_time_s_ = 0;
+            break;
+        }
+        // Instruction changes at the start of the update.
+        int instruction = cutter_->current_instruction();
+        if(cutter_->InstructionFinished())
+            instruction++;
+        cutter_->max_air_distance(std::min(
+                pending_time_s_ * FeedRate(instruction),
+                (double)std::numeric_limits<float>::max()));
+
+        glm::vec3 position = cutter_->current_position();
+        int previous_instruction = cutter_->current_instruction();
+        cutter_->Update(material_box_.get(), line_delta_);
+        float distance = ifx::EuclideanDistance(
+                position, cutter_->current_position());
+        double time = distance / FeedRate(cutter_->current_instruction());
+        pending_time_s_ -= time;
+        machine_time_s_ += time;
+        moved = true;
+        // Air move shorter than float precision, waits for the next frame.
+        if(distance == 0
+           && cutter_->current_instruction() == previous_instruction
+           && cutter_->last_status() == CutterStatus::NONE)
+            break;
+
+        UpdateTrajectory();
+        timeline_->Record(cutter_->current_instruction(),
+                          material_box_->height_map());
+        if(cutter_->last_status() != CutterStatus::NONE){
+            Pause();
+            break;
+        }
     }
-    double time_delta = current_update_time_ - last_update_time_;
-    total_time_s_ += time_delta;
+    cutter_->max_air_distance(std::numeric_limits<float>::max());
+    return moved;
+}
 
-    bool value = time_delta >= time_delta_;
-    if(value)
-        last_update_time_ = current_update_time_;
-    return value;
+float CutterSimulation::FeedRate(int instruction){
+    const std::vector<Instruction>& instructions = cutter_->instructions();
+    // Move to instruction k uses speed mode of instruction k.
+    if(instruction + 1 < (int)instructions.size()
+       && instructions[instruction + 1].speed_mode()
+          == InstructionSpeedMode::FAST)
+        return feed_rates_.fast / 60.0f;
+    return feed_rates_.normal / 60.0f;
 }
 
 bool CutterSimulation::CanUpdate(){
@@ -113,7 +193,146 @@ void CutterSimulation::UpdateAllAtOnce(){
         cutter_->Update(material_box_.get(), line_delta_);
         material_box_->Update();
         UpdateTrajectory();
+        timeline_->Record(cutter_->current_instruction(),
+                          material_box_->height_map());
+    }
+    UpdateMachineTime();
+}
+
+void CutterSimulation::FastForward(){
+    if(!CanUpdate() || cutter_->Finished())
+        return;
+    fast_forward_ = true;
+    SetRunning(true);
+}
+
+void CutterSimulation::Seek(int instruction){
+    if(!CanUpdate())
+        return;
+    Pause();
+
+    HeightMap* height_map = material_box_->height_map();
+    // Undo log does not follow restored keyframes.
+    undo_log_->Clear();
+    if(instruction < cutter_->current_instruction()){
+        cutter_->Seek(timeline_->Restore(instruction, height_map));
+        trajectory_.positions.clear();
+    }
+    Replay(instruction);
+    UpdateMachineTime();
+    material_box_->Update();
+    UpdateTrajectoryView();
+}
+
+void CutterSimulation::ReloadCutter(std::shared_ptr<Cutter> cutter){
+    if(!CanUpdate() || !cutter || cutter->type() != cutter_->type()
+       || cutter->diameter() != cutter_->diameter()){
+        SetCutter(cutter);
+        return;
+    }
+    int first_changed = FirstChangedInstruction(cutter_->instructions(),
+                                                cutter->instructions());
+    if(first_changed == -1)
+        return;
+    if(cutter->instructions().empty()){
+        SetCutter(cutter);
+        return;
+    }
+    bool running = IsRunning();
+    Pause();
+
+    // Last instruction the old program cut towards, not clamped,
+    // program cut short leaves stock of removed moves.
+    int cut_instruction = cutter_->current_instruction();
+    if(!cutter_->Finished())
+        cut_instruction++;
+    int instruction = std::min(cutter_->current_instruction(),
+                               (int)cutter->instructions().size() - 1);
+    scene_->DeleteRenderObject(cutter_->render_object().get());
+    cutter_ = cutter;
+    scene_->AddRenderObject(cutter_->render_object());
+
+    undo_log_->Clear();
+    if(first_changed <= cut_instruction){
+        // Keyframe of instruction k holds cuts of the move from k
+        // to k + 1, move to the first changed one is changed too.
+        HeightMap* height_map = material_box_->height_map();
+        cutter_->Seek(timeline_->Rewind(first_changed - 2, height_map));
+        trajectory_.positions.clear();
+        Replay(instruction);
+    }else{
+        cutter_->Seek(instruction);
+    }
+    std::cout << "Reloaded program from instruction: " << first_changed
+    << std::endl;
+    UpdateMachineTime();
+
+    material_box_->Update();
+    UpdateTrajectoryView();
+    SetRunning(running);
+}
+
+void CutterSimulation::Replay(int instruction){
+    HeightMap* height_map = material_box_->height_map();
+    while(!cutter_->Finished()
+          && cutter_->current_instruction() < instruction){
+        cutter_->Update(height_map, material_box_->dimensions(), line_delta_);
+        timeline_->Record(cutter_->current_instruction(), height_map);
+        if(cutter_->last_status() != CutterStatus::NONE)
+            break;
+    }
+}
+
+void CutterSimulation::StepForward(){
+    if(!CanUpdate() || cutter_->Finished())
+        return;
+    Pause();
+
+    // Finished instruction is left at the next update, step over it.
+    if(cutter_->InstructionFinished()){
+        cutter_->Seek(cutter_->current_instruction() + 1);
+        if(cutter_->Finished()){
+            UpdateMachineTime();
+            return;
+        }
+    }
+    do{
+        cutter_->Update(material_box_.get(), line_delta_);
+        UpdateTrajectory();
+    }while(!cutter_->InstructionFinished()
+           && cutter_->last_status() == CutterStatus::NONE);
+    UpdateMachineTime();
+    material_box_->Update();
+}
+
+void CutterSimulation::StepBack(){
+    if(!CanUpdate())
+        return;
+    Pause();
+
+    int instruction = undo_log_->Undo(material_box_->height_map());
+    if(instruction == -1)
+        return;
+    cutter_->Seek(instruction);
+    UpdateMachineTime();
+    material_box_->Update();
+}
+
+void CutterSimulation::UpdateMachineTime(){
+    const std::vector<Instruction>& instructions = cutter_->instructions();
+    int current = cutter_->current_instruction();
+    machine_time_s_ = 0;
+    pending_time_s_ = 0;
+    if(instructions.empty())
+        return;
+    for(int k = 0; k < current; k++){
+        machine_time_s_ += ifx::EuclideanDistance(
+                instructions[k].position(),
+                instructions[k + 1].position()) / FeedRate(k);
     }
+    machine_time_s_ += ifx::EuclideanDistance(
+            instructions[current].position(),
+            cutter_->current_position()) / FeedRate(current);
 }
 
 void CutterSimulation::UpdateTrajectory(){
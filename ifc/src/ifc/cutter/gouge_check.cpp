@@ -0,0 +1,101 @@
+#include "ifc/cutter/gouge_check.h"
+
+#include <ifc/geometry/distance_field.h>
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace {
+// Least points on a ring of flat cutter.
+const int MIN_RING_SAMPLES = 8;
+// Steps of the descent towards the lowest point of flat cutter.
+const int DESCENT_STEPS = 8;
+}
+
+namespace ifc {
+
+int RingSamples(float radius, float tolerance){
+    // Sagitta of the arc between neighbouring samples is at most tolerance.
+    float cos_half_angle = std::max(1.0f - tolerance / radius, -1.0f);
+    int samples = std::ceil(M_PI / std::acos(cos_half_angle));
+    return std::max(samples, MIN_RING_SAMPLES);
+}
+
+float ToolClearance(const DistanceField& distance_field,
+                    CutterType type, float radius, const glm::vec3& tip,
+                    float tolerance){
+    if(type == CutterType::Sphere){
+        glm::vec3 center = tip + glm::vec3(0, 0, radius);
+        return distance_field.Distance(center) - radius;
+    }
+
+    // Tip, the rim and an interior ring.
+    glm::vec3 lowest = tip;
+    float clearance = distance_field.Distance(tip);
+    for(float ring_radius : {radius, 0.5f * radius}){
+        int samples = RingSamples(ring_radius, tolerance);
+        for(int k = 0; k < samples; k++){
+            float angle = 2.0f * M_PI * k / samples;
+            glm::vec3 point = tip + ring_radius * glm::vec3(
+                    std::cos(angle), std::sin(angle), 0.0f);
+            float distance = distance_field.Distance(point);
+            if(distance < clearance){
+                clearance = distance;
+                lowest = point;
+            }
+        }
+    }
+
+    // Descend along -gradient within the bottom face.
+    float step = 0.5f * radius;
+    for(int k = 0; k < DESCENT_STEPS; k++){
+        glm::vec3 gradient = distance_field.Gradient(lowest);
+        glm::vec2 direction = glm::vec2(-gradient.x, -gradient.y);
+        if(glm::length(direction) < 1e-6f)
+            break;
+        glm::vec2 offset = glm::vec2(lowest.x - tip.x, lowest.y - tip.y)
+                           + step * glm::normalize(direction);
+        if(glm::length(offset) > radius)
+            offset = radius * glm::normalize(offset);
+        glm::vec3 point = tip + glm::vec3(offset.x, offset.y, 0.0f);
+        float distance = distance_field.Distance(point);
+        if(distance < clearance){
+            clearance = distance;
+            lowest = point;
+        }else{
+            step *= 0.5f;
+        }
+    }
+    return clearance;
+}
+
+GougeReport CheckGouges(const DistanceField& distance_field,
+                        CutterType type, float radius,
+                        const std::vector<Instruction>& instructions,
+                        float step, float tolerance){
+    GougeReport report{0, 0, 0.0f, -1};
+
+    for(unsigned int i = 0; i < instructions.size(); i++){
+        glm::vec3 end = instructions[i].position();
+        glm::vec3 start = i == 0 ? end : instructions[i - 1].position();
+        int samples = std::max(
+                (int)std::ceil(ifx::EuclideanDistance(start, end) / step), 1);
+        // Start of the move was checked with the previous instruction.
+        for(int k = i == 0 ? samples : 1; k <= samples; k++){
+            glm::vec3 tip = start + ((float)k / samples) * (end - start);
+            float depth = -ToolClearance(distance_field, type, radius, tip,
+                                         tolerance);
+            report.position_count++;
+            if(depth <= tolerance)
+                continue;
+            report.gouge_count++;
+            report.max_depth = std::max(report.max_depth, depth);
+            if(report.first_gouge_instruction == -1)
+                report.first_gouge_instruction = i;
+        }
+    }
+    return report;
+}
+
+}
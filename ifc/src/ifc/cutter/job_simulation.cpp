@@ -0,0 +1,241 @@
+#include "ifc/cutter/job_simulation.h"
+
+#include <ifc/cutter/cutter_loader.h>
+#include <ifc/cutter/machining_time.h>
+#include <ifc/material/height_map.h>
+#include <ifc/material/stock_snapshot.h>
+#include <ifc/measures.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace ifc {
+
+JobSimulation::JobSimulation(MaterialBoxCreateParams params) :
+        simulation_(params),
+        dimensions_(params.dimensions){
+    HeightMap* stock = simulation_.height_map();
+    width_ = stock->texture_data()->width;
+    height_ = stock->texture_data()->height;
+    origin_ = GLToMillimeters(stock->GetPosition(0, 0));
+    spacing_ = glm::vec2(
+            dimensions_.x / (float)width_, dimensions_.z / (float)height_);
+    if(width_ > 1 && height_ > 1){
+        spacing_ = glm::vec2(
+                GLToMillimeters(stock->GetPosition(1, 0)).x - origin_.x,
+                GLToMillimeters(stock->GetPosition(0, 1)).y - origin_.y);
+    }
+}
+
+JobSimulation::JobSimulation(const StockSnapshot& snapshot) :
+        JobSimulation(snapshot.params()){
+    snapshot.Restore(simulation_.height_map());
+}
+
+JobSimulation::~JobSimulation(){}
+
+bool JobSimulation::Restore(const StockSnapshot& snapshot){
+    const MaterialBoxDimensions& dimensions = snapshot.params().dimensions;
+    if(dimensions.x != dimensions_.x || dimensions.z != dimensions_.z
+       || dimensions.depth != dimensions_.depth
+       || dimensions.max_depth != dimensions_.max_depth)
+        return false;
+    return snapshot.Restore(simulation_.height_map());
+}
+
+std::vector<std::string> JobSimulation::LoadJob(std::string filename){
+    std::vector<std::string> programs;
+    std::ifstream file(filename);
+    std::string line;
+    while(std::getline(file, line)){
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if(line.empty() || line[0] == '#')
+            continue;
+        programs.push_back(line);
+    }
+    return programs;
+}
+
+std::vector<ToolReport> JobSimulation::Run(
+        const std::vector<std::string>& programs){
+    std::vector<ToolReport> reports;
+    bool stopped = false;
+    for(auto& program : programs){
+        auto cutter = CutterLoader(program).Load();
+        if(!cutter || stopped){
+            std::cout << "JobSimulation skipped: " << program << std::endl;
+            reports.push_back(ToolReport{program, CutterType::UNKNOWN, 0.0f,
+                                         CutterStatus::NONE, -1,
+                                         0.0f, 0.0, 0.0f});
+            stopped = true;
+            continue;
+        }
+        reports.push_back(Run(cutter, program));
+        stopped = reports.back().status != CutterStatus::FINISHED;
+    }
+    return reports;
+}
+
+ToolReport JobSimulation::Run(std::shared_ptr<Cutter> cutter,
+                              std::string program){
+    auto start_time = std::chrono::steady_clock::now();
+    const std::vector<Instruction>& instructions = cutter->instructions();
+    ToolReport report{program, cutter->type(), cutter->diameter(),
+                      CutterStatus::FINISHED, -1, 0.0f, 0.0,
+                      EstimateMachiningTime(instructions).time_s};
+
+    const std::vector<Stencil>& stencils
+            = GetStencils(cutter->type(), cutter->diameter());
+    float volume = StockVolume();
+    // Same step as BatchSimulation: half of the cell.
+    float step = 0.5f * std::min(std::fabs(spacing_.x),
+                                 std::fabs(spacing_.y));
+    for(int k = 0; k + 1 < (int)instructions.size(); k++){
+        const glm::vec3& start = instructions[k].position();
+        const glm::vec3& end = instructions[k + 1].position();
+        int samples = std::max(
+                (int)std::ceil(ifx::EuclideanDistance(start, end) / step), 1);
+        for(int s = k == 0 ? 0 : 1; s <= samples; s++){
+            glm::vec3 tip = start + ((float)s / samples) * (end - start);
+            CutterStatus status = CheckErrors(cutter->type(), start, end, tip);
+            if(status != CutterStatus::NONE){
+                report.status = status;
+                report.error_instruction = k;
+                break;
+            }
+            Cut(stencils, cutter->type(), cutter->diameter() / 2.0f, tip);
+        }
+        if(report.status != CutterStatus::FINISHED)
+            break;
+    }
+
+    report.removed_volume = volume - StockVolume();
+    report.simulation_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time).count();
+    return report;
+}
+
+void JobSimulation::PrintReport(const std::vector<ToolReport>& reports){
+    for(auto& report : reports){
+        std::cout << report.program << ": ";
+        if(report.status == CutterStatus::NONE){
+            std::cout << "not run" << std::endl;
+            continue;
+        }
+        std::cout << (report.status == CutterStatus::FINISHED ? "finished"
+                                                               : "error")
+        << ", removed: " << report.removed_volume << " [mm^3], simulated in "
+        << report.simulation_ms << " [ms], machining: "
+        << report.machining_time_s << " [s]";
+        if(report.error_instruction != -1)
+            std::cout << ", stopped at instruction: "
+            << report.error_instruction;
+        std::cout << std::endl;
+    }
+}
+
+const std::vector<JobSimulation::Stencil>& JobSimulation::GetStencils(
+        CutterType type, float diameter){
+    auto key = std::make_pair(type, diameter);
+    auto found = stencils_.find(key);
+    if(found != stencils_.end())
+        return found->second;
+
+    float radius = diameter / 2.0f;
+    int range_i = std::ceil(radius / std::fabs(spacing_.x)) + 1;
+    int range_j = std::ceil(radius / std::fabs(spacing_.y)) + 1;
+
+    const float size = 1.0f / STENCIL_SUBDIVISIONS;
+    std::vector<Stencil> stencils;
+    for(int si = 0; si < STENCIL_SUBDIVISIONS; si++){
+        for(int sj = 0; sj < STENCIL_SUBDIVISIONS; sj++){
+            Stencil stencil;
+            for(int di = -range_i; di <= range_i; di++){
+                for(int dj = -range_j; dj <= range_j; dj++){
+                    // Point of the sub cell closest to the cell.
+                    float fi = std::min(std::max((float)di, si * size),
+                                        (si + 1) * size);
+                    float fj = std::min(std::max((float)dj, sj * size),
+                                        (sj + 1) * size);
+                    float x = (di - fi) * spacing_.x;
+                    float y = (dj - fj) * spacing_.y;
+                    if(x * x + y * y < radius * radius)
+                        stencil.push_back(StencilCell{di, dj});
+                }
+            }
+            stencils.push_back(stencil);
+        }
+    }
+    return stencils_[key] = stencils;
+}
+
+CutterStatus JobSimulation::CheckErrors(CutterType type,
+                                        const glm::vec3& start,
+                                        const glm::vec3& end,
+                                        const glm::vec3& tip){
+    bool inside = tip.x >= -dimensions_.x / 2.0f
+                  && tip.x <= dimensions_.x / 2.0f
+                  && tip.y >= -dimensions_.z / 2.0f
+                  && tip.y <= dimensions_.z / 2.0f;
+    if(!inside)
+        return CutterStatus::NONE;
+    if(tip.z < dimensions_.depth - dimensions_.max_depth
+               - max_depth_tolerance_)
+        return CutterStatus::MAX_DEPTH;
+
+    // Bottom of flat cutter does not cut, it can not go straight down
+    // into material.
+    bool down = std::fabs(end.x - start.x) < 1e-3f
+                && std::fabs(end.y - start.y) < 1e-3f && end.z < start.z;
+    if(type == CutterType::Flat && down){
+        int i = std::round((tip.x - origin_.x) / spacing_.x);
+        int j = std::round((tip.y - origin_.y) / spacing_.y);
+        if(i >= 0 && i < width_ && j >= 0 && j < height_
+           && tip.z < simulation_.height_map()->GetHeight(i, j))
+            return CutterStatus::FLAT_DIRECT_DOWN;
+    }
+    return CutterStatus::NONE;
+}
+
+void JobSimulation::Cut(const std::vector<Stencil>& stencils,
+                        CutterType type, float radius,
+                        const glm::vec3& tip){
+    float fi = (tip.x - origin_.x) / spacing_.x;
+    float fj = (tip.y - origin_.y) / spacing_.y;
+    int i0 = std::floor(fi);
+    int j0 = std::floor(fj);
+    int si = std::min((int)((fi - i0) * STENCIL_SUBDIVISIONS),
+                      STENCIL_SUBDIVISIONS - 1);
+    int sj = std::min((int)((fj - j0) * STENCIL_SUBDIVISIONS),
+                      STENCIL_SUBDIVISIONS - 1);
+
+    HeightMap* stock = simulation_.height_map();
+    for(auto& cell : stencils[si * STENCIL_SUBDIVISIONS + sj]){
+        int i = i0 + cell.di;
+        int j = j0 + cell.dj;
+        if(i < 0 || i >= width_ || j < 0 || j >= height_)
+            continue;
+        float x = (cell.di - (fi - i0)) * spacing_.x;
+        float y = (cell.dj - (fj - j0)) * spacing_.y;
+        float distance_squared = x * x + y * y;
+        if(distance_squared >= radius * radius)
+            continue;
+        float dz = type == CutterType::Sphere
+                   ? radius - std::sqrt(radius * radius - distance_squared)
+                   : 0.0f;
+        stock->SetHeight(i, j, tip.z + dz);
+    }
+}
+
+float JobSimulation::StockVolume(){
+    double volume = 0.0;
+    for(float height : simulation_.height_map()->heights())
+        volume += GLToMillimeters(height);
+    return volume * std::fabs(spacing_.x * spacing_.y);
+}
+
+}
@@ -0,0 +1,24 @@
+#include "ifc/cutter/machining_time.h"
+
+namespace ifc {
+
+MachiningTimeEstimate EstimateMachiningTime(
+        const std::vector<Instruction>& instructions,
+        const MachiningFeedRates& feed_rates){
+    MachiningTimeEstimate estimate{0.0f, 0.0f, 0.0f};
+
+    for(unsigned int i = 1; i < instructions.size(); i++){
+        float distance = ifx::EuclideanDistance(instructions[i-1].position(),
+                                                instructions[i].position());
+        if(instructions[i].speed_mode() == InstructionSpeedMode::FAST){
+            estimate.fast_distance += distance;
+            estimate.time_s += distance / feed_rates.fast * 60.0f;
+        }else{
+            estimate.normal_distance += distance;
+            estimate.time_s += distance / feed_rates.normal * 60.0f;
+        }
+    }
+    return estimate;
+}
+
+}
@@ -0,0 +1,194 @@
+#include "ifc/cutter/program_verifier.h"
+
+#include <ifc/cutter/gouge_check.h>
+#include <ifc/geometry/distance_field.h>
+#include <ifc/parallel/task_graph.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/path_generation/link_optimizer.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+namespace ifc {
+
+std::string ToString(ProgramIssueType type){
+    switch(type){
+        case ProgramIssueType::GOUGE:
+            return "GOUGE";
+        case ProgramIssueType::FLAT_PLUNGE:
+            return "FLAT_PLUNGE";
+        case ProgramIssueType::RAPID_THROUGH_STOCK:
+            return "RAPID_THROUGH_STOCK";
+        case ProgramIssueType::MAX_DEPTH:
+            return "MAX_DEPTH";
+    }
+    return "UNKNOWN";
+}
+
+ProgramVerifier::ProgramVerifier(
+        std::shared_ptr<DistanceField> distance_field,
+        const MaterialBoxDimensions& dimensions,
+        HeightMap* stock) :
+        distance_field_(distance_field),
+        dimensions_(dimensions),
+        stock_(stock){}
+
+ProgramVerifier::~ProgramVerifier(){}
+
+ProgramVerification ProgramVerifier::Verify(
+        CutterType type, float diameter,
+        const std::vector<Instruction>& instructions,
+        ThreadPool& pool, int batch_size) const{
+    float radius = diameter / 2.0f;
+
+    // Stock under the whole cutter, not only its tip.
+    std::unique_ptr<LinkOptimizer> stock_map;
+    if(stock_)
+        stock_map.reset(new LinkOptimizer(stock_, radius, 0.0f));
+    std::function<float(const glm::vec3&)> stock_height;
+    if(stock_map){
+        LinkOptimizer* map = stock_map.get();
+        stock_height = [map](const glm::vec3& position){
+            return map->Clearance(position, position);
+        };
+    }else{
+        stock_height = [this, radius](const glm::vec3& position){
+            return InsideBox(position, radius) ? dimensions_.depth : -FLT_MAX;
+        };
+    }
+
+    std::vector<MoveCheck> checks(instructions.size());
+    int count = instructions.size();
+    TaskGraph graph;
+    for(int first = 0; first < count; first += batch_size){
+        int last = std::min(first + batch_size, count);
+        graph.AddTask(
+                "ProgramVerifier[" + std::to_string(first) + "]",
+                [this, &instructions, &checks, &stock_height,
+                        type, radius, first, last]{
+                    for(int i = first; i < last; i++){
+                        checks[i] = CheckMove(type, radius, instructions, i,
+                                              stock_height);
+                    }
+                });
+    }
+    graph.Run(pool);
+
+    ProgramVerification verification{std::vector<ProgramIssue>(),
+                                     std::vector<float>(count),
+                                     FLT_MAX, -1};
+    for(int i = 0; i < count; i++){
+        verification.clearances[i] = checks[i].clearance;
+        if(checks[i].clearance < verification.min_clearance){
+            verification.min_clearance = checks[i].clearance;
+            verification.min_clearance_instruction_id = instructions[i].id();
+        }
+        verification.issues.insert(verification.issues.end(),
+                                   checks[i].issues.begin(),
+                                   checks[i].issues.end());
+    }
+    return verification;
+}
+
+ProgramVerification ProgramVerifier::Verify(std::shared_ptr<Cutter> cutter,
+                                            ThreadPool& pool) const{
+    return Verify(cutter->type(), cutter->diameter(),
+                  cutter->instructions(), pool);
+}
+
+void ProgramVerifier::PrintReport(
+        const ProgramVerification& verification) const{
+    std::vector<ProgramIssueType> types = {
+            ProgramIssueType::GOUGE, ProgramIssueType::FLAT_PLUNGE,
+            ProgramIssueType::RAPID_THROUGH_STOCK, ProgramIssueType::MAX_DEPTH
+    };
+    for(auto type : types){
+        int count = std::count_if(verification.issues.begin(),
+                                  verification.issues.end(),
+                                  [type](const ProgramIssue& issue){
+                                      return issue.type == type;
+                                  });
+        std::cout << ToString(type) << ": " << count << std::endl;
+    }
+    int printed = std::min((int)verification.issues.size(),
+                           printed_issue_count_);
+    for(int i = 0; i < printed; i++){
+        auto& issue = verification.issues[i];
+        std::cout << "  " << ToString(issue.type) << " at instruction "
+        << issue.instruction_id << ": " << issue.value << " [mm]"
+        << std::endl;
+    }
+    std::cout << "Min clearance: " << verification.min_clearance
+    << " [mm] at instruction: " << verification.min_clearance_instruction_id
+    << std::endl;
+}
+
+ProgramVerifier::MoveCheck ProgramVerifier::CheckMove(
+        CutterType type, float radius,
+        const std::vector<Instruction>& instructions, int index,
+        const std::function<float(const glm::vec3&)>& stock_height) const{
+    const Instruction& instruction = instructions[index];
+    glm::vec3 end = instruction.position();
+    glm::vec3 start = index == 0 ? end : instructions[index - 1].position();
+    glm::vec3 delta = end - start;
+    float horizontal = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+    bool fast = instruction.speed_mode() == InstructionSpeedMode::FAST;
+    // Cutter leaves its own cut when retracting straight up.
+    bool retract = horizontal < 1e-3f && delta.z >= 0.0f;
+    bool plunge = horizontal < 1e-3f && delta.z < 0.0f;
+
+    float min_clearance = FLT_MAX;
+    float max_depth_violation = 0.0f;
+    float rapid_depth = 0.0f;
+    const float min_height = dimensions_.depth - dimensions_.max_depth
+                             - max_depth_tolerance_;
+
+    int samples = std::max((int)std::ceil(ifx::Magnitude(delta) / step_), 1);
+    // Start of the move is checked by the previous one.
+    for(int k = index == 0 ? samples : 1; k <= samples; k++){
+        glm::vec3 tip = start + ((float)k / samples) * delta;
+
+        min_clearance = std::min(min_clearance,
+                                 ToolClearance(*distance_field_,
+                                               type, radius, tip,
+                                               tolerance_));
+        if(InsideBox(tip, 0.0f) && tip.z < min_height)
+            max_depth_violation = std::max(max_depth_violation,
+                                           min_height - tip.z);
+        if(fast && !retract)
+            rapid_depth = std::max(rapid_depth,
+                                   stock_height(tip) - tip.z);
+    }
+
+    MoveCheck check{min_clearance, std::vector<ProgramIssue>()};
+    int id = instruction.id();
+    if(min_clearance < -tolerance_)
+        check.issues.push_back(ProgramIssue{ProgramIssueType::GOUGE,
+                                            id, -min_clearance});
+    if(type == CutterType::Flat && plunge){
+        float depth = stock_height(end) - end.z;
+        if(depth > tolerance_)
+            check.issues.push_back(ProgramIssue{
+                    ProgramIssueType::FLAT_PLUNGE, id, depth});
+    }
+    if(rapid_depth > tolerance_)
+        check.issues.push_back(ProgramIssue{
+                ProgramIssueType::RAPID_THROUGH_STOCK, id, rapid_depth});
+    if(max_depth_violation > 0.0f)
+        check.issues.push_back(ProgramIssue{ProgramIssueType::MAX_DEPTH,
+                                            id, max_depth_violation});
+    return check;
+}
+
+bool ProgramVerifier::InsideBox(const glm::vec3& position,
+                                float margin) const{
+    return position.x >= -dimensions_.x / 2.0f - margin
+           && position.x <= dimensions_.x / 2.0f + margin
+           && position.y >= -dimensions_.z / 2.0f - margin
+           && position.y <= dimensions_.z / 2.0f + margin;
+}
+
+}
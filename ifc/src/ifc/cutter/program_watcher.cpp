@@ -0,0 +1,67 @@
+#include "ifc/cutter/program_watcher.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+
+namespace ifc {
+
+int FirstChangedInstruction(const std::vector<Instruction>& previous,
+                            const std::vector<Instruction>& current){
+    int size = std::min(previous.size(), current.size());
+    for(int i = 0; i < size; i++){
+        if(previous[i].position() != current[i].position()
+           || previous[i].speed_mode() != current[i].speed_mode())
+            return i;
+    }
+    if(previous.size() == current.size())
+        return -1;
+    return size;
+}
+
+bool ProgramWatcher::FileState::operator==(const FileState& other) const{
+    return exists == other.exists
+           && modification_time == other.modification_time
+           && size == other.size;
+}
+
+bool ProgramWatcher::FileState::operator!=(const FileState& other) const{
+    return !(*this == other);
+}
+
+ProgramWatcher::ProgramWatcher(std::string filepath, float poll_interval_s) :
+        filepath_(filepath),
+        poll_interval_(poll_interval_s),
+        last_poll_(std::chrono::steady_clock::now()),
+        pending_(false){
+    state_ = Stat();
+}
+
+ProgramWatcher::~ProgramWatcher(){}
+
+bool ProgramWatcher::Changed(){
+    auto now = std::chrono::steady_clock::now();
+    if(now - last_poll_ < poll_interval_)
+        return false;
+    last_poll_ = now;
+
+    FileState state = Stat();
+    if(state != state_){
+        state_ = state;
+        pending_ = true;
+        return false;
+    }
+    if(!pending_ || !state_.exists)
+        return false;
+    pending_ = false;
+    return true;
+}
+
+ProgramWatcher::FileState ProgramWatcher::Stat(){
+    struct stat file_stat;
+    if(stat(filepath_.c_str(), &file_stat) != 0)
+        return FileState{false, 0, 0};
+    return FileState{true, file_stat.st_mtime, (long long)file_stat.st_size};
+}
+
+}
@@ -0,0 +1,139 @@
+#include "ifc/cutter/simulation_timeline.h"
+
+#include <ifc/material/height_map.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace ifc {
+
+SimulationTimeline::SimulationTimeline(HeightMap* height_map,
+                                       size_t memory_budget, int interval) :
+        memory_budget_(memory_budget),
+        memory_usage_(0),
+        interval_(interval){
+    last_heights_ = height_map->heights();
+    keyframes_.push_back(Keyframe{0, true, std::vector<int>(),
+                                  last_heights_});
+    memory_usage_ += Size(keyframes_.back());
+}
+
+SimulationTimeline::~SimulationTimeline(){}
+
+void SimulationTimeline::Record(int instruction, HeightMap* height_map){
+    if(instruction < keyframes_.back().instruction + interval_)
+        return;
+
+    const std::vector<float>& heights = height_map->heights();
+    Keyframe keyframe{instruction, false, std::vector<int>(),
+                      std::vector<float>()};
+    for(unsigned int i = 0; i < heights.size(); i++){
+        if(heights[i] != last_heights_[i]){
+            keyframe.cells.push_back(i);
+            keyframe.heights.push_back(heights[i]);
+        }
+    }
+    if(keyframe.cells.size() > heights.size() / 4){
+        keyframe.full = true;
+        keyframe.cells.clear();
+        keyframe.heights = heights;
+    }
+    last_heights_ = heights;
+
+    memory_usage_ += Size(keyframe);
+    keyframes_.push_back(std::move(keyframe));
+    if(memory_usage_ > memory_budget_)
+        Thin();
+}
+
+int SimulationTimeline::Restore(int instruction, HeightMap* height_map){
+    int last = 0;
+    while(last + 1 < (int)keyframes_.size()
+          && keyframes_[last + 1].instruction <= instruction)
+        last++;
+    int first = last;
+    while(!keyframes_[first].full)
+        first--;
+
+    std::vector<float>& heights = height_map->heights();
+    heights = keyframes_[first].heights;
+    for(int k = first + 1; k <= last; k++){
+        const Keyframe& keyframe = keyframes_[k];
+        for(unsigned int c = 0; c < keyframe.cells.size(); c++)
+            heights[keyframe.cells[c]] = keyframe.heights[c];
+    }
+    height_map->HeightsChanged();
+    return keyframes_[last].instruction;
+}
+
+int SimulationTimeline::Rewind(int instruction, HeightMap* height_map){
+    int restored = Restore(instruction, height_map);
+    while(keyframes_.back().instruction > restored){
+        memory_usage_ -= Size(keyframes_.back());
+        keyframes_.pop_back();
+    }
+    last_heights_ = height_map->heights();
+    return restored;
+}
+
+size_t SimulationTimeline::Size(const Keyframe& keyframe){
+    return keyframe.cells.size() * sizeof(int)
+           + keyframe.heights.size() * sizeof(float);
+}
+
+void SimulationTimeline::Merge(const Keyframe& keyframe, Keyframe& next){
+    if(next.full)
+        return;
+    std::vector<std::pair<int, float>> cells;
+    for(unsigned int c = 0; c < keyframe.cells.size(); c++)
+        cells.push_back(std::make_pair(keyframe.cells[c],
+                                       keyframe.heights[c]));
+    for(unsigned int c = 0; c < next.cells.size(); c++)
+        cells.push_back(std::make_pair(next.cells[c], next.heights[c]));
+    std::stable_sort(cells.begin(), cells.end(),
+                     [](const std::pair<int, float>& a,
+                        const std::pair<int, float>& b){
+                         return a.first < b.first;
+                     });
+
+    next.cells.clear();
+    next.heights.clear();
+    for(unsigned int c = 0; c < cells.size(); c++){
+        if(c + 1 < cells.size() && cells[c + 1].first == cells[c].first)
+            continue;
+        next.cells.push_back(cells[c].first);
+        next.heights.push_back(cells[c].second);
+    }
+}
+
+void SimulationTimeline::Thin(){
+    // First keyframe is the initial stock, the last one is last_heights_.
+    while(memory_usage_ > memory_budget_ && keyframes_.size() > 2){
+        std::vector<Keyframe> thinned;
+        thinned.push_back(std::move(keyframes_[0]));
+        for(unsigned int k = 1; k < keyframes_.size(); k++){
+            bool dropped = k % 2 == 1 && k + 1 < keyframes_.size();
+            if(dropped && !keyframes_[k].full)
+                Merge(keyframes_[k], keyframes_[k + 1]);
+            // Full keyframe is kept if the next one depends on it.
+            if(dropped && (!keyframes_[k].full || keyframes_[k + 1].full))
+                continue;
+            thinned.push_back(std::move(keyframes_[k]));
+        }
+        bool changed = thinned.size() < keyframes_.size();
+        keyframes_ = std::move(thinned);
+        if(!changed)
+            break;
+
+        memory_usage_ = 0;
+        for(auto& keyframe : keyframes_)
+            memory_usage_ += Size(keyframe);
+        interval_ *= 2;
+    }
+    std::cout << "SimulationTimeline: " << keyframes_.size()
+    << " keyframes, " << memory_usage_ << " [B], interval: " << interval_
+    << std::endl;
+}
+
+}
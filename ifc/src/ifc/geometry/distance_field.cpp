@@ -0,0 +1,336 @@
+#include "ifc/geometry/distance_field.h"
+
+#include <ifc/parallel/task_graph.h>
+#include <ifc/parallel/thread_pool.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+const std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+const char CACHE_MAGIC[4] = {'I', 'F', 'C', 'D'};
+
+// Bricks computed by a single task.
+const int BRICKS_PER_TASK = 16;
+}
+
+namespace ifc {
+
+DistanceField::DistanceField() :
+        cell_size_(1.0f),
+        band_(0.0f),
+        origin_(0, 0, 0){
+    brick_counts_[0] = brick_counts_[1] = brick_counts_[2] = 0;
+    top_counts_[0] = top_counts_[1] = 0;
+}
+
+DistanceField::DistanceField(const std::vector<Triangle>& triangles,
+                             float cell_size, float band,
+                             ThreadPool& pool) :
+        cell_size_(cell_size),
+        band_(band){
+    TriangleBVH bvh(triangles);
+
+    AABB bounds = AABB::Empty();
+    for(int i = 0; i < bvh.triangle_count(); i++)
+        bounds.Expand(bvh.bounds(i));
+    if(triangles.empty())
+        bounds = AABB{glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
+    glm::vec3 padding = glm::vec3(band_, band_, band_);
+    origin_ = bounds.min - padding;
+    glm::vec3 size = bounds.max + padding - origin_;
+    for(int k = 0; k < 3; k++){
+        brick_counts_[k] = std::max(
+                (int)std::ceil(size[k] / (cell_size_ * BRICK_CELLS)), 1);
+    }
+
+    ComputeTopHeights(bvh);
+
+    // Bricks within band of any triangle.
+    bricks_.assign(brick_counts_[0] * brick_counts_[1] * brick_counts_[2], -1);
+    std::vector<int> brick_positions;
+    float brick_size = cell_size_ * BRICK_CELLS;
+    int brick_count = 0;
+    for(int bz = 0; bz < brick_counts_[2]; bz++){
+        for(int by = 0; by < brick_counts_[1]; by++){
+            for(int bx = 0; bx < brick_counts_[0]; bx++){
+                glm::vec3 min = origin_ + brick_size * glm::vec3(bx, by, bz);
+                AABB box{min - padding,
+                         min + glm::vec3(brick_size, brick_size, brick_size)
+                         + padding};
+                std::vector<int> candidates;
+                bvh.FindTriangles(box, candidates);
+                if(candidates.empty())
+                    continue;
+                int index = (bz * brick_counts_[1] + by) * brick_counts_[0]
+                            + bx;
+                bricks_[index] = brick_count++;
+                brick_positions.push_back(index);
+            }
+        }
+    }
+    values_.resize(brick_count * BRICK_NODE_COUNT);
+
+    TaskGraph graph;
+    for(int first = 0; first < brick_count; first += BRICKS_PER_TASK){
+        int last = std::min(first + BRICKS_PER_TASK, brick_count);
+        graph.AddTask(
+                "DistanceField[" + std::to_string(first) + "]",
+                [this, &bvh, &brick_positions, first, last]{
+                    for(int brick = first; brick < last; brick++){
+                        int index = brick_positions[brick];
+                        int bx = index % brick_counts_[0];
+                        int by = (index / brick_counts_[0])
+                                 % brick_counts_[1];
+                        int bz = index / (brick_counts_[0]
+                                          * brick_counts_[1]);
+                        ComputeBrick(bvh, brick, bx, by, bz);
+                    }
+                });
+    }
+    graph.Run(pool);
+
+    std::cout << "DistanceField bricks: " << brick_count << " / "
+    << bricks_.size() << std::endl;
+}
+
+DistanceField::~DistanceField(){}
+
+std::shared_ptr<DistanceField> DistanceField::LoadOrBuild(
+        const std::vector<Triangle>& triangles,
+        float cell_size, float band, ThreadPool& pool,
+        std::string cache_prefix){
+    std::stringstream filename;
+    filename << cache_prefix << std::hex
+    << Hash(triangles, cell_size, band) << ".sdf";
+
+    auto distance_field = std::shared_ptr<DistanceField>(new DistanceField());
+    if(distance_field->Load(filename.str()))
+        return distance_field;
+
+    distance_field.reset(new DistanceField(triangles, cell_size, band, pool));
+    if(!distance_field->Save(filename.str())){
+        std::cout << "Could not save distance field: " << filename.str()
+        << std::endl;
+    }
+    return distance_field;
+}
+
+float DistanceField::Distance(const glm::vec3& position) const{
+    glm::vec3 grid = (position - origin_) / cell_size_;
+    int cell[3];
+    for(int k = 0; k < 3; k++){
+        if(!(grid[k] >= 0.0f && grid[k] < brick_counts_[k] * BRICK_CELLS))
+            return position.z < GetTopHeight(position) ? -band_ : band_;
+        cell[k] = (int)grid[k];
+    }
+    int bx = cell[0] / BRICK_CELLS;
+    int by = cell[1] / BRICK_CELLS;
+    int bz = cell[2] / BRICK_CELLS;
+    int brick = bricks_[(bz * brick_counts_[1] + by) * brick_counts_[0] + bx];
+    if(brick == -1)
+        return position.z < GetTopHeight(position) ? -band_ : band_;
+
+    int x = cell[0] - bx * BRICK_CELLS;
+    int y = cell[1] - by * BRICK_CELLS;
+    int z = cell[2] - bz * BRICK_CELLS;
+    float fx = grid.x - cell[0];
+    float fy = grid.y - cell[1];
+    float fz = grid.z - cell[2];
+
+    const float* v = &values_[brick * BRICK_NODE_COUNT
+                              + (z * BRICK_NODES + y) * BRICK_NODES + x];
+    const int dy = BRICK_NODES;
+    const int dz = BRICK_NODES * BRICK_NODES;
+    float c00 = v[0] + fx * (v[1] - v[0]);
+    float c10 = v[dy] + fx * (v[dy + 1] - v[dy]);
+    float c01 = v[dz] + fx * (v[dz + 1] - v[dz]);
+    float c11 = v[dz + dy] + fx * (v[dz + dy + 1] - v[dz + dy]);
+    float c0 = c00 + fy * (c10 - c00);
+    float c1 = c01 + fy * (c11 - c01);
+    return c0 + fz * (c1 - c0);
+}
+
+glm::vec3 DistanceField::Gradient(const glm::vec3& position) const{
+    float h = cell_size_ * 0.5f;
+    glm::vec3 gradient;
+    for(int k = 0; k < 3; k++){
+        glm::vec3 offset = glm::vec3(0, 0, 0);
+        offset[k] = h;
+        gradient[k] = (Distance(position + offset)
+                       - Distance(position - offset)) / (2.0f * h);
+    }
+    return gradient;
+}
+
+bool DistanceField::Save(std::string filename) const{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    int brick_count = bricks_.size();
+    int value_count = values_.size();
+    int top_count = top_heights_.size();
+    file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    file.write((const char*)&cell_size_, sizeof(cell_size_));
+    file.write((const char*)&band_, sizeof(band_));
+    file.write((const char*)&origin_.x, sizeof(float));
+    file.write((const char*)&origin_.y, sizeof(float));
+    file.write((const char*)&origin_.z, sizeof(float));
+    file.write((const char*)brick_counts_, sizeof(brick_counts_));
+    file.write((const char*)top_counts_, sizeof(top_counts_));
+    file.write((const char*)&brick_count, sizeof(brick_count));
+    file.write((const char*)&value_count, sizeof(value_count));
+    file.write((const char*)&top_count, sizeof(top_count));
+    file.write((const char*)bricks_.data(), brick_count * sizeof(int));
+    file.write((const char*)values_.data(), value_count * sizeof(float));
+    file.write((const char*)top_heights_.data(), top_count * sizeof(float));
+    return (bool)file;
+}
+
+bool DistanceField::Load(std::string filename){
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    char magic[4];
+    int brick_count = 0;
+    int value_count = 0;
+    int top_count = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&cell_size_, sizeof(cell_size_));
+    file.read((char*)&band_, sizeof(band_));
+    file.read((char*)&origin_.x, sizeof(float));
+    file.read((char*)&origin_.y, sizeof(float));
+    file.read((char*)&origin_.z, sizeof(float));
+    file.read((char*)brick_counts_, sizeof(brick_counts_));
+    file.read((char*)top_counts_, sizeof(top_counts_));
+    file.read((char*)&brick_count, sizeof(brick_count));
+    file.read((char*)&value_count, sizeof(value_count));
+    file.read((char*)&top_count, sizeof(top_count));
+    if(!file || std::string(magic, 4) != std::string(CACHE_MAGIC, 4)
+       || brick_count != brick_counts_[0] * brick_counts_[1]
+                         * brick_counts_[2]
+       || value_count < 0 || value_count % BRICK_NODE_COUNT != 0
+       || top_count != top_counts_[0] * top_counts_[1])
+        return false;
+
+    bricks_.resize(brick_count);
+    values_.resize(value_count);
+    top_heights_.resize(top_count);
+    file.read((char*)bricks_.data(), brick_count * sizeof(int));
+    file.read((char*)values_.data(), value_count * sizeof(float));
+    file.read((char*)top_heights_.data(), top_count * sizeof(float));
+    return (bool)file;
+}
+
+void DistanceField::ComputeTopHeights(const TriangleBVH& bvh){
+    top_counts_[0] = brick_counts_[0] * BRICK_CELLS + 1;
+    top_counts_[1] = brick_counts_[1] * BRICK_CELLS + 1;
+    top_heights_.resize(top_counts_[0] * top_counts_[1]);
+    for(int j = 0; j < top_counts_[1]; j++){
+        for(int i = 0; i < top_counts_[0]; i++){
+            glm::vec2 position = glm::vec2(origin_.x + i * cell_size_,
+                                           origin_.y + j * cell_size_);
+            top_heights_[j * top_counts_[0] + i] = TopHeight(bvh, position);
+        }
+    }
+}
+
+void DistanceField::ComputeBrick(const TriangleBVH& bvh, int brick,
+                                 int bx, int by, int bz){
+    float brick_size = cell_size_ * BRICK_CELLS;
+    glm::vec3 min = origin_ + brick_size * glm::vec3(bx, by, bz);
+    glm::vec3 padding = glm::vec3(band_, band_, band_);
+    AABB box{min - padding,
+             min + glm::vec3(brick_size, brick_size, brick_size) + padding};
+    std::vector<int> candidates;
+    bvh.FindTriangles(box, candidates);
+
+    float* values = &values_[brick * BRICK_NODE_COUNT];
+    for(int z = 0; z < BRICK_NODES; z++){
+        for(int y = 0; y < BRICK_NODES; y++){
+            for(int x = 0; x < BRICK_NODES; x++){
+                glm::vec3 position = min + cell_size_ * glm::vec3(x, y, z);
+                float distance_squared = band_ * band_;
+                for(int triangle : candidates){
+                    glm::vec3 to_triangle = ClosestPoint(
+                            bvh.triangle(triangle), position) - position;
+                    distance_squared = std::min(
+                            distance_squared,
+                            glm::dot(to_triangle, to_triangle));
+                }
+                float distance = std::sqrt(distance_squared);
+                if(position.z < GetTopHeight(position))
+                    distance = -distance;
+                values[(z * BRICK_NODES + y) * BRICK_NODES + x] = distance;
+            }
+        }
+    }
+}
+
+float DistanceField::TopHeight(const TriangleBVH& bvh,
+                               const glm::vec2& position){
+    std::vector<int> triangles;
+    bvh.FindTriangles(position, position, -FLT_MAX, triangles);
+
+    float height = -FLT_MAX;
+    for(int i : triangles){
+        const Triangle& triangle = bvh.triangle(i);
+        const glm::vec3& a = triangle.vertices[0];
+        const glm::vec3& b = triangle.vertices[1];
+        const glm::vec3& c = triangle.vertices[2];
+        float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+        if(std::fabs(area) < 1e-12f)
+            continue;
+        float u = ((b.x - position.x) * (c.y - position.y)
+                   - (c.x - position.x) * (b.y - position.y)) / area;
+        float v = ((c.x - position.x) * (a.y - position.y)
+                   - (a.x - position.x) * (c.y - position.y)) / area;
+        float w = 1.0f - u - v;
+        if(u < 0.0f || v < 0.0f || w < 0.0f)
+            continue;
+        height = std::max(height, u * a.z + v * b.z + w * c.z);
+    }
+    return height;
+}
+
+float DistanceField::GetTopHeight(const glm::vec3& position) const{
+    if(top_heights_.empty())
+        return -FLT_MAX;
+    int i = std::round((position.x - origin_.x) / cell_size_);
+    int j = std::round((position.y - origin_.y) / cell_size_);
+    i = std::min(std::max(i, 0), top_counts_[0] - 1);
+    j = std::min(std::max(j, 0), top_counts_[1] - 1);
+    return top_heights_[j * top_counts_[0] + i];
+}
+
+std::uint64_t DistanceField::Hash(const std::vector<Triangle>& triangles,
+                                  float cell_size, float band){
+    std::uint64_t hash = FNV_OFFSET;
+    auto add = [&hash](const void* data, int size){
+        const unsigned char* bytes = (const unsigned char*)data;
+        for(int i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+    };
+    add(&cell_size, sizeof(cell_size));
+    add(&band, sizeof(band));
+    for(auto& triangle : triangles){
+        for(int k = 0; k < 3; k++){
+            add(&triangle.vertices[k].x, sizeof(float));
+            add(&triangle.vertices[k].y, sizeof(float));
+            add(&triangle.vertices[k].z, sizeof(float));
+        }
+    }
+    return hash;
+}
+
+}
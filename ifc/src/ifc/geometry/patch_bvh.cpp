@@ -0,0 +1,470 @@
+#include "ifc/geometry/patch_bvh.h"
+
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace ifc {
+
+AABB AABB::Empty(){
+    float inf = std::numeric_limits<float>::max();
+    return AABB{glm::vec3(inf, inf, inf), glm::vec3(-inf, -inf, -inf)};
+}
+
+void AABB::Expand(const glm::vec3& point){
+    for(int k = 0; k < 3; k++){
+        min[k] = std::min(min[k], point[k]);
+        max[k] = std::max(max[k], point[k]);
+    }
+}
+
+void AABB::Expand(const AABB& box){
+    Expand(box.min);
+    Expand(box.max);
+}
+
+bool AABB::Overlaps(const AABB& box) const{
+    for(int k = 0; k < 3; k++){
+        if(max[k] < box.min[k] || box.max[k] < min[k])
+            return false;
+    }
+    return true;
+}
+
+AABB AABB::Intersection(const AABB& box) const{
+    AABB intersection;
+    for(int k = 0; k < 3; k++){
+        intersection.min[k] = std::max(min[k], box.min[k]);
+        intersection.max[k] = std::min(max[k], box.max[k]);
+    }
+    return intersection;
+}
+
+glm::vec3 AABB::Center() const{
+    return (min + max) * 0.5f;
+}
+
+int AABB::LongestAxis() const{
+    glm::vec3 size = max - min;
+    if(size.x >= size.y && size.x >= size.z)
+        return 0;
+    if(size.y >= size.z)
+        return 1;
+    return 2;
+}
+
+PatchBVH::PatchBVH(Surface* surface){
+    Matrix<BicubicBezierPatch*>& patches = surface->GetBicubicBezierPatches();
+    int n = patches.rowCount();
+    int m = patches.columnCount();
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            const glm::mat4& X = patches[i][j]->getX();
+            const glm::mat4& Y = patches[i][j]->getY();
+            const glm::mat4& Z = patches[i][j]->getZ();
+
+            Patch patch;
+            patch.bounds = AABB::Empty();
+            for(int k = 0; k < 4; k++){
+                for(int l = 0; l < 4; l++){
+                    patch.points[k][l] = glm::vec3(X[k][l], Y[k][l], Z[k][l]);
+                    patch.bounds.Expand(patch.points[k][l]);
+                }
+            }
+            patches_.push_back(patch);
+        }
+    }
+
+    patch_order_.resize(patches_.size());
+    std::iota(patch_order_.begin(), patch_order_.end(), 0);
+    if(!patches_.empty())
+        Build(0, patches_.size());
+
+    for(unsigned int patch = 0; patch < patches_.size(); patch++){
+        for(int k = 0; k <= seed_samples_; k++){
+            for(int l = 0; l <= seed_samples_; l++){
+                seeds_.push_back(Evaluate(patch,
+                                          (float)k / seed_samples_,
+                                          (float)l / seed_samples_));
+            }
+        }
+    }
+}
+
+PatchBVH::~PatchBVH(){}
+
+glm::vec3 PatchBVH::Evaluate(int patch, float u, float v) const{
+    float bu[4] = {(1-u)*(1-u)*(1-u), 3*u*(1-u)*(1-u), 3*u*u*(1-u), u*u*u};
+    float bv[4] = {(1-v)*(1-v)*(1-v), 3*v*(1-v)*(1-v), 3*v*v*(1-v), v*v*v};
+
+    glm::vec3 point = glm::vec3(0, 0, 0);
+    for(int k = 0; k < 4; k++){
+        for(int l = 0; l < 4; l++){
+            point += bu[k] * bv[l] * patches_[patch].points[k][l];
+        }
+    }
+    return point;
+}
+
+PatchPoint PatchBVH::EvaluateDerivatives(int patch, float u, float v) const{
+    // Bernstein basis and its first and second derivatives.
+    float bu[3][4] = {
+            {(1-u)*(1-u)*(1-u), 3*u*(1-u)*(1-u), 3*u*u*(1-u), u*u*u},
+            {-3*(1-u)*(1-u), 3*(1-u)*(1-3*u), 3*u*(2-3*u), 3*u*u},
+            {6*(1-u), 6*(3*u-2), 6*(1-3*u), 6*u}
+    };
+    float bv[3][4] = {
+            {(1-v)*(1-v)*(1-v), 3*v*(1-v)*(1-v), 3*v*v*(1-v), v*v*v},
+            {-3*(1-v)*(1-v), 3*(1-v)*(1-3*v), 3*v*(2-3*v), 3*v*v},
+            {6*(1-v), 6*(3*v-2), 6*(1-3*v), 6*v}
+    };
+
+    glm::vec3 zero = glm::vec3(0, 0, 0);
+    PatchPoint result{zero, zero, zero, zero, zero, zero};
+    for(int k = 0; k < 4; k++){
+        for(int l = 0; l < 4; l++){
+            const glm::vec3& point = patches_[patch].points[k][l];
+            result.point += bu[0][k] * bv[0][l] * point;
+            result.du += bu[1][k] * bv[0][l] * point;
+            result.dv += bu[0][k] * bv[1][l] * point;
+            result.duu += bu[2][k] * bv[0][l] * point;
+            result.duv += bu[1][k] * bv[1][l] * point;
+            result.dvv += bu[0][k] * bv[2][l] * point;
+        }
+    }
+    return result;
+}
+
+PatchProjection PatchBVH::Project(const glm::vec3& point,
+                                  float max_distance) const{
+    PatchProjection projection{-1, glm::vec2(0, 0), point, max_distance};
+    if(nodes_.empty())
+        return projection;
+
+    auto box_distance = [&point](const AABB& box){
+        glm::vec3 d;
+        for(int k = 0; k < 3; k++){
+            d[k] = std::max(std::max(box.min[k] - point[k],
+                                     point[k] - box.max[k]), 0.0f);
+        }
+        return glm::length(d);
+    };
+
+    // Depth first, closer child first; pruned by the best distance so far.
+    std::vector<std::pair<float, int>> stack;
+    stack.push_back(std::make_pair(box_distance(nodes_[0].bounds), 0));
+    while(!stack.empty()){
+        std::pair<float, int> top = stack.back();
+        stack.pop_back();
+        if(top.first >= projection.distance)
+            continue;
+        const Node& node = nodes_[top.second];
+        if(node.left == -1){
+            for(int k = node.first; k < node.first + node.count; k++){
+                int patch = patch_order_[k];
+                if(box_distance(patches_[patch].bounds) < projection.distance)
+                    ProjectOnPatch(point, patch, projection);
+            }
+            continue;
+        }
+        float left = box_distance(nodes_[node.left].bounds);
+        float right = box_distance(nodes_[node.right].bounds);
+        if(left < right){
+            stack.push_back(std::make_pair(right, node.right));
+            stack.push_back(std::make_pair(left, node.left));
+        }else{
+            stack.push_back(std::make_pair(left, node.left));
+            stack.push_back(std::make_pair(right, node.right));
+        }
+    }
+    return projection;
+}
+
+std::vector<std::pair<int, int>> PatchBVH::FindOverlaps(PatchBVH& other){
+    std::vector<std::pair<int, int>> overlaps;
+    if(!nodes_.empty() && !other.nodes_.empty())
+        FindOverlaps(other, 0, 0, overlaps);
+    return overlaps;
+}
+
+int PatchBVH::Build(int first, int count){
+    int index = nodes_.size();
+    nodes_.push_back(Node{AABB::Empty(), -1, -1, first, count});
+
+    AABB bounds = AABB::Empty();
+    AABB centers = AABB::Empty();
+    for(int k = first; k < first + count; k++){
+        bounds.Expand(patches_[patch_order_[k]].bounds);
+        centers.Expand(patches_[patch_order_[k]].bounds.Center());
+    }
+    nodes_[index].bounds = bounds;
+    if(count <= max_leaf_size_)
+        return index;
+
+    // Median split along the longest axis of centers.
+    int axis = centers.LongestAxis();
+    int half = count / 2;
+    std::nth_element(patch_order_.begin() + first,
+                     patch_order_.begin() + first + half,
+                     patch_order_.begin() + first + count,
+                     [this, axis](int a, int b){
+                         return patches_[a].bounds.Center()[axis]
+                                < patches_[b].bounds.Center()[axis];
+                     });
+    int left = Build(first, half);
+    int right = Build(first + half, count - half);
+    nodes_[index].left = left;
+    nodes_[index].right = right;
+    return index;
+}
+
+void PatchBVH::ProjectOnPatch(const glm::vec3& point, int patch,
+                              PatchProjection& projection) const{
+    // Seed from the closest point of the coarse grid.
+    const int samples = seed_samples_ + 1;
+    const glm::vec3* seeds = &seeds_[patch * samples * samples];
+    int closest = 0;
+    float min_distance_squared = FLT_MAX;
+    for(int k = 0; k < samples * samples; k++){
+        glm::vec3 d = seeds[k] - point;
+        float distance_squared = glm::dot(d, d);
+        if(distance_squared < min_distance_squared){
+            min_distance_squared = distance_squared;
+            closest = k;
+        }
+    }
+    float min_distance = std::sqrt(min_distance_squared);
+    float u = (float)(closest / samples) / seed_samples_;
+    float v = (float)(closest % samples) / seed_samples_;
+
+    // Newton iteration on |S(u,v) - point|^2 / 2, kept inside the patch.
+    // The best iterate is kept, Newton may leave the basin of the seed.
+    float best_u = u;
+    float best_v = v;
+    float distance = min_distance;
+    glm::vec3 closest_point = seeds[closest];
+    for(int i = 0; i < newton_iterations_; i++){
+        PatchPoint s = EvaluateDerivatives(patch, u, v);
+        glm::vec3 r = s.point - point;
+        float current_distance = glm::length(r);
+        if(current_distance < distance){
+            distance = current_distance;
+            closest_point = s.point;
+            best_u = u;
+            best_v = v;
+        }
+
+        float gu = glm::dot(s.du, r);
+        float gv = glm::dot(s.dv, r);
+        float huu = glm::dot(s.du, s.du) + glm::dot(s.duu, r);
+        float huv = glm::dot(s.du, s.dv) + glm::dot(s.duv, r);
+        float hvv = glm::dot(s.dv, s.dv) + glm::dot(s.dvv, r);
+        if(huu <= 0.0f || hvv <= 0.0f || huu * hvv - huv * huv <= 1e-12f){
+            // Not convex here, Gauss-Newton (first derivatives only).
+            huu = glm::dot(s.du, s.du);
+            huv = glm::dot(s.du, s.dv);
+            hvv = glm::dot(s.dv, s.dv);
+        }
+
+        // Parameter held at the border of the patch is left out.
+        bool u_fixed = (u <= 0.0f && gu > 0.0f) || (u >= 1.0f && gu < 0.0f);
+        bool v_fixed = (v <= 0.0f && gv > 0.0f) || (v >= 1.0f && gv < 0.0f);
+        float step_u = 0.0f;
+        float step_v = 0.0f;
+        if(!u_fixed && !v_fixed){
+            float determinant = huu * hvv - huv * huv;
+            if(determinant <= 1e-12f)
+                break;
+            step_u = (hvv * gu - huv * gv) / determinant;
+            step_v = (huu * gv - huv * gu) / determinant;
+        }else if(!u_fixed && huu > 1e-12f){
+            step_u = gu / huu;
+        }else if(!v_fixed && hvv > 1e-12f){
+            step_v = gv / hvv;
+        }
+        float next_u = std::min(std::max(u - step_u, 0.0f), 1.0f);
+        float next_v = std::min(std::max(v - step_v, 0.0f), 1.0f);
+        if(std::fabs(next_u - u) < 1e-6f && std::fabs(next_v - v) < 1e-6f)
+            break;
+        u = next_u;
+        v = next_v;
+    }
+    glm::vec3 last_point = Evaluate(patch, u, v);
+    if(glm::length(last_point - point) < distance){
+        distance = glm::length(last_point - point);
+        closest_point = last_point;
+        best_u = u;
+        best_v = v;
+    }
+    u = best_u;
+    v = best_v;
+
+    if(distance < projection.distance){
+        projection.patch = patch;
+        projection.params = glm::vec2(u, v);
+        projection.point = closest_point;
+        projection.distance = distance;
+    }
+}
+
+void PatchBVH::FindOverlaps(PatchBVH& other, int node, int other_node,
+                            std::vector<std::pair<int, int>>& overlaps){
+    const Node& a = nodes_[node];
+    const Node& b = other.nodes_[other_node];
+    if(!a.bounds.Overlaps(b.bounds))
+        return;
+
+    bool is_a_leaf = a.left == -1;
+    bool is_b_leaf = b.left == -1;
+    if(is_a_leaf && is_b_leaf){
+        for(int i = a.first; i < a.first + a.count; i++){
+            for(int j = b.first; j < b.first + b.count; j++){
+                int patch = patch_order_[i];
+                int other_patch = other.patch_order_[j];
+                if(patches_[patch].bounds.Overlaps(
+                        other.patches_[other_patch].bounds)){
+                    overlaps.push_back(std::make_pair(patch, other_patch));
+                }
+            }
+        }
+        return;
+    }
+    // Descend into the larger node.
+    glm::vec3 size_a = a.bounds.max - a.bounds.min;
+    glm::vec3 size_b = b.bounds.max - b.bounds.min;
+    if(is_b_leaf || (!is_a_leaf && glm::length(size_a) >= glm::length(size_b))){
+        int left = a.left;
+        int right = a.right;
+        FindOverlaps(other, left, other_node, overlaps);
+        FindOverlaps(other, right, other_node, overlaps);
+    }else{
+        int left = b.left;
+        int right = b.right;
+        FindOverlaps(other, node, left, overlaps);
+        FindOverlaps(other, node, right, overlaps);
+    }
+}
+
+namespace {
+
+int FindRoot(std::vector<int>& parents, int i){
+    while(parents[i] != i){
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+/**
+ * Closest points of two patches found by coarse sampling,
+ * refined by pattern search over (u1, v1, u2, v2).
+ */
+float ClosestPoints(PatchBVH& bvh1, int patch1,
+                    PatchBVH& bvh2, int patch2,
+                    glm::vec3& point1, glm::vec3& point2){
+    const int samples = 6;
+    float params[4] = {0, 0, 0, 0};
+    float min_distance = std::numeric_limits<float>::max();
+    for(int i1 = 0; i1 <= samples; i1++){
+        for(int j1 = 0; j1 <= samples; j1++){
+            float u1 = (float)i1 / samples;
+            float v1 = (float)j1 / samples;
+            glm::vec3 p1 = bvh1.Evaluate(patch1, u1, v1);
+            for(int i2 = 0; i2 <= samples; i2++){
+                for(int j2 = 0; j2 <= samples; j2++){
+                    float u2 = (float)i2 / samples;
+                    float v2 = (float)j2 / samples;
+                    float distance = glm::length(
+                            p1 - bvh2.Evaluate(patch2, u2, v2));
+                    if(distance < min_distance){
+                        min_distance = distance;
+                        params[0] = u1; params[1] = v1;
+                        params[2] = u2; params[3] = v2;
+                    }
+                }
+            }
+        }
+    }
+
+    float step = 1.0f / samples;
+    while(step > 1e-4f){
+        bool improved = false;
+        for(int k = 0; k < 4; k++){
+            for(float direction : {-1.0f, 1.0f}){
+                float candidate[4] = {params[0], params[1],
+                                      params[2], params[3]};
+                candidate[k] = std::min(std::max(
+                        candidate[k] + direction * step, 0.0f), 1.0f);
+                float distance = glm::length(
+                        bvh1.Evaluate(patch1, candidate[0], candidate[1])
+                        - bvh2.Evaluate(patch2, candidate[2], candidate[3]));
+                if(distance < min_distance){
+                    min_distance = distance;
+                    std::copy(candidate, candidate + 4, params);
+                    improved = true;
+                }
+            }
+        }
+        if(!improved)
+            step /= 2.0f;
+    }
+    point1 = bvh1.Evaluate(patch1, params[0], params[1]);
+    point2 = bvh2.Evaluate(patch2, params[2], params[3]);
+    return min_distance;
+}
+
+}
+
+std::vector<glm::vec3> FindIntersectionSeeds(PatchBVH& bvh1, PatchBVH& bvh2,
+                                             float tolerance){
+    auto overlaps = bvh1.FindOverlaps(bvh2);
+    int count = overlaps.size();
+
+    // Pairs with overlapping common part belong to the same component.
+    std::vector<AABB> common(count);
+    for(int i = 0; i < count; i++){
+        common[i] = bvh1.bounds(overlaps[i].first).Intersection(
+                bvh2.bounds(overlaps[i].second));
+    }
+    std::vector<int> parents(count);
+    std::iota(parents.begin(), parents.end(), 0);
+    for(int i = 0; i < count; i++){
+        for(int j = i + 1; j < count; j++){
+            if(common[i].Overlaps(common[j]))
+                parents[FindRoot(parents, i)] = FindRoot(parents, j);
+        }
+    }
+
+    // Closest pair of points in each component.
+    std::vector<float> min_distances(count, std::numeric_limits<float>::max());
+    std::vector<glm::vec3> seeds(count);
+    for(int i = 0; i < count; i++){
+        glm::vec3 point1, point2;
+        float distance = ClosestPoints(bvh1, overlaps[i].first,
+                                       bvh2, overlaps[i].second,
+                                       point1, point2);
+        int root = FindRoot(parents, i);
+        if(distance < min_distances[root]){
+            min_distances[root] = distance;
+            seeds[root] = (point1 + point2) * 0.5f;
+        }
+    }
+
+    std::vector<glm::vec3> component_seeds;
+    for(int i = 0; i < count; i++){
+        // Bounds overlap, but surfaces do not meet.
+        if(FindRoot(parents, i) == i && min_distances[i] <= tolerance)
+            component_seeds.push_back(seeds[i]);
+    }
+    std::cout << "Overlapping patches: " << count
+    << ", Intersection seeds: " << component_seeds.size() << std::endl;
+
+    return component_seeds;
+}
+
+}
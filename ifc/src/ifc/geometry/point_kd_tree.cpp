@@ -0,0 +1,173 @@
+#include "ifc/geometry/point_kd_tree.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ifc {
+
+PointKDTree::PointKDTree(const std::vector<glm::vec3>& points) :
+        points_(points){
+    order_.resize(points_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    axes_.resize(points_.size(), 0);
+    Build(0, points_.size());
+}
+
+PointKDTree::~PointKDTree(){}
+
+bool PointKDTree::HasPointWithin(const glm::vec3& position,
+                                 float radius) const{
+    return HasPointWithin(0, order_.size(), position, radius * radius);
+}
+
+std::vector<int> PointKDTree::FindWithin(const glm::vec3& position,
+                                         float radius) const{
+    std::vector<int> found;
+    FindWithin(0, order_.size(), position, radius * radius, found);
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+int PointKDTree::FindNearest(const glm::vec3& position) const{
+    int nearest = -1;
+    float nearest_distance_squared = std::numeric_limits<float>::max();
+    FindNearest(0, order_.size(), position,
+                nearest, nearest_distance_squared);
+    return nearest;
+}
+
+void PointKDTree::Build(int first, int last){
+    if(last - first <= 1)
+        return;
+
+    // Split along the axis of the largest spread.
+    glm::vec3 min = points_[order_[first]];
+    glm::vec3 max = min;
+    for(int i = first + 1; i < last; i++){
+        const glm::vec3& p = points_[order_[i]];
+        for(int k = 0; k < 3; k++){
+            min[k] = std::min(min[k], p[k]);
+            max[k] = std::max(max[k], p[k]);
+        }
+    }
+    glm::vec3 spread = max - min;
+    int axis = 0;
+    if(spread.y > spread[axis])
+        axis = 1;
+    if(spread.z > spread[axis])
+        axis = 2;
+
+    int middle = (first + last) / 2;
+    std::nth_element(order_.begin() + first,
+                     order_.begin() + middle,
+                     order_.begin() + last,
+                     [this, axis](int a, int b){
+                         return points_[a][axis] < points_[b][axis];
+                     });
+    axes_[middle] = axis;
+
+    Build(first, middle);
+    Build(middle + 1, last);
+}
+
+bool PointKDTree::HasPointWithin(int first, int last,
+                                 const glm::vec3& position,
+                                 float radius_squared) const{
+    if(first >= last)
+        return false;
+    int middle = (first + last) / 2;
+    if(DistanceSquared(order_[middle], position) <= radius_squared)
+        return true;
+
+    int axis = axes_[middle];
+    float difference = position[axis] - points_[order_[middle]][axis];
+    bool is_left_first = difference < 0;
+    if(HasPointWithin(is_left_first ? first : middle + 1,
+                      is_left_first ? middle : last,
+                      position, radius_squared))
+        return true;
+    if(difference * difference <= radius_squared){
+        return HasPointWithin(is_left_first ? middle + 1 : first,
+                              is_left_first ? last : middle,
+                              position, radius_squared);
+    }
+    return false;
+}
+
+void PointKDTree::FindWithin(int first, int last, const glm::vec3& position,
+                             float radius_squared,
+                             std::vector<int>& found) const{
+    if(first >= last)
+        return;
+    int middle = (first + last) / 2;
+    if(DistanceSquared(order_[middle], position) <= radius_squared)
+        found.push_back(order_[middle]);
+
+    int axis = axes_[middle];
+    float difference = position[axis] - points_[order_[middle]][axis];
+    if(difference <= 0 || difference * difference <= radius_squared)
+        FindWithin(first, middle, position, radius_squared, found);
+    if(difference >= 0 || difference * difference <= radius_squared)
+        FindWithin(middle + 1, last, position, radius_squared, found);
+}
+
+void PointKDTree::FindNearest(int first, int last, const glm::vec3& position,
+                              int& nearest,
+                              float& nearest_distance_squared) const{
+    if(first >= last)
+        return;
+    int middle = (first + last) / 2;
+    int index = order_[middle];
+    float distance_squared = DistanceSquared(index, position);
+    if(distance_squared < nearest_distance_squared
+       || (distance_squared == nearest_distance_squared && index < nearest)){
+        nearest_distance_squared = distance_squared;
+        nearest = index;
+    }
+
+    int axis = axes_[middle];
+    float difference = position[axis] - points_[index][axis];
+    bool is_left_first = difference < 0;
+    FindNearest(is_left_first ? first : middle + 1,
+                is_left_first ? middle : last,
+                position, nearest, nearest_distance_squared);
+    // Equal distance can still give smaller index.
+    if(difference * difference <= nearest_distance_squared){
+        FindNearest(is_left_first ? middle + 1 : first,
+                    is_left_first ? last : middle,
+                    position, nearest, nearest_distance_squared);
+    }
+}
+
+float PointKDTree::DistanceSquared(int index, const glm::vec3& position) const{
+    glm::vec3 d = points_[index] - position;
+    return d.x*d.x + d.y*d.y + d.z*d.z;
+}
+
+ClosestPair FindClosestPair(const std::vector<glm::vec3>& points1,
+                            const std::vector<glm::vec3>& points2,
+                            int first2, int last2){
+    ClosestPair closest_pair{-1, -1, std::numeric_limits<float>::max()};
+    first2 = std::max(first2, 0);
+    last2 = std::min(last2, (int)points2.size());
+    if(first2 >= last2)
+        return closest_pair;
+
+    PointKDTree tree(std::vector<glm::vec3>(points2.begin() + first2,
+                                            points2.begin() + last2));
+    for(unsigned int i = 0; i < points1.size(); i++){
+        int nearest = tree.FindNearest(points1[i]);
+        if(nearest == -1)
+            continue;
+        float distance = glm::length(tree.point(nearest) - points1[i]);
+        if(distance < closest_pair.distance){
+            closest_pair.index1 = i;
+            closest_pair.index2 = first2 + nearest;
+            closest_pair.distance = distance;
+        }
+    }
+    return closest_pair;
+}
+
+}
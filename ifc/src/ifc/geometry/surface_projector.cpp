@@ -0,0 +1,55 @@
+#include "ifc/geometry/surface_projector.h"
+
+#include <ifc/parallel/task_graph.h>
+#include <ifc/parallel/thread_pool.h>
+
+#include <algorithm>
+#include <string>
+
+namespace ifc {
+
+SurfaceProjector::SurfaceProjector(const std::vector<Surface*>& surfaces){
+    for(auto surface : surfaces)
+        bvhs_.push_back(std::unique_ptr<PatchBVH>(new PatchBVH(surface)));
+}
+
+SurfaceProjector::~SurfaceProjector(){}
+
+SurfaceProjection SurfaceProjector::Project(const glm::vec3& point) const{
+    SurfaceProjection projection{-1, -1, glm::vec2(0, 0), point, FLT_MAX};
+    for(unsigned int i = 0; i < bvhs_.size(); i++){
+        // Only closer points than found on previous surfaces.
+        PatchProjection patch_projection
+                = bvhs_[i]->Project(point, projection.distance);
+        if(patch_projection.patch == -1)
+            continue;
+        projection = SurfaceProjection{(int)i, patch_projection.patch,
+                                       patch_projection.params,
+                                       patch_projection.point,
+                                       patch_projection.distance};
+    }
+    return projection;
+}
+
+std::vector<SurfaceProjection> SurfaceProjector::Project(
+        const std::vector<glm::vec3>& points,
+        ThreadPool& pool, int batch_size) const{
+    std::vector<SurfaceProjection> projections(points.size());
+    int count = points.size();
+
+    TaskGraph graph;
+    for(int first = 0; first < count; first += batch_size){
+        int last = std::min(first + batch_size, count);
+        graph.AddTask(
+                "SurfaceProjector[" + std::to_string(first) + "]",
+                [this, &points, &projections, first, last]{
+                    for(int i = first; i < last; i++)
+                        projections[i] = Project(points[i]);
+                });
+    }
+    graph.Run(pool);
+
+    return projections;
+}
+
+}
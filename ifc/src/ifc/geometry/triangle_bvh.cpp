@@ -0,0 +1,161 @@
+#include "ifc/geometry/triangle_bvh.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ifc {
+
+glm::vec3 ClosestPoint(const Triangle& triangle, const glm::vec3& point){
+    // Voronoi regions of vertices, edges and the face.
+    const glm::vec3& a = triangle.vertices[0];
+    const glm::vec3& b = triangle.vertices[1];
+    const glm::vec3& c = triangle.vertices[2];
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+
+    glm::vec3 ap = point - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if(d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    glm::vec3 bp = point - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if(d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + (d1 / (d1 - d3)) * ab;
+
+    glm::vec3 cp = point - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if(d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + (d2 / (d2 - d6)) * ac;
+
+    float va = d3 * d6 - d5 * d4;
+    if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+
+    float denominator = va + vb + vc;
+    if(denominator <= 0.0f)
+        return a;
+    float v = vb / denominator;
+    float w = vc / denominator;
+    return a + v * ab + w * ac;
+}
+
+TriangleBVH::TriangleBVH(const std::vector<Triangle>& triangles) :
+        triangles_(triangles){
+    bounds_.resize(triangles_.size());
+    for(unsigned int i = 0; i < triangles_.size(); i++){
+        bounds_[i] = AABB::Empty();
+        for(int k = 0; k < 3; k++)
+            bounds_[i].Expand(triangles_[i].vertices[k]);
+    }
+
+    triangle_order_.resize(triangles_.size());
+    std::iota(triangle_order_.begin(), triangle_order_.end(), 0);
+    if(!triangles_.empty())
+        Build(0, triangles_.size());
+}
+
+TriangleBVH::~TriangleBVH(){}
+
+void TriangleBVH::FindTriangles(const glm::vec2& min, const glm::vec2& max,
+                                float min_height,
+                                std::vector<int>& triangles) const{
+    if(nodes_.empty())
+        return;
+
+    auto is_overlapping = [&min, &max, min_height](const AABB& box){
+        return box.min.x <= max.x && min.x <= box.max.x
+               && box.min.y <= max.y && min.y <= box.max.y
+               && box.max.z >= min_height;
+    };
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()){
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if(!is_overlapping(node.bounds))
+            continue;
+        if(node.left != -1){
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            continue;
+        }
+        for(int k = node.first; k < node.first + node.count; k++){
+            int triangle = triangle_order_[k];
+            if(is_overlapping(bounds_[triangle]))
+                triangles.push_back(triangle);
+        }
+    }
+}
+
+void TriangleBVH::FindTriangles(const AABB& box,
+                                std::vector<int>& triangles) const{
+    if(nodes_.empty())
+        return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()){
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if(!node.bounds.Overlaps(box))
+            continue;
+        if(node.left != -1){
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            continue;
+        }
+        for(int k = node.first; k < node.first + node.count; k++){
+            int triangle = triangle_order_[k];
+            if(bounds_[triangle].Overlaps(box))
+                triangles.push_back(triangle);
+        }
+    }
+}
+
+int TriangleBVH::Build(int first, int count){
+    int index = nodes_.size();
+    nodes_.push_back(Node{AABB::Empty(), -1, -1, first, count});
+
+    AABB bounds = AABB::Empty();
+    AABB centers = AABB::Empty();
+    for(int k = first; k < first + count; k++){
+        bounds.Expand(bounds_[triangle_order_[k]]);
+        centers.Expand(bounds_[triangle_order_[k]].Center());
+    }
+    nodes_[index].bounds = bounds;
+    if(count <= max_leaf_size_)
+        return index;
+
+    // Median split along the longest (x, y) axis of centers,
+    // queries are vertical.
+    glm::vec3 size = centers.max - centers.min;
+    int axis = size.x >= size.y ? 0 : 1;
+    int half = count / 2;
+    std::nth_element(triangle_order_.begin() + first,
+                     triangle_order_.begin() + first + half,
+                     triangle_order_.begin() + first + count,
+                     [this, axis](int a, int b){
+                         return bounds_[a].Center()[axis]
+                                < bounds_[b].Center()[axis];
+                     });
+    int left = Build(first, half);
+    int right = Build(first + half, count - half);
+    nodes_[index].left = left;
+    nodes_[index].right = right;
+    return index;
+}
+
+}
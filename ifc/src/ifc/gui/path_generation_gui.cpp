@@ -2,12 +2,21 @@
 
 #include <gui/imgui/imgui.h>
 #include <ifc/cutter/cutter.h>
+#include <ifc/cutter/cutter_loader.h>
+#include <ifc/cutter/program_verifier.h>
+#include <ifc/geometry/distance_field.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/path_generation/drop_cutter.h>
 #include <ifc/factory/cad_model_loader.h>
 #include <ifc/path_generation/path_generator.h>
+#include <ifc/path_generation/intersection_service.h>
 #include <ifc/material/material_box.h>
+#include <ifc/material/deviation_map.h>
 #include <ifc/cutter/cutter_simulation.h>
 #include <rendering/scene/scene.h>
 
+#include <iostream>
+
 namespace ifc {
 
 PathGenerationGUI::PathGenerationGUI(
@@ -37,6 +46,11 @@ void PathGenerationGUI::RenderMainWindow(){
         ImGui::TreePop();
     }
 
+    if(ImGui::TreeNode("Verify Program")){
+        RenderProgramVerification();
+        ImGui::TreePop();
+    }
+
     if(ImGui::TreeNode("Signature")){
         GenerateSignaturePath();
         ImGui::TreePop();
@@ -53,6 +67,8 @@ void PathGenerationGUI::RenderLoadModel(){
     if (ImGui::Button("Load Model")) {
         CADModelLoader cad_model_loader;
         cad_model_loader_result_ = cad_model_loader.Load(filepath);
+        intersection_service_.reset(
+                new IntersectionService(cad_model_loader_result_));
 
         scene_->AddRenderObject(
                 cad_model_loader_result_->cad_model->render_object);
@@ -79,15 +95,17 @@ void PathGenerationGUI::RenderPathGeneration(){
             path_generator_.reset(new PathGenerator(
                     cad_model_loader_result_,
                     simulation_->material_box(),
-                    scene_));
-            auto paths = path_generator_->GenerateAll();
-
-            paths.rough_cutter->SaveToFile(filepath_1);
-            paths.flat_heighmap_cutter->SaveToFile(filepath_2);
-            if(paths.flat_intersection_cutter)
-                paths.flat_intersection_cutter->SaveToFile(filepath_3);
-            if(paths.parametrization_cutter)
-                paths.parametrization_cutter->SaveToFile(filepath_4);
+                    scene_, intersection_service_));
+            PathFilenames filenames;
+            filenames.rough = filepath_1;
+            filenames.flat_heighmap = filepath_2;
+            filenames.flat_intersection = filepath_3;
+            filenames.parametrization = filepath_4;
+            Paths paths = path_generator_->GenerateAll(filenames);
+            previous_cutters_ = {paths.rough_cutter,
+                                 paths.flat_heighmap_cutter,
+                                 paths.flat_intersection_cutter,
+                                 paths.parametrization_cutter};
         }
     }
 
@@ -97,7 +115,7 @@ void PathGenerationGUI::RenderPathGeneration(){
                 path_generator_.reset(new PathGenerator(
                         cad_model_loader_result_,
                         simulation_->material_box(),
-                        scene_));
+                        scene_, intersection_service_));
                 auto cutter = path_generator_->GenerateRoughingPath();
                 cutter->SaveToFile(filepath_1);
             }
@@ -107,6 +125,27 @@ void PathGenerationGUI::RenderPathGeneration(){
         ImGui::TreePop();
     }
 
+    if(ImGui::TreeNode("Z-Level Roughing Path")) {
+        static char filepath_z_level[size] = "jc_t1_z";
+        static float step_down = 10.0f;
+        if (ImGui::Button("Generate")) {
+            if(cad_model_loader_result_){
+                path_generator_.reset(new PathGenerator(
+                        cad_model_loader_result_,
+                        simulation_->material_box(),
+                        scene_, intersection_service_));
+                auto cutter
+                        = path_generator_->GenerateZLevelRoughingPath(
+                                step_down);
+                cutter->SaveToFile(filepath_z_level);
+            }
+        }
+        ImGui::SameLine();
+        ImGui::InputText("filename", filepath_z_level, size);
+        ImGui::SliderFloat("step down [mm]", &step_down, 1.0f, 30.0f);
+        ImGui::TreePop();
+    }
+
     if(ImGui::TreeNode("Flat Heightmap Path")) {
 
         if (ImGui::Button("Generate")) {
@@ -114,7 +153,7 @@ void PathGenerationGUI::RenderPathGeneration(){
                 path_generator_.reset(new PathGenerator(
                         cad_model_loader_result_,
                         simulation_->material_box(),
-                        scene_));
+                        scene_, intersection_service_));
                 auto cutter = path_generator_->GenerateFlatHeightmapPath();
                 cutter->SaveToFile(filepath_2);
             }
@@ -124,6 +163,23 @@ void PathGenerationGUI::RenderPathGeneration(){
         ImGui::TreePop();
     }
 
+    if(ImGui::TreeNode("Contour Flat Path")) {
+        static char filepath_contour[size] = "jc_t2_c";
+        if (ImGui::Button("Generate")) {
+            if(cad_model_loader_result_){
+                path_generator_.reset(new PathGenerator(
+                        cad_model_loader_result_,
+                        simulation_->material_box(),
+                        scene_, intersection_service_));
+                auto cutter = path_generator_->GenerateContourFlatPath();
+                cutter->SaveToFile(filepath_contour);
+            }
+        }
+        ImGui::SameLine();
+        ImGui::InputText("filename", filepath_contour, size);
+        ImGui::TreePop();
+    }
+
     if(ImGui::TreeNode("Flat Intersection Box Path")) {
 
         if (ImGui::Button("Generate")) {
@@ -131,7 +187,7 @@ void PathGenerationGUI::RenderPathGeneration(){
                 path_generator_.reset(new PathGenerator(
                         cad_model_loader_result_,
                         simulation_->material_box(),
-                        scene_));
+                        scene_, intersection_service_));
                 auto cutter = path_generator_->GenerateFlatIntersectionPath();
                 if(cutter)
                     cutter->SaveToFile(filepath_3);
@@ -149,7 +205,7 @@ void PathGenerationGUI::RenderPathGeneration(){
                 path_generator_.reset(new PathGenerator(
                         cad_model_loader_result_,
                         simulation_->material_box(),
-                        scene_));
+                        scene_, intersection_service_));
                 auto cutter = path_generator_->GenerateParametrizationPath();
                 if(cutter)
                     cutter->SaveToFile(filepath_4);
@@ -160,6 +216,99 @@ void PathGenerationGUI::RenderPathGeneration(){
         ImGui::TreePop();
     }
 
+    if(ImGui::TreeNode("Rest Machining Path")) {
+        static char filepath_rest[size] = "jc_t5";
+        if (ImGui::Button("Generate")) {
+            if(cad_model_loader_result_ && !previous_cutters_.empty()){
+                path_generator_.reset(new PathGenerator(
+                        cad_model_loader_result_,
+                        simulation_->material_box(),
+                        scene_, intersection_service_));
+                auto cutter = path_generator_->GenerateRestMachiningPath(
+                        previous_cutters_);
+                cutter->SaveToFile(filepath_rest);
+            }
+        }
+        ImGui::SameLine();
+        ImGui::InputText("filename", filepath_rest, size);
+        ImGui::Text("Uses paths of the last Generate All");
+        ImGui::TreePop();
+    }
+
+    if(ImGui::TreeNode("Deviation Map")) {
+        static char filepath_deviation[size] = "jc_deviation";
+        if (ImGui::Button("Generate")) {
+            if(cad_model_loader_result_ && !previous_cutters_.empty()){
+                path_generator_.reset(new PathGenerator(
+                        cad_model_loader_result_,
+                        simulation_->material_box(),
+                        scene_, intersection_service_));
+                deviation_map_ = path_generator_->GenerateDeviationMap(
+                        previous_cutters_, filepath_deviation);
+            }
+        }
+        ImGui::SameLine();
+        ImGui::InputText("filename", filepath_deviation, size);
+        ImGui::Text("Uses paths of the last Generate All");
+        if(deviation_map_){
+            const DeviationSummary& summary = deviation_map_->summary();
+            ImGui::Text("Gouges: %d, max: %.3f [mm]",
+                        summary.gouge_count, summary.max_gouge);
+            ImGui::Text("Leftovers: %d, max: %.3f [mm]",
+                        summary.leftover_count, summary.max_leftover);
+        }
+        ImGui::TreePop();
+    }
+
+    ImGui::PopItemWidth();
+}
+
+void PathGenerationGUI::RenderProgramVerification(){
+    ImGui::PushItemWidth(150);
+    const int size = 1024;
+    static char filepath[size] = "jc_t3.k8";
+
+    if (ImGui::Button("Verify")) {
+        auto cutter = CutterLoader(filepath).Load();
+        if(!cutter)
+            std::cout << "Could not load program: " << filepath << std::endl;
+        if(cad_model_loader_result_ && cutter){
+            float radius = cutter->diameter() / 2.0f;
+
+            ThreadPool pool;
+            auto distance_field = DistanceField::LoadOrBuild(
+                    TessellateModel(cad_model_loader_result_, 4),
+                    1.0f, radius + 5.0f, pool);
+            ProgramVerifier verifier(distance_field,
+                                     simulation_->material_box()->dimensions());
+            ProgramVerification verification = verifier.Verify(cutter, pool);
+            verifier.PrintReport(verification);
+
+            verification_summary_.clear();
+            for(auto type : {ProgramIssueType::GOUGE,
+                             ProgramIssueType::FLAT_PLUNGE,
+                             ProgramIssueType::RAPID_THROUGH_STOCK,
+                             ProgramIssueType::MAX_DEPTH}){
+                int count = 0;
+                for(auto& issue : verification.issues)
+                    count += issue.type == type ? 1 : 0;
+                verification_summary_.push_back(
+                        ToString(type) + ": " + std::to_string(count));
+            }
+            verification_summary_.push_back(
+                    "Min clearance: "
+                    + std::to_string(verification.min_clearance)
+                    + " [mm] at "
+                    + std::to_string(
+                            verification.min_clearance_instruction_id));
+        }
+    }
+    ImGui::SameLine();
+    ImGui::InputText("filepath", filepath, size);
+
+    for(auto& line : verification_summary_)
+        ImGui::Text("%s", line.c_str());
+
     ImGui::PopItemWidth();
 }
 
@@ -3,9 +3,15 @@
 
 #include <gui/imgui/imgui.h>
 #include <ifc/factory/cutter_factory.h>
+#include <ifc/material/stock_snapshot.h>
+#include <ifc/cutter/job_simulation.h>
+#include <ifc/cutter/program_watcher.h>
 
 #include "ifc/gui/simulation_gui.h"
 
+#include <cmath>
+#include <iostream>
+
 namespace ifc {
 
 SimulationGUI::SimulationGUI(std::shared_ptr<ifx::Scene> scene,
@@ -23,6 +29,7 @@ SimulationGUI::SimulationGUI(std::shared_ptr<ifx::Scene> scene,
 SimulationGUI::~SimulationGUI(){}
 
 void SimulationGUI::Render() {
+    ReloadWatchedProgram();
     RenderMainWindow();
     RenderDebugWindow();
 }
@@ -73,6 +80,8 @@ void SimulationGUI::RenderMenuBar(){
 void SimulationGUI::RenderSimulationInfoSection(){
     ImGui::BulletText("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::BulletText("Time: %.2f [s]", simulation_->total_time_s());
+    ImGui::BulletText("Machine time: %.2f [s]",
+                      simulation_->machine_time_s());
 
     if(!simulation_->CanUpdate())
         RenderSimulationRequirements();
@@ -95,11 +104,20 @@ void SimulationGUI::RenderSimulationControl(){
         simulation_->SetRunning(!simulation_->IsRunning());
     ImGui::SameLine();
     if(ImGui::Button(">>"))
-        simulation_->UpdateAllAtOnce();
+        simulation_->FastForward();
+    ImGui::SameLine();
+    if(ImGui::Button("<"))
+        simulation_->StepBack();
     ImGui::SameLine();
-    ImGui::SliderFloat("Time delta [s]",
-                       simulation_->time_delta_ptr(),
-                       0.0001f, 0.1f, "%.4f");
+    if(ImGui::Button(">"))
+        simulation_->StepForward();
+    ImGui::SameLine();
+    ImGui::SliderFloat("Speed",
+                       simulation_->speed_ptr(),
+                       0.1f, 1000.0f, "%.1fx", 3.0f);
+    ImGui::SliderFloat("Frame budget [ms]",
+                       simulation_->frame_budget_ms_ptr(),
+                       1.0f, 33.0f, "%.1f");
     ImGui::SliderFloat("Line delta",
                        simulation_->line_delta_ptr(),
                        0.0001f, 1.0f, "%.4f");
@@ -107,6 +125,15 @@ void SimulationGUI::RenderSimulationControl(){
     if(simulation_->cutter()){
         ImGui::ProgressBar(simulation_->cutter()->GetProgress(),
                            ImVec2(0.0f,0.0f));
+
+        // Scrub over the program, replays from the closest keyframe.
+        float progress = simulation_->cutter()->GetProgress();
+        int last = simulation_->cutter()->instructions().size() - 1;
+        if(ImGui::SliderFloat("Seek", &progress, 0.0f, 1.0f) && last > 0)
+            simulation_->Seek(std::round(progress * last));
+        ImGui::SameLine();
+        ImGui::Text("%d / %d", simulation_->cutter()->current_instruction(),
+                    last);
     }
 }
 
@@ -128,6 +155,41 @@ void SimulationGUI::RenderSimulationError(){
 void SimulationGUI::RenderCutterSection(){
     RenderLoadCutter();
     RenderShowTrajectoryCutter();
+    RenderJob();
+}
+
+void SimulationGUI::RenderJob(){
+    const int size = 1024;
+    static char filepath[size] = "final.job";
+
+    if(ImGui::TreeNode("Job")){
+        if (ImGui::Button("Run Job") && simulation_->material_box()) {
+            auto material_box = simulation_->material_box();
+            auto snapshot = material_box->Snapshot();
+            if(!job_simulation_ || !job_simulation_->Restore(*snapshot))
+                job_simulation_.reset(new JobSimulation(*snapshot));
+
+            job_reports_ = job_simulation_->Run(
+                    JobSimulation::LoadJob(filepath));
+            JobSimulation::PrintReport(job_reports_);
+            material_box->Restore(*job_simulation_->Snapshot());
+        }
+        ImGui::SameLine();
+        ImGui::InputText("filepath", filepath, size);
+
+        for(auto& report : job_reports_){
+            if(report.status == CutterStatus::NONE){
+                ImGui::BulletText("%s: not run", report.program.c_str());
+                continue;
+            }
+            ImGui::BulletText("%s: %s, %.0f [mm^3], %.0f [ms]",
+                              report.program.c_str(),
+                              report.status == CutterStatus::FINISHED
+                              ? "finished" : "error",
+                              report.removed_volume, report.simulation_ms);
+        }
+        ImGui::TreePop();
+    }
 }
 
 void SimulationGUI::RenderLoadCutter(){
@@ -140,9 +202,20 @@ void SimulationGUI::RenderLoadCutter(){
             simulation_->SetCutter(CutterFactory().CreateCutter(
                     std::string(filepath)
             ));
+            if(program_watcher_)
+                program_watcher_.reset(new ProgramWatcher(filepath));
         }
         ImGui::SameLine();
         ImGui::InputText("filepath", filepath, size);
+
+        // Re-simulates changed part of the program when file is saved.
+        bool watch = (bool)program_watcher_;
+        if(ImGui::Checkbox("Watch file", &watch)){
+            if(watch)
+                program_watcher_.reset(new ProgramWatcher(filepath));
+            else
+                program_watcher_.reset();
+        }
         ImGui::TreePop();
     }
     if(simulation_->cutter()){
@@ -156,6 +229,14 @@ void SimulationGUI::RenderLoadCutter(){
     }
 }
 
+void SimulationGUI::ReloadWatchedProgram(){
+    if(!program_watcher_ || !program_watcher_->Changed())
+        return;
+    auto cutter = CutterFactory().CreateCutter(program_watcher_->filepath());
+    if(cutter)
+        simulation_->ReloadCutter(cutter);
+}
+
 void SimulationGUI::RenderShowTrajectoryCutter(){
     static bool v = simulation_->show_trajectory();
     ImGui::Checkbox("Show Trajectory", &v);
@@ -178,6 +259,42 @@ void SimulationGUI::RenderMaterialBoxSection(){
         ImGui::TreePop();
         RenderMaterialBoxPrecision();
     }
+    if(ImGui::TreeNode("Stock Snapshot")){
+        RenderStockSnapshot();
+        ImGui::TreePop();
+    }
+}
+
+void SimulationGUI::RenderStockSnapshot(){
+    const int size = 1024;
+    static char filepath[size] = "jc_stock.stock";
+
+    if (ImGui::Button("Save")) {
+        if(simulation_->material_box()
+           && !simulation_->material_box()->Snapshot()->Save(filepath))
+            std::cout << "Could not save stock: " << filepath << std::endl;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) {
+        auto snapshot = StockSnapshot::Load(filepath);
+        if(snapshot){
+            material_box_create_params_ = snapshot->params();
+            ResetSimulation();
+            simulation_->material_box()->Restore(*snapshot);
+        }else{
+            std::cout << "Could not load stock: " << filepath << std::endl;
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export PNG")) {
+        std::string png_filepath = std::string(filepath) + ".png";
+        if(simulation_->material_box()
+           && !simulation_->material_box()->Snapshot()->ExportPNG(
+                   png_filepath))
+            std::cout << "Could not export stock: " << png_filepath
+            << std::endl;
+    }
+    ImGui::InputText("filepath", filepath, size);
 }
 void SimulationGUI::RenderMaterialBoxDimensions(){
     ImGui::SliderFloat("x",
@@ -0,0 +1,191 @@
+#include "ifc/material/deviation_map.h"
+
+#include <ifc/geometry/surface_projector.h>
+#include <ifc/material/height_map.h>
+#include <ifc/measures.h>
+#include <ifc/parallel/task_graph.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/path_generation/height_map_paths.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace {
+const char GRID_MAGIC[4] = {'I', 'F', 'C', 'V'};
+}
+
+namespace ifc {
+
+DeviationMap::DeviationMap(HeightMap* stock,
+                           std::shared_ptr<HeightMapPath> target,
+                           ThreadPool& pool, float tolerance) :
+        width_(stock->texture_data()->width),
+        height_(stock->texture_data()->height),
+        width_mm_(target->width_mm),
+        height_mm_(target->height_mm),
+        tolerance_(tolerance){
+    int count = width_ * height_;
+    stock_points_.resize(count);
+    measured_.resize(count);
+    target_heights_.resize(count);
+    deviations_.resize(count);
+
+    TaskGraph graph;
+    for(int first = 0; first < count; first += batch_size_){
+        int last = std::min(first + batch_size_, count);
+        graph.AddTask(
+                "DeviationMap[" + std::to_string(first) + "]",
+                [this, stock, target, first, last]{
+                    for(int i = first; i < last; i++){
+                        glm::vec2 position = GLToMillimeters(
+                                stock->positions()[i]);
+                        stock_points_[i] = glm::vec3(position.x, position.y,
+                                                     stock->GetHeight(i));
+                        target_heights_[i] = GLToMillimeters(
+                                target->heights[i]);
+                        measured_[i] = !stock->IsBorder(i);
+                        deviations_[i] = measured_[i]
+                                         ? stock_points_[i].z
+                                           - target_heights_[i]
+                                         : 0.0f;
+                    }
+                });
+    }
+    graph.Run(pool);
+
+    ComputeSummary();
+}
+
+DeviationMap::~DeviationMap(){}
+
+float DeviationMap::GetDeviation(int i, int j) const{
+    return deviations_[j * width_ + i];
+}
+
+void DeviationMap::ProjectOnSurfaces(const SurfaceProjector& projector,
+                                     float base_height, ThreadPool& pool){
+    const float epsilon = 1e-3f;
+    std::vector<int> cells;
+    std::vector<glm::vec3> points;
+    for(unsigned int i = 0; i < deviations_.size(); i++){
+        if(!measured_[i] || target_heights_[i] <= base_height + epsilon)
+            continue;
+        // Surfaces are in GL coordinates, height in y.
+        const glm::vec3& point = stock_points_[i];
+        cells.push_back(i);
+        points.push_back(MillimetersToGL(glm::vec3(point.x, point.z,
+                                                   point.y)));
+    }
+
+    std::vector<SurfaceProjection> projections
+            = projector.Project(points, pool);
+    for(unsigned int k = 0; k < cells.size(); k++){
+        if(projections[k].surface == -1)
+            continue;
+        float& deviation = deviations_[cells[k]];
+        // Normal distance is never longer than the vertical one,
+        // unless target height map missed the closest surface.
+        float distance = std::min(
+                GLToMillimeters(projections[k].distance),
+                std::fabs(deviation));
+        deviation = deviation < 0.0f ? -distance : distance;
+    }
+    std::cout << "DeviationMap projected cells: " << cells.size()
+    << std::endl;
+
+    ComputeSummary();
+}
+
+bool DeviationMap::Save(std::string filename) const{
+    return SaveGrid(filename + ".dev") && SaveSummary(filename + ".json");
+}
+
+void DeviationMap::PrintSummary() const{
+    std::cout << "Deviation: " << summary_.cell_count << " cells, "
+    << summary_.gouge_count << " gouged (max " << summary_.max_gouge
+    << " [mm]), " << summary_.leftover_count << " left over (max "
+    << summary_.max_leftover << " [mm]), mean: " << summary_.mean
+    << " [mm], rms: " << summary_.rms << " [mm]" << std::endl;
+}
+
+void DeviationMap::ComputeSummary(){
+    summary_ = DeviationSummary{0, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f};
+    int bin_count = std::ceil(2.0f * histogram_range_ / histogram_bin_width_);
+    histogram_.assign(bin_count, 0);
+
+    double sum = 0.0;
+    double sum_squared = 0.0;
+    for(unsigned int i = 0; i < deviations_.size(); i++){
+        if(!measured_[i])
+            continue;
+        float deviation = deviations_[i];
+        summary_.cell_count++;
+        if(deviation < -tolerance_)
+            summary_.gouge_count++;
+        if(deviation > tolerance_)
+            summary_.leftover_count++;
+        summary_.max_gouge = std::max(summary_.max_gouge, -deviation);
+        summary_.max_leftover = std::max(summary_.max_leftover, deviation);
+        sum += deviation;
+        sum_squared += deviation * deviation;
+
+        int bin = std::floor((deviation + histogram_range_)
+                             / histogram_bin_width_);
+        histogram_[std::min(std::max(bin, 0), bin_count - 1)]++;
+    }
+    if(summary_.cell_count > 0){
+        summary_.mean = sum / summary_.cell_count;
+        summary_.rms = std::sqrt(sum_squared / summary_.cell_count);
+    }
+}
+
+bool DeviationMap::SaveGrid(std::string filename) const{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    file.write(GRID_MAGIC, sizeof(GRID_MAGIC));
+    file.write((const char*)&width_, sizeof(width_));
+    file.write((const char*)&height_, sizeof(height_));
+    file.write((const char*)&width_mm_, sizeof(width_mm_));
+    file.write((const char*)&height_mm_, sizeof(height_mm_));
+    file.write((const char*)deviations_.data(),
+               deviations_.size() * sizeof(float));
+    return (bool)file;
+}
+
+bool DeviationMap::SaveSummary(std::string filename) const{
+    std::ofstream file(filename);
+    if(!file.is_open())
+        return false;
+
+    file << "{" << std::endl;
+    file << "  \"width\": " << width_ << "," << std::endl;
+    file << "  \"height\": " << height_ << "," << std::endl;
+    file << "  \"width_mm\": " << width_mm_ << "," << std::endl;
+    file << "  \"height_mm\": " << height_mm_ << "," << std::endl;
+    file << "  \"tolerance\": " << tolerance_ << "," << std::endl;
+    file << "  \"cell_count\": " << summary_.cell_count << "," << std::endl;
+    file << "  \"gouge_count\": " << summary_.gouge_count << "," << std::endl;
+    file << "  \"leftover_count\": " << summary_.leftover_count << ","
+    << std::endl;
+    file << "  \"max_gouge\": " << summary_.max_gouge << "," << std::endl;
+    file << "  \"max_leftover\": " << summary_.max_leftover << ","
+    << std::endl;
+    file << "  \"mean\": " << summary_.mean << "," << std::endl;
+    file << "  \"rms\": " << summary_.rms << "," << std::endl;
+    file << "  \"histogram\": {" << std::endl;
+    file << "    \"min\": " << -histogram_range_ << "," << std::endl;
+    file << "    \"bin_width\": " << histogram_bin_width_ << "," << std::endl;
+    file << "    \"counts\": [";
+    for(unsigned int i = 0; i < histogram_.size(); i++)
+        file << (i == 0 ? "" : ", ") << histogram_[i];
+    file << "]" << std::endl;
+    file << "  }" << std::endl;
+    file << "}" << std::endl;
+    return (bool)file;
+}
+
+}
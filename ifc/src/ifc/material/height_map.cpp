@@ -2,12 +2,16 @@
 #include <factory/texture_factory.h>
 #include <ifc/measures.h>
 #include "ifc/material/height_map.h"
+#include <ifc/material/height_undo_log.h>
+#include <ifc/material/height_pyramid.h>
 
 namespace ifc {
 
 HeightMap::HeightMap(int width, int height,
                      float width_mm, float height_mm,
-                     float max_height){
+                     float max_height,
+                     bool create_texture) :
+        undo_log_(nullptr){
     texture_data_.width = width;
     texture_data_.height = height;
     texture_data_.max_height = max_height;
@@ -35,6 +39,11 @@ HeightMap::HeightMap(int width, int height,
     for(int i = count-1; i > count-1 - height; i--)
         texture_data_.data_[i] = 0;
 
+    pyramid_.reset(new HeightPyramid(this));
+
+    if(!create_texture)
+        return;
+
     texture_data_.texture
             = ifx::Texture2D::MakeTexture2DEmpty("ifc_height_map",
                                                  ifx::TextureTypes::DISPLACEMENT,
@@ -59,6 +68,26 @@ HeightMap::HeightMap(int width, int height,
 HeightMap::~HeightMap(){
 }
 
+void HeightMap::InitPositions(float width_mm, float height_mm){
+    int width = texture_data_.width;
+    int height = texture_data_.height;
+    float single_box_scale_x = MillimetersToGL(width_mm) / (float)width;
+    float single_box_scale_z = MillimetersToGL(height_mm) / (float)height;
+    float const_single_box_scale_x = -MillimetersToGL(width_mm / 2.0f);
+    float const_single_box_scale_z = -MillimetersToGL(height_mm / 2.0f);
+    position_info_ = PositionInfo{single_box_scale_x, single_box_scale_z,
+                                  const_single_box_scale_x,
+                                  const_single_box_scale_z};
+
+    for(int i = 0; i < width; i++){
+        for(int j = 0; j < height; j++){
+            positions_[Index(i, j)] = glm::vec2(
+                    i * single_box_scale_x + const_single_box_scale_x,
+                    j * single_box_scale_z + const_single_box_scale_z);
+        }
+    }
+}
+
 float HeightMap::GetHeight(int i, int j){
     return GLToMillimeters(texture_data_.data_[Index(i,j)]);
 }
@@ -68,10 +97,7 @@ const glm::vec2& HeightMap::GetPosition(int i, int j){
 }
 
 bool HeightMap::SetHeight(int i, int j, float height){
-    if(height > GetHeight(Index(i,j)))
-        return false;
-    texture_data_.data_[Index(i,j)] = MillimetersToGL(height);
-    return true;
+    return SetHeight(Index(i,j), height);
 }
 
 glm::vec2 HeightMap::GetIndices(const glm::vec2& pos){
@@ -89,11 +115,28 @@ float HeightMap::GetHeight(int i){
 bool HeightMap::SetHeight(int i, float height){
     if(height > GetHeight(i))
         return false;
+    if(undo_log_)
+        undo_log_->Record(i, texture_data_.data_[i]);
     texture_data_.data_[i] = MillimetersToGL(height);
+    pyramid_->MarkLowered(i);
     return true;
 }
 
+void HeightMap::HeightsChanged(){
+    pyramid_->Invalidate();
+}
+
+bool HeightMap::IsBorder(int i){
+    int width = texture_data_.width;
+    int count = width * texture_data_.height;
+    // Same cells as zeroed in constructor.
+    return i % width == 0 || i % width == width - 1
+           || i < texture_data_.height || i > count - 1 - texture_data_.height;
+}
+
 void HeightMap::Update(){
+    if(!texture_data_.texture)
+        return;
     texture_data_.texture->InitData(
             (void*)texture_data_.data_.data(),
             texture_data_.width,
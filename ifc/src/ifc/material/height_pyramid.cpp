@@ -0,0 +1,153 @@
+#include "ifc/material/height_pyramid.h"
+
+#include <ifc/material/height_map.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace ifc {
+
+HeightPyramid::HeightPyramid(HeightMap* height_map, int block_size) :
+        height_map_(height_map),
+        block_size_(block_size),
+        width_(height_map->texture_data()->width),
+        height_(height_map->texture_data()->height),
+        valid_(false){
+    int level_width = (width_ + block_size_ - 1) / block_size_;
+    int level_height = (height_ + block_size_ - 1) / block_size_;
+    while(true){
+        level_widths_.push_back(level_width);
+        level_heights_.push_back(level_height);
+        levels_.push_back(std::vector<float>(level_width * level_height));
+        if(level_width <= 1 && level_height <= 1)
+            break;
+        level_width = (level_width + 1) / 2;
+        level_height = (level_height + 1) / 2;
+    }
+    dirty_.resize(levels_[0].size(), false);
+}
+
+HeightPyramid::~HeightPyramid(){}
+
+float HeightPyramid::MaxHeight(int i0, int j0, int i1, int j1){
+    float max_height = std::numeric_limits<float>::lowest();
+    Rectangle rectangle{std::max(i0, 0), std::max(j0, 0),
+                        std::min(i1, width_ - 1), std::min(j1, height_ - 1)};
+    if(rectangle.i0 > rectangle.i1 || rectangle.j0 > rectangle.j1)
+        return max_height;
+    Refresh();
+    MaxHeight(levels_.size() - 1, 0, 0, rectangle, max_height);
+    return max_height;
+}
+
+void HeightPyramid::Build(){
+    for(unsigned int block = 0; block < levels_[0].size(); block++)
+        ComputeBlock(block);
+    for(unsigned int level = 1; level < levels_.size(); level++){
+        for(unsigned int node = 0; node < levels_[level].size(); node++)
+            ComputeNode(level, node);
+    }
+    std::fill(dirty_.begin(), dirty_.end(), false);
+    dirty_blocks_.clear();
+    valid_ = true;
+}
+
+void HeightPyramid::Refresh(){
+    if(!valid_){
+        Build();
+        return;
+    }
+    if(dirty_blocks_.empty())
+        return;
+
+    std::vector<int> nodes;
+    for(int block : dirty_blocks_){
+        ComputeBlock(block);
+        dirty_[block] = false;
+    }
+    nodes.swap(dirty_blocks_);
+    for(unsigned int level = 1; level < levels_.size(); level++){
+        int child_width = level_widths_[level - 1];
+        for(int& node : nodes){
+            int bi = (node % child_width) / 2;
+            int bj = (node / child_width) / 2;
+            node = bj * level_widths_[level] + bi;
+        }
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        for(int node : nodes)
+            ComputeNode(level, node);
+    }
+    nodes.clear();
+    // Keeps capacity for the next marks.
+    dirty_blocks_.swap(nodes);
+}
+
+void HeightPyramid::ComputeBlock(int block){
+    const std::vector<float>& heights = height_map_->heights();
+    int bi = block % level_widths_[0];
+    int bj = block / level_widths_[0];
+    int i_end = std::min((bi + 1) * block_size_, width_);
+    int j_end = std::min((bj + 1) * block_size_, height_);
+
+    float max_height = heights[bj * block_size_ * width_ + bi * block_size_];
+    for(int j = bj * block_size_; j < j_end; j++){
+        for(int i = bi * block_size_; i < i_end; i++)
+            max_height = std::max(max_height, heights[j * width_ + i]);
+    }
+    levels_[0][block] = max_height;
+}
+
+void HeightPyramid::ComputeNode(int level, int node){
+    const std::vector<float>& children = levels_[level - 1];
+    int child_width = level_widths_[level - 1];
+    int child_height = level_heights_[level - 1];
+    int bi = 2 * (node % level_widths_[level]);
+    int bj = 2 * (node / level_widths_[level]);
+
+    float max_height = children[bj * child_width + bi];
+    for(int j = bj; j < std::min(bj + 2, child_height); j++){
+        for(int i = bi; i < std::min(bi + 2, child_width); i++)
+            max_height = std::max(max_height, children[j * child_width + i]);
+    }
+    levels_[level][node] = max_height;
+}
+
+void HeightPyramid::MaxHeight(int level, int bi, int bj,
+                              const Rectangle& rectangle, float& max_height){
+    float node_height = levels_[level][bj * level_widths_[level] + bi];
+    if(node_height <= max_height)
+        return;
+
+    // Cells covered by the node.
+    int size = block_size_ << level;
+    int i0 = std::max(bi * size, rectangle.i0);
+    int j0 = std::max(bj * size, rectangle.j0);
+    int i1 = std::min((bi + 1) * size - 1, rectangle.i1);
+    int j1 = std::min((bj + 1) * size - 1, rectangle.j1);
+    if(i0 > i1 || j0 > j1)
+        return;
+    if(i0 == bi * size && j0 == bj * size
+       && i1 == std::min((bi + 1) * size, width_) - 1
+       && j1 == std::min((bj + 1) * size, height_) - 1){
+        max_height = node_height;
+        return;
+    }
+
+    if(level == 0){
+        const std::vector<float>& heights = height_map_->heights();
+        for(int j = j0; j <= j1; j++){
+            for(int i = i0; i <= i1; i++)
+                max_height = std::max(max_height, heights[j * width_ + i]);
+        }
+        return;
+    }
+    for(int cj = 2 * bj; cj < std::min(2 * bj + 2, level_heights_[level - 1]);
+        cj++){
+        for(int ci = 2 * bi;
+            ci < std::min(2 * bi + 2, level_widths_[level - 1]); ci++)
+            MaxHeight(level - 1, ci, cj, rectangle, max_height);
+    }
+}
+
+}
@@ -0,0 +1,54 @@
+#include "ifc/material/height_undo_log.h"
+
+#include <ifc/material/height_map.h>
+
+namespace ifc {
+
+HeightUndoLog::HeightUndoLog(size_t max_entries) :
+        max_entries_(max_entries){}
+
+HeightUndoLog::~HeightUndoLog(){}
+
+void HeightUndoLog::BeginSegment(int instruction){
+    if(!segments_.empty() && segments_.back().instruction == instruction)
+        return;
+    if(entries_.size() > max_entries_)
+        Forget();
+    segments_.push_back(Segment{instruction, entries_.size()});
+}
+
+int HeightUndoLog::Undo(HeightMap* height_map){
+    if(segments_.empty())
+        return -1;
+    Segment segment = segments_.back();
+    segments_.pop_back();
+
+    std::vector<float>& heights = height_map->heights();
+    for(size_t i = entries_.size(); i > segment.first_entry; i--){
+        const Entry& entry = entries_[i - 1];
+        heights[entry.cell] = entry.previous_height;
+    }
+    entries_.resize(segment.first_entry);
+    height_map->HeightsChanged();
+    return segment.instruction;
+}
+
+void HeightUndoLog::Clear(){
+    entries_.clear();
+    segments_.clear();
+}
+
+void HeightUndoLog::Forget(){
+    size_t kept = segments_.size() / 2;
+    if(kept == 0){
+        Clear();
+        return;
+    }
+    size_t first_kept = segments_[segments_.size() - kept].first_entry;
+    entries_.erase(entries_.begin(), entries_.begin() + first_kept);
+    segments_.erase(segments_.begin(), segments_.end() - kept);
+    for(auto& segment : segments_)
+        segment.first_entry -= first_kept;
+}
+
+}
@@ -2,6 +2,8 @@
 
 #include <ifc/factory/material_box_factory.h>
 #include <ifc/material/height_map.h>
+#include <ifc/material/stock_snapshot.h>
+#include <ifc/material/height_undo_log.h>
 
 namespace ifc{
 
@@ -28,4 +30,20 @@ MaterialBox::~MaterialBox(){}
 void MaterialBox::Update(){
     height_map_->Update();
 }
+
+std::shared_ptr<StockSnapshot> MaterialBox::Snapshot(){
+    return std::shared_ptr<StockSnapshot>(new StockSnapshot(
+            MaterialBoxCreateParams{dimensions_, precision_},
+            height_map_.get()));
+}
+
+bool MaterialBox::Restore(const StockSnapshot& snapshot){
+    if(!snapshot.Restore(height_map_.get()))
+        return false;
+    // Logged heights belong to the replaced stock.
+    if(height_map_->undo_log())
+        height_map_->undo_log()->Clear();
+    height_map_->Update();
+    return true;
+}
 }
\ No newline at end of file
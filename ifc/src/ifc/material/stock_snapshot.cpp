@@ -0,0 +1,355 @@
+#include "ifc/material/stock_snapshot.h"
+
+#include <ifc/material/height_map.h>
+#include <ifc/measures.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+namespace {
+const char SNAPSHOT_MAGIC[4] = {'I', 'F', 'C', 'S'};
+
+// Shortest repeated sequence worth a match.
+const int LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 16;
+
+const unsigned char PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+// Largest stored (not compressed) deflate block.
+const int DEFLATE_MAX_STORED = 65535;
+
+void WriteVarint(std::vector<unsigned char>& bytes, std::uint32_t value){
+    while(value >= 0x80){
+        bytes.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(value);
+}
+
+bool ReadVarint(const std::vector<unsigned char>& bytes, size_t& position,
+                std::uint32_t& value){
+    value = 0;
+    for(int shift = 0; shift < 35; shift += 7){
+        if(position >= bytes.size())
+            return false;
+        unsigned char byte = bytes[position++];
+        value |= (std::uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Neighbouring heights are similar, so their quantized differences
+ * are mostly zero or small.
+ */
+std::vector<unsigned char> EncodeHeights(const std::vector<float>& heights,
+                                         float quantization){
+    std::vector<unsigned char> bytes;
+    std::int32_t previous = 0;
+    for(float height : heights){
+        std::int32_t quantized = std::lround(height / quantization);
+        std::int32_t delta = quantized - previous;
+        // Zig-zag: small negative deltas become small positive ones.
+        WriteVarint(bytes, ((std::uint32_t)delta << 1)
+                           ^ (std::uint32_t)(delta >> 31));
+        previous = quantized;
+    }
+    return bytes;
+}
+
+bool DecodeHeights(const std::vector<unsigned char>& bytes,
+                   float quantization, std::vector<float>& heights){
+    size_t position = 0;
+    std::int32_t previous = 0;
+    for(auto& height : heights){
+        std::uint32_t value;
+        if(!ReadVarint(bytes, position, value))
+            return false;
+        std::int32_t delta = (std::int32_t)(value >> 1)
+                             ^ -(std::int32_t)(value & 1);
+        previous += delta;
+        height = previous * quantization;
+    }
+    return true;
+}
+
+std::uint32_t LZHash(const unsigned char* bytes){
+    std::uint32_t value = bytes[0] | (bytes[1] << 8)
+                          | (bytes[2] << 16) | ((std::uint32_t)bytes[3] << 24);
+    return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+ * Sequences of: literal count, literals, match length, match offset.
+ * The last sequence has literals only.
+ */
+std::vector<unsigned char> LZCompress(const std::vector<unsigned char>& input){
+    std::vector<unsigned char> output;
+    std::vector<int> last_positions(1 << LZ_HASH_BITS, -1);
+    int size = input.size();
+    int literal_start = 0;
+    int i = 0;
+    while(i + LZ_MIN_MATCH <= size){
+        std::uint32_t hash = LZHash(&input[i]);
+        int candidate = last_positions[hash];
+        last_positions[hash] = i;
+
+        int length = 0;
+        if(candidate != -1){
+            while(i + length < size
+                  && input[candidate + length] == input[i + length])
+                length++;
+        }
+        if(length < LZ_MIN_MATCH){
+            i++;
+            continue;
+        }
+
+        WriteVarint(output, i - literal_start);
+        output.insert(output.end(), input.begin() + literal_start,
+                      input.begin() + i);
+        WriteVarint(output, length);
+        WriteVarint(output, i - candidate);
+
+        int end = i + length;
+        for(i++; i < end && i + LZ_MIN_MATCH <= size; i++)
+            last_positions[LZHash(&input[i])] = i;
+        i = end;
+        literal_start = i;
+    }
+    WriteVarint(output, size - literal_start);
+    output.insert(output.end(), input.begin() + literal_start, input.end());
+    return output;
+}
+
+bool LZDecompress(const std::vector<unsigned char>& input,
+                  std::vector<unsigned char>& output){
+    output.clear();
+    size_t position = 0;
+    while(true){
+        std::uint32_t literal_count;
+        if(!ReadVarint(input, position, literal_count)
+           || position + literal_count > input.size())
+            return false;
+        output.insert(output.end(), input.begin() + position,
+                      input.begin() + position + literal_count);
+        position += literal_count;
+        if(position == input.size())
+            return true;
+
+        std::uint32_t length, offset;
+        if(!ReadVarint(input, position, length)
+           || !ReadVarint(input, position, offset)
+           || offset == 0 || offset > output.size())
+            return false;
+        // Match may overlap bytes it produces.
+        size_t start = output.size() - offset;
+        for(std::uint32_t k = 0; k < length; k++)
+            output.push_back(output[start + k]);
+    }
+}
+
+std::uint32_t CRC32(const unsigned char* bytes, size_t size,
+                    std::uint32_t crc = 0){
+    static std::uint32_t table[256] = {0};
+    if(table[1] == 0){
+        for(std::uint32_t n = 0; n < 256; n++){
+            std::uint32_t c = n;
+            for(int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for(size_t i = 0; i < size; i++)
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void AppendBigEndian(std::vector<unsigned char>& bytes, std::uint32_t value){
+    bytes.push_back(value >> 24);
+    bytes.push_back(value >> 16);
+    bytes.push_back(value >> 8);
+    bytes.push_back(value);
+}
+
+void WritePNGChunk(std::ofstream& file, const char type[4],
+                   const std::vector<unsigned char>& data){
+    std::vector<unsigned char> chunk;
+    AppendBigEndian(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    AppendBigEndian(chunk, CRC32(chunk.data() + 4, chunk.size() - 4));
+    file.write((const char*)chunk.data(), chunk.size());
+}
+
+/**
+ * Zlib stream of stored deflate blocks, no compression library is needed.
+ */
+std::vector<unsigned char> ZlibStored(const std::vector<unsigned char>& data){
+    std::vector<unsigned char> stream = {0x78, 0x01};
+    size_t position = 0;
+    do{
+        size_t size = std::min(data.size() - position,
+                               (size_t)DEFLATE_MAX_STORED);
+        bool last = position + size == data.size();
+        stream.push_back(last ? 1 : 0);
+        stream.push_back(size & 0xFF);
+        stream.push_back(size >> 8);
+        stream.push_back(~size & 0xFF);
+        stream.push_back((~size >> 8) & 0xFF);
+        stream.insert(stream.end(), data.begin() + position,
+                      data.begin() + position + size);
+        position += size;
+    }while(position < data.size());
+
+    std::uint32_t a = 1, b = 0;
+    for(unsigned char byte : data){
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    AppendBigEndian(stream, (b << 16) | a);
+    return stream;
+}
+}
+
+namespace ifc {
+
+StockSnapshot::StockSnapshot(){}
+
+StockSnapshot::StockSnapshot(const MaterialBoxCreateParams& params,
+                             HeightMap* height_map) :
+        params_(params){
+    heights_.resize(height_map->heights().size());
+    for(unsigned int i = 0; i < heights_.size(); i++)
+        heights_[i] = height_map->GetHeight(i);
+}
+
+StockSnapshot::~StockSnapshot(){}
+
+bool StockSnapshot::Restore(HeightMap* height_map) const{
+    if(height_map->texture_data()->width != params_.precision.x
+       || height_map->texture_data()->height != params_.precision.z
+       || height_map->heights().size() != heights_.size())
+        return false;
+    // SetHeight only removes material.
+    for(unsigned int i = 0; i < heights_.size(); i++)
+        height_map->heights()[i] = MillimetersToGL(heights_[i]);
+    height_map->HeightsChanged();
+    return true;
+}
+
+bool StockSnapshot::Save(std::string filename, bool compress,
+                         float quantization) const{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    std::vector<unsigned char> payload;
+    if(compress){
+        payload = LZCompress(EncodeHeights(heights_, quantization));
+    }else{
+        payload.resize(heights_.size() * sizeof(float));
+        std::copy((const unsigned char*)heights_.data(),
+                  (const unsigned char*)heights_.data() + payload.size(),
+                  payload.begin());
+    }
+
+    int compressed = compress ? 1 : 0;
+    int count = heights_.size();
+    int payload_size = payload.size();
+    file.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    file.write((const char*)&params_.dimensions, sizeof(params_.dimensions));
+    file.write((const char*)&params_.precision, sizeof(params_.precision));
+    file.write((const char*)&compressed, sizeof(compressed));
+    file.write((const char*)&quantization, sizeof(quantization));
+    file.write((const char*)&count, sizeof(count));
+    file.write((const char*)&payload_size, sizeof(payload_size));
+    file.write((const char*)payload.data(), payload_size);
+    return (bool)file;
+}
+
+std::shared_ptr<StockSnapshot> StockSnapshot::Load(std::string filename){
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return nullptr;
+
+    char magic[4];
+    file.read(magic, sizeof(magic));
+    if(!file || !std::equal(magic, magic + 4, SNAPSHOT_MAGIC))
+        return nullptr;
+
+    auto snapshot = std::shared_ptr<StockSnapshot>(new StockSnapshot());
+    int compressed, count, payload_size;
+    float quantization;
+    file.read((char*)&snapshot->params_.dimensions,
+              sizeof(snapshot->params_.dimensions));
+    file.read((char*)&snapshot->params_.precision,
+              sizeof(snapshot->params_.precision));
+    file.read((char*)&compressed, sizeof(compressed));
+    file.read((char*)&quantization, sizeof(quantization));
+    file.read((char*)&count, sizeof(count));
+    file.read((char*)&payload_size, sizeof(payload_size));
+    if(!file || count < 0 || payload_size < 0
+       || count != snapshot->params_.precision.x
+                   * snapshot->params_.precision.z)
+        return nullptr;
+
+    std::vector<unsigned char> payload(payload_size);
+    file.read((char*)payload.data(), payload_size);
+    if(!file)
+        return nullptr;
+
+    snapshot->heights_.resize(count);
+    if(compressed){
+        std::vector<unsigned char> bytes;
+        if(!LZDecompress(payload, bytes)
+           || !DecodeHeights(bytes, quantization, snapshot->heights_))
+            return nullptr;
+    }else{
+        if(payload.size() != count * sizeof(float))
+            return nullptr;
+        std::copy(payload.begin(), payload.end(),
+                  (unsigned char*)snapshot->heights_.data());
+    }
+    return snapshot;
+}
+
+bool StockSnapshot::ExportPNG(std::string filename) const{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    int width = params_.precision.x;
+    int height = params_.precision.z;
+    std::vector<unsigned char> header;
+    AppendBigEndian(header, width);
+    AppendBigEndian(header, height);
+    // 16-bit grayscale, deflate, no filter, no interlace.
+    header.insert(header.end(), {16, 0, 0, 0, 0});
+
+    std::vector<unsigned char> rows;
+    rows.reserve(height * (1 + 2 * width));
+    float scale = params_.dimensions.depth > 0.0f
+                  ? 65535.0f / params_.dimensions.depth : 0.0f;
+    for(int j = 0; j < height; j++){
+        rows.push_back(0);
+        for(int i = 0; i < width; i++){
+            float value = heights_[j * width + i] * scale;
+            int gray = std::min(std::max((int)std::lround(value), 0), 65535);
+            rows.push_back(gray >> 8);
+            rows.push_back(gray & 0xFF);
+        }
+    }
+
+    file.write((const char*)PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+    WritePNGChunk(file, "IHDR", header);
+    WritePNGChunk(file, "IDAT", ZlibStored(rows));
+    WritePNGChunk(file, "IEND", std::vector<unsigned char>());
+    return (bool)file;
+}
+
+}
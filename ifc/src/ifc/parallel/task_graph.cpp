@@ -0,0 +1,168 @@
+#include "ifc/parallel/task_graph.h"
+
+#include <ifc/parallel/thread_pool.h>
+
+#include <exception>
+#include <iostream>
+
+namespace ifc {
+
+TaskGraph::TaskGraph() :
+        finished_count_(0),
+        wall_time_(0){}
+
+TaskGraph::~TaskGraph(){}
+
+int TaskGraph::AddTask(std::string name, std::function<void()> work,
+                       const std::vector<int>& dependencies,
+                       TaskAffinity affinity){
+    int id = tasks_.size();
+
+    Task task;
+    task.name = name;
+    task.work = work;
+    task.dependencies = dependencies;
+    task.affinity = affinity;
+    tasks_.push_back(task);
+
+    for(int dependency : dependencies)
+        tasks_[dependency].dependents.push_back(id);
+
+    return id;
+}
+
+void TaskGraph::Run(ThreadPool& pool){
+    std::unique_lock<std::mutex> lock(mutex_);
+    start_time_ = std::chrono::steady_clock::now();
+    finished_count_ = 0;
+    for(auto& task : tasks_){
+        task.remaining_dependencies = task.dependencies.size();
+        task.status = TaskStatus::WAITING;
+        task.start = task.end = task.critical_path = 0;
+        task.critical_dependency = -1;
+    }
+    for(unsigned int i = 0; i < tasks_.size(); i++){
+        if(tasks_[i].remaining_dependencies == 0)
+            Schedule(i, pool);
+    }
+
+    while(finished_count_ < (int)tasks_.size()){
+        condition_.wait(lock, [this]{
+            return !main_thread_tasks_.empty()
+                   || finished_count_ == (int)tasks_.size();
+        });
+        while(!main_thread_tasks_.empty()){
+            int task = main_thread_tasks_.front();
+            main_thread_tasks_.pop();
+            lock.unlock();
+            Execute(task, pool);
+            lock.lock();
+        }
+    }
+    wall_time_ = Now();
+}
+
+TaskTiming TaskGraph::GetTiming(int task){
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Task& t = tasks_[task];
+    return TaskTiming{t.name, t.start, t.end, t.critical_path,
+                      t.status == TaskStatus::FAILED};
+}
+
+void TaskGraph::PrintReport(){
+    std::lock_guard<std::mutex> lock(mutex_);
+    int last = -1;
+    double sum = 0;
+    for(unsigned int i = 0; i < tasks_.size(); i++){
+        const Task& task = tasks_[i];
+        std::cout << task.name << ": "
+        << task.end - task.start << " [ms] "
+        << "(" << task.start << " - " << task.end << "), "
+        << "critical path: " << task.critical_path << " [ms]";
+        if(task.status == TaskStatus::FAILED)
+            std::cout << " FAILED";
+        std::cout << std::endl;
+
+        sum += task.end - task.start;
+        if(last == -1 || task.critical_path > tasks_[last].critical_path)
+            last = i;
+    }
+    if(last == -1)
+        return;
+
+    std::string path = tasks_[last].name;
+    for(int t = tasks_[last].critical_dependency; t != -1;
+        t = tasks_[t].critical_dependency){
+        path = tasks_[t].name + " -> " + path;
+    }
+    std::cout << "Wall time: " << wall_time_ << " [ms], "
+    << "sequential: " << sum << " [ms]" << std::endl;
+    std::cout << "Critical path: " << tasks_[last].critical_path << " [ms] "
+    << "(" << path << ")" << std::endl;
+}
+
+void TaskGraph::Schedule(int task, ThreadPool& pool){
+    if(tasks_[task].affinity == TaskAffinity::MAIN_THREAD){
+        main_thread_tasks_.push(task);
+        condition_.notify_all();
+    }else{
+        pool.Submit([this, task, &pool]{
+            Execute(task, pool);
+        });
+    }
+}
+
+void TaskGraph::Execute(int task, ThreadPool& pool){
+    double start = Now();
+    bool failed = false;
+    try{
+        tasks_[task].work();
+    }catch(const std::exception& e){
+        std::cout << tasks_[task].name << " failed: " << e.what() << std::endl;
+        failed = true;
+    }
+    double end = Now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_[task].start = start;
+    tasks_[task].end = end;
+    Complete(task, failed, pool);
+}
+
+void TaskGraph::Complete(int task, bool failed, ThreadPool& pool){
+    Task& t = tasks_[task];
+    t.status = failed ? TaskStatus::FAILED : TaskStatus::FINISHED;
+
+    t.critical_path = t.end - t.start;
+    double longest = 0;
+    for(int dependency : t.dependencies){
+        if(tasks_[dependency].critical_path > longest){
+            longest = tasks_[dependency].critical_path;
+            t.critical_dependency = dependency;
+        }
+    }
+    t.critical_path += longest;
+    finished_count_++;
+
+    for(int dependent : t.dependents){
+        Task& d = tasks_[dependent];
+        if(failed && d.status == TaskStatus::WAITING){
+            // Skipped, never executed.
+            d.start = d.end = Now();
+            Complete(dependent, true, pool);
+            continue;
+        }
+        d.remaining_dependencies--;
+        if(d.remaining_dependencies == 0 && d.status == TaskStatus::WAITING)
+            Schedule(dependent, pool);
+    }
+    condition_.notify_all();
+}
+
+double TaskGraph::Now(){
+    std::chrono::duration<double, std::milli> duration
+            = std::chrono::steady_clock::now() - start_time_;
+    return duration.count();
+}
+
+}
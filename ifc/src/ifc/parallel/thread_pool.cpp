@@ -0,0 +1,51 @@
+#include "ifc/parallel/thread_pool.h"
+
+namespace ifc {
+
+ThreadPool::ThreadPool(unsigned int thread_count) :
+        is_stopping_(false){
+    if(thread_count == 0)
+        thread_count = std::thread::hardware_concurrency();
+    if(thread_count == 0)
+        thread_count = 1;
+
+    for(unsigned int i = 0; i < thread_count; i++)
+        workers_.push_back(std::thread(&ThreadPool::Work, this));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    condition_.notify_all();
+    for(auto& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push(job);
+    }
+    condition_.notify_one();
+}
+
+void ThreadPool::Work(){
+    while(true){
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{
+                return is_stopping_ || !jobs_.empty();
+            });
+            if(jobs_.empty())
+                return;
+            job = jobs_.front();
+            jobs_.pop();
+        }
+        job();
+    }
+}
+
+}
@@ -0,0 +1,109 @@
+#include "ifc/path_generation/adaptive_step.h"
+
+#include <ifc/measures.h>
+
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ifc {
+
+float ScallopStepOver(float scallop_height, float ball_radius,
+                      float curvature){
+    // Convex radius of curvature smaller than cutter is not reachable,
+    // keep effective radius positive.
+    float denominator = std::max(1.0f + curvature * ball_radius, 0.05f);
+    return std::sqrt(8.0f * scallop_height * ball_radius / denominator);
+}
+
+float ChordalStep(float chordal_tolerance, float curvature){
+    float abs_curvature = std::fabs(curvature);
+    if(abs_curvature < 1e-6f)
+        return std::numeric_limits<float>::max();
+    return std::sqrt(8.0f * chordal_tolerance / abs_curvature);
+}
+
+AdaptiveStep::AdaptiveStep(Surface* surface,
+                           float ball_radius, float scallop_height,
+                           float chordal_tolerance,
+                           const glm::vec2& min_step,
+                           const glm::vec2& max_step,
+                           float normal_sign) :
+        surface_(surface),
+        ball_radius_(ball_radius),
+        scallop_height_(scallop_height),
+        chordal_tolerance_(chordal_tolerance),
+        min_step_(min_step),
+        max_step_(max_step),
+        normal_sign_(normal_sign){}
+
+AdaptiveStep::~AdaptiveStep(){}
+
+float AdaptiveStep::StepOver(float u, float v_start, float v_end){
+    float step = max_step_.x;
+    for(int i = 0; i <= samples_per_pass_; i++){
+        float v = v_start + (v_end - v_start) * i / samples_per_pass_;
+        float speed = GLToMillimeters(
+                ifx::Magnitude(surface_->computeDu(u, v)));
+        if(speed < 1e-6f)
+            continue;
+        float distance = ScallopStepOver(scallop_height_, ball_radius_,
+                                         CurvatureU(u, v));
+        step = std::min(step, distance / speed);
+    }
+    return std::max(step, min_step_.x);
+}
+
+float AdaptiveStep::StepAlong(float u, float v){
+    float speed = GLToMillimeters(ifx::Magnitude(surface_->computeDv(u, v)));
+    if(speed < 1e-6f)
+        return max_step_.y;
+    float distance = ChordalStep(chordal_tolerance_, CurvatureV(u, v));
+    return std::min(std::max(distance / speed, min_step_.y), max_step_.y);
+}
+
+float AdaptiveStep::CurvatureU(float u, float v){
+    float u0, u1;
+    float h = Difference(u, u0, u1);
+    glm::vec3 du = surface_->computeDu(u, v);
+    glm::vec3 duu = (surface_->computeDu(u1, v)
+                     - surface_->computeDu(u0, v)) / h;
+    float speed_squared = glm::dot(du, du);
+    if(speed_squared < 1e-12f)
+        return 0.0f;
+    // Surface bends away from cutter on convex parts.
+    float curvature = -glm::dot(duu, Normal(u, v)) / speed_squared;
+    return curvature / GLToMillimeters(1.0f);
+}
+
+float AdaptiveStep::CurvatureV(float u, float v){
+    float v0, v1;
+    float h = Difference(v, v0, v1);
+    glm::vec3 dv = surface_->computeDv(u, v);
+    glm::vec3 dvv = (surface_->computeDv(u, v1)
+                     - surface_->computeDv(u, v0)) / h;
+    float speed_squared = glm::dot(dv, dv);
+    if(speed_squared < 1e-12f)
+        return 0.0f;
+    float curvature = -glm::dot(dvv, Normal(u, v)) / speed_squared;
+    return curvature / GLToMillimeters(1.0f);
+}
+
+glm::vec3 AdaptiveStep::Normal(float u, float v){
+    glm::vec3 normal = glm::cross(surface_->computeDv(u, v),
+                                  surface_->computeDu(u, v));
+    float length = ifx::Magnitude(normal);
+    if(length < 1e-12f)
+        return glm::vec3(0, 0, 0);
+    return normal_sign_ * normal / length;
+}
+
+float AdaptiveStep::Difference(float t, float& t0, float& t1){
+    t0 = std::max(t - difference_step_, 0.0f);
+    t1 = std::min(t + difference_step_, 1.0f);
+    return t1 - t0;
+}
+
+}
@@ -0,0 +1,256 @@
+#include "ifc/path_generation/drop_cutter.h"
+
+#include <ifc/factory/cad_model_loader.h>
+#include <ifc/parallel/task_graph.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/measures.h>
+
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace ifc {
+
+std::vector<Triangle> TessellateModel(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        int tessellation){
+    std::vector<Triangle> triangles;
+    for(auto& surface : model_loader_result->cad_model->surfaces){
+        int n = surface->GetBicubicBezierPatches().rowCount() * tessellation;
+        int m = surface->GetBicubicBezierPatches().columnCount()
+                * tessellation;
+
+        // u runs over columns of patches, v over rows.
+        std::vector<glm::vec3> points((m + 1) * (n + 1));
+        for(int i = 0; i <= m; i++){
+            for(int j = 0; j <= n; j++){
+                glm::vec3 point = GLToMillimeters(
+                        surface->compute((float)i / m, (float)j / n));
+                points[i * (n + 1) + j] = glm::vec3(point.x, point.z,
+                                                    point.y);
+            }
+        }
+        for(int i = 0; i < m; i++){
+            for(int j = 0; j < n; j++){
+                const glm::vec3& p00 = points[i * (n + 1) + j];
+                const glm::vec3& p01 = points[i * (n + 1) + j + 1];
+                const glm::vec3& p10 = points[(i + 1) * (n + 1) + j];
+                const glm::vec3& p11 = points[(i + 1) * (n + 1) + j + 1];
+                triangles.push_back(Triangle{{p00, p10, p11}});
+                triangles.push_back(Triangle{{p00, p11, p01}});
+            }
+        }
+    }
+    return triangles;
+}
+
+DropCutter::DropCutter(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        float floor_height, int tessellation) :
+        floor_height_(floor_height){
+    bvh_.reset(new TriangleBVH(TessellateModel(model_loader_result,
+                                               tessellation)));
+    std::cout << "DropCutter triangles: " << bvh_->triangle_count()
+    << std::endl;
+}
+
+DropCutter::DropCutter(const std::vector<Triangle>& triangles,
+                       float floor_height) :
+        bvh_(new TriangleBVH(triangles)),
+        floor_height_(floor_height){}
+
+DropCutter::~DropCutter(){}
+
+float DropCutter::Height(const glm::vec2& position,
+                         CutterType type, float radius) const{
+    std::vector<int> triangles;
+    bvh_->FindTriangles(position - glm::vec2(radius, radius),
+                        position + glm::vec2(radius, radius),
+                        floor_height_, triangles);
+
+    // Tip never touches above the highest vertex,
+    // so the highest triangles are checked first.
+    std::sort(triangles.begin(), triangles.end(),
+              [this](int a, int b){
+                  return bvh_->bounds(a).max.z > bvh_->bounds(b).max.z;
+              });
+
+    float height = floor_height_;
+    for(int triangle : triangles){
+        if(bvh_->bounds(triangle).max.z <= height)
+            break;
+        if(type == CutterType::Sphere){
+            height = std::max(height, SphereHeight(bvh_->triangle(triangle),
+                                                   position, radius));
+        }else{
+            height = std::max(height, FlatHeight(bvh_->triangle(triangle),
+                                                 position, radius));
+        }
+    }
+    return height;
+}
+
+std::vector<float> DropCutter::Heights(const std::vector<glm::vec2>& positions,
+                                       CutterType type, float radius,
+                                       ThreadPool& pool,
+                                       int batch_size) const{
+    std::vector<float> heights(positions.size());
+    int count = positions.size();
+
+    TaskGraph graph;
+    for(int first = 0; first < count; first += batch_size){
+        int last = std::min(first + batch_size, count);
+        graph.AddTask(
+                "DropCutter[" + std::to_string(first) + "]",
+                [this, &positions, &heights, type, radius, first, last]{
+                    for(int i = first; i < last; i++)
+                        heights[i] = Height(positions[i], type, radius);
+                });
+    }
+    graph.Run(pool);
+
+    return heights;
+}
+
+float DropCutter::SphereHeight(const Triangle& triangle,
+                               const glm::vec2& position,
+                               float radius) const{
+    float height = -FLT_MAX;
+    const float radius_squared = radius * radius;
+
+    // Facet: center lies radius above the plane along its normal.
+    const glm::vec3& a = triangle.vertices[0];
+    glm::vec3 normal = glm::cross(triangle.vertices[1] - a,
+                                  triangle.vertices[2] - a);
+    float length = glm::length(normal);
+    if(length > 1e-12f){
+        normal /= length;
+        if(normal.z < 0)
+            normal = -normal;
+        if(normal.z > 1e-6f){
+            float center_z = a.z + (radius - normal.x * (position.x - a.x)
+                                    - normal.y * (position.y - a.y))
+                                   / normal.z;
+            glm::vec3 contact = glm::vec3(position.x, position.y, center_z)
+                                - radius * normal;
+            if(IsInside(triangle, glm::vec2(contact.x, contact.y)))
+                height = std::max(height, center_z - radius);
+        }
+    }
+
+    for(int k = 0; k < 3; k++){
+        const glm::vec3& p0 = triangle.vertices[k];
+        const glm::vec3& p1 = triangle.vertices[(k + 1) % 3];
+
+        // Vertex.
+        glm::vec2 to_vertex = glm::vec2(p0.x, p0.y) - position;
+        float distance_squared = glm::dot(to_vertex, to_vertex);
+        if(distance_squared <= radius_squared){
+            height = std::max(height, p0.z
+                                      + std::sqrt(radius_squared
+                                                  - distance_squared)
+                                      - radius);
+        }
+
+        // Edge: in the vertical plane of the edge, sphere is a circle
+        // of radius r tangent to the edge from above.
+        glm::vec3 edge = p1 - p0;
+        glm::vec2 edge_xy = glm::vec2(edge.x, edge.y);
+        float length_xy = glm::length(edge_xy);
+        if(length_xy < 1e-6f)
+            continue;
+        glm::vec2 direction = edge_xy / length_xy;
+        glm::vec2 to_position = position - glm::vec2(p0.x, p0.y);
+        float along = glm::dot(to_position, direction);
+        float across = to_position.x * direction.y
+                       - to_position.y * direction.x;
+        if(std::fabs(across) > radius)
+            continue;
+        float r = std::sqrt(radius_squared - across * across);
+        float slope = edge.z / length_xy;
+        float norm = std::sqrt(1.0f + slope * slope);
+        float t = (along + r * slope / norm) / length_xy;
+        if(t < 0.0f || t > 1.0f)
+            continue;
+        float center_z = p0.z + t * edge.z + r / norm;
+        height = std::max(height, center_z - radius);
+    }
+    return height;
+}
+
+float DropCutter::FlatHeight(const Triangle& triangle,
+                             const glm::vec2& position,
+                             float radius) const{
+    float height = -FLT_MAX;
+    const float radius_squared = radius * radius;
+
+    // Facet: highest point of the plane over the disc lies on its border,
+    // in the direction of the gradient.
+    const glm::vec3& a = triangle.vertices[0];
+    glm::vec3 normal = glm::cross(triangle.vertices[1] - a,
+                                  triangle.vertices[2] - a);
+    if(std::fabs(normal.z) > 1e-12f){
+        glm::vec2 gradient = glm::vec2(-normal.x, -normal.y) / normal.z;
+        float gradient_length = glm::length(gradient);
+        glm::vec2 contact = position;
+        if(gradient_length > 1e-6f)
+            contact += radius * gradient / gradient_length;
+        if(IsInside(triangle, contact)){
+            height = std::max(height, a.z + glm::dot(gradient,
+                                                     contact
+                                                     - glm::vec2(a.x, a.y)));
+        }
+    }
+
+    // Edges: highest end of the part of the edge under the disc.
+    for(int k = 0; k < 3; k++){
+        const glm::vec3& p0 = triangle.vertices[k];
+        const glm::vec3& p1 = triangle.vertices[(k + 1) % 3];
+        glm::vec2 edge_xy = glm::vec2(p1.x - p0.x, p1.y - p0.y);
+        glm::vec2 to_start = glm::vec2(p0.x, p0.y) - position;
+
+        // |to_start + t * edge_xy|^2 = radius^2
+        float qa = glm::dot(edge_xy, edge_xy);
+        float qb = 2.0f * glm::dot(to_start, edge_xy);
+        float qc = glm::dot(to_start, to_start) - radius_squared;
+        float t0, t1;
+        if(qa < 1e-12f){
+            if(qc > 0)
+                continue;
+            t0 = 0.0f;
+            t1 = 1.0f;
+        }else{
+            float discriminant = qb * qb - 4.0f * qa * qc;
+            if(discriminant < 0)
+                continue;
+            float root = std::sqrt(discriminant);
+            t0 = std::max((-qb - root) / (2.0f * qa), 0.0f);
+            t1 = std::min((-qb + root) / (2.0f * qa), 1.0f);
+            if(t0 > t1)
+                continue;
+        }
+        height = std::max(height, std::max(p0.z + t0 * (p1.z - p0.z),
+                                           p0.z + t1 * (p1.z - p0.z)));
+    }
+    return height;
+}
+
+bool DropCutter::IsInside(const Triangle& triangle,
+                          const glm::vec2& point) const{
+    float signs[3];
+    for(int k = 0; k < 3; k++){
+        const glm::vec3& p0 = triangle.vertices[k];
+        const glm::vec3& p1 = triangle.vertices[(k + 1) % 3];
+        signs[k] = (p1.x - p0.x) * (point.y - p0.y)
+                   - (p1.y - p0.y) * (point.x - p0.x);
+    }
+    bool has_negative = signs[0] < 0 || signs[1] < 0 || signs[2] < 0;
+    bool has_positive = signs[0] > 0 || signs[1] > 0 || signs[2] > 0;
+    return !(has_negative && has_positive);
+}
+
+}
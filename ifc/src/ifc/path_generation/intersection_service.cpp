@@ -0,0 +1,273 @@
+#include "ifc/path_generation/intersection_service.h"
+
+#include <ifc/factory/cad_model_loader.h>
+#include <ifc/geometry/patch_bvh.h>
+
+#include <infinity_cad/geometry/intersection/intersection.h>
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_rect.h>
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
+#include <object/render_object.h>
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+const std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+const char CACHE_MAGIC[4] = {'I', 'F', 'C', 'T'};
+}
+
+namespace ifc {
+
+IntersectionService::IntersectionService(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        std::string cache_prefix) :
+        model_loader_result_(model_loader_result),
+        cache_prefix_(cache_prefix){
+    model_hash_ = HashModel();
+}
+
+IntersectionService::~IntersectionService(){}
+
+std::shared_future<std::vector<TracePoint>> IntersectionService::Request(
+        int surface1, int surface2, const glm::vec3& hint){
+    glm::vec4 hint4 = glm::vec4(hint.x, hint.y, hint.z, 1.0f);
+    hint4 = model_loader_result_->cad_model->render_object->GetModelMatrix()
+            * hint4;
+    glm::vec3 init_point = glm::vec3(hint4.x, hint4.y, hint4.z);
+
+    return RequestAt(surface1, surface2, init_point);
+}
+
+std::vector<std::shared_future<std::vector<TracePoint>>>
+        IntersectionService::RequestAll(int surface1, int surface2){
+    std::vector<std::shared_future<std::vector<TracePoint>>> futures;
+    for(auto& seed : FindSeeds(surface1, surface2))
+        futures.push_back(RequestAt(surface1, surface2, seed));
+    return futures;
+}
+
+std::vector<glm::vec3> IntersectionService::FindSeeds(int surface1,
+                                                      int surface2){
+    auto key = std::make_pair(surface1, surface2);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = seeds_.find(key);
+        if(found != seeds_.end())
+            return found->second;
+    }
+
+    // Other requests are not blocked while seeds are searched.
+    std::cout << "Finding intersection seeds [" << surface1 << ", "
+    << surface2 << "]" << std::endl;
+    auto seeds = FindIntersectionSeeds(*GetPatchBVH(surface1),
+                                       *GetPatchBVH(surface2));
+
+    // Concurrent search of the same pair gives the same seeds.
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seeds_.insert(std::make_pair(key, seeds)).first->second;
+}
+
+std::shared_future<std::vector<TracePoint>> IntersectionService::RequestAt(
+        int surface1, int surface2, const glm::vec3& init_point){
+    std::uint64_t key = model_hash_;
+    key = Hash(key, &surface1, sizeof(surface1));
+    key = Hash(key, &surface2, sizeof(surface2));
+    key = Hash(key, &init_point.x, sizeof(float));
+    key = Hash(key, &init_point.y, sizeof(float));
+    key = Hash(key, &init_point.z, sizeof(float));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = intersections_.find(key);
+    if(found != intersections_.end())
+        return found->second;
+
+    std::stringstream filename;
+    filename << cache_prefix_ << std::hex << key << ".trace";
+
+    auto promise = std::make_shared<std::promise<std::vector<TracePoint>>>();
+    std::shared_future<std::vector<TracePoint>> future
+            = promise->get_future().share();
+    intersections_[key] = future;
+
+    std::string filename_str = filename.str();
+    pool_.Submit([this, promise, surface1, surface2,
+                         init_point, filename_str]{
+        try{
+            promise->set_value(Compute(surface1, surface2,
+                                       init_point, filename_str));
+        }catch(...){
+            promise->set_exception(std::current_exception());
+        }
+    });
+
+    return future;
+}
+
+std::vector<TracePoint> IntersectionService::Trace(int surface1, int surface2,
+                                                   const glm::vec3& hint){
+    return Request(surface1, surface2, hint).get();
+}
+
+std::vector<std::vector<TracePoint>> IntersectionService::TraceAll(
+        int surface1, int surface2){
+    std::vector<std::vector<TracePoint>> components;
+    for(auto& future : RequestAll(surface1, surface2)){
+        const std::vector<TracePoint>& trace_points = future.get();
+        if(trace_points.empty())
+            continue;
+        bool traced = false;
+        for(auto& component : components)
+            traced = traced || Contains(component, trace_points.front().point);
+        if(!traced)
+            components.push_back(trace_points);
+    }
+    return components;
+}
+
+std::shared_ptr<PatchBVH> IntersectionService::GetPatchBVH(int surface){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = patch_bvhs_.find(surface);
+        if(found != patch_bvhs_.end())
+            return found->second;
+    }
+    auto patch_bvh = std::shared_ptr<PatchBVH>(
+            new PatchBVH(GetSurface(surface)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return patch_bvhs_.insert(
+            std::make_pair(surface, patch_bvh)).first->second;
+}
+
+bool IntersectionService::Contains(const std::vector<TracePoint>& trace_points,
+                                   const glm::vec3& point){
+    // Point lies on the polyline if it is within a step of a trace point.
+    float max_step = 0.0f;
+    for(unsigned int i = 1; i < trace_points.size(); i++){
+        max_step = std::max(max_step, ifx::EuclideanDistance(
+                trace_points[i - 1].point, trace_points[i].point));
+    }
+    for(auto& trace_point : trace_points){
+        if(ifx::EuclideanDistance(trace_point.point, point) <= max_step)
+            return true;
+    }
+    return false;
+}
+
+Surface* IntersectionService::GetSurface(int surface){
+    if(surface == INTERSECTION_SURFACE)
+        return model_loader_result_->interection_model->surface.get();
+    return model_loader_result_->cad_model->surfaces[surface].get();
+}
+
+std::vector<TracePoint> IntersectionService::Compute(
+        int surface1, int surface2,
+        const glm::vec3& init_point,
+        std::string filename){
+    std::vector<TracePoint> trace_points;
+    if(Load(filename, trace_points)){
+        std::cout << "Intersection loaded from: " << filename << std::endl;
+        return trace_points;
+    }
+
+    auto intersection = std::unique_ptr<Intersection>(new Intersection(
+            GetSurface(surface1),
+            GetSurface(surface2)));
+    intersection->start(init_point);
+    trace_points = intersection->getTracePoints();
+
+    Save(filename, trace_points);
+
+    return trace_points;
+}
+
+bool IntersectionService::Load(std::string filename,
+                               std::vector<TracePoint>& trace_points){
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    char magic[4];
+    int size = 0;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&size, sizeof(size));
+    if(!file || std::string(magic, 4) != std::string(CACHE_MAGIC, 4)
+       || size < 0)
+        return false;
+
+    trace_points.resize(size);
+    for(int i = 0; i < size; i++){
+        float values[7];
+        file.read((char*)values, sizeof(values));
+        trace_points[i].point = glm::vec3(values[0], values[1], values[2]);
+        trace_points[i].params = glm::vec4(values[3], values[4],
+                                           values[5], values[6]);
+    }
+    if(!file){
+        trace_points.clear();
+        return false;
+    }
+    return true;
+}
+
+void IntersectionService::Save(std::string filename,
+                               const std::vector<TracePoint>& trace_points){
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open()){
+        std::cout << "Could not save intersection: " << filename << std::endl;
+        return;
+    }
+    int size = trace_points.size();
+    file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    file.write((const char*)&size, sizeof(size));
+    for(auto& trace_point : trace_points){
+        float values[7] = {
+                trace_point.point.x, trace_point.point.y, trace_point.point.z,
+                trace_point.params.x, trace_point.params.y,
+                trace_point.params.z, trace_point.params.w
+        };
+        file.write((const char*)values, sizeof(values));
+    }
+}
+
+std::uint64_t IntersectionService::HashModel(){
+    std::vector<Surface*> surfaces;
+    for(auto& surface : model_loader_result_->cad_model->surfaces)
+        surfaces.push_back(surface.get());
+    surfaces.push_back(GetSurface(INTERSECTION_SURFACE));
+
+    std::uint64_t hash = FNV_OFFSET;
+    for(auto surface : surfaces){
+        const Matrix<ifc::Point*>& points = surface->getMatrixPoints();
+        int n = points.rowCount();
+        int m = points.columnCount();
+        hash = Hash(hash, &n, sizeof(n));
+        hash = Hash(hash, &m, sizeof(m));
+        for(int i = 0; i < n; i++){
+            for(int j = 0; j < m; j++){
+                const glm::vec3& pos = points[i][j]->getPosition();
+                hash = Hash(hash, &pos.x, sizeof(float));
+                hash = Hash(hash, &pos.y, sizeof(float));
+                hash = Hash(hash, &pos.z, sizeof(float));
+            }
+        }
+    }
+    return hash;
+}
+
+std::uint64_t IntersectionService::Hash(std::uint64_t hash,
+                                        const void* data, int size){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(int i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+}
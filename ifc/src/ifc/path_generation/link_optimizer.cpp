@@ -0,0 +1,251 @@
+#include "ifc/path_generation/link_optimizer.h"
+
+#include <ifc/material/height_map.h>
+#include <ifc/measures.h>
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace ifc {
+
+LinkOptimizer::LinkOptimizer(HeightMap* stock, float cutter_radius,
+                             float safety_margin) :
+        cutter_radius_(cutter_radius),
+        safety_margin_(safety_margin),
+        width_(stock->texture_data()->width),
+        height_(stock->texture_data()->height),
+        origin_(0, 0),
+        spacing_(1, 1),
+        report_(LinkReport{0, 0}){
+    heights_.resize(width_ * height_);
+    for(int j = 0; j < height_; j++){
+        for(int i = 0; i < width_; i++)
+            heights_[j * width_ + i] = stock->GetHeight(i, j);
+    }
+    if(width_ < 2 || height_ < 2)
+        return;
+
+    origin_ = GLToMillimeters(stock->GetPosition(0, 0));
+    spacing_ = glm::vec2(
+            GLToMillimeters(stock->GetPosition(1, 0)).x - origin_.x,
+            GLToMillimeters(stock->GetPosition(0, 1)).y - origin_.y);
+
+    int radius_i = std::ceil(cutter_radius_ / std::fabs(spacing_.x));
+    int radius_j = std::ceil(cutter_radius_ / std::fabs(spacing_.y));
+    DilateStock(radius_i, radius_j);
+}
+
+LinkOptimizer::~LinkOptimizer(){}
+
+std::vector<Instruction> LinkOptimizer::Link(
+        const std::vector<LinkPass>& passes,
+        const glm::vec3& start, int& id){
+    std::vector<Instruction> instructions;
+    report_ = LinkReport{0, 0};
+
+    glm::vec3 baseline_position = start;
+    for(auto& pass : passes){
+        if(pass.positions.empty())
+            continue;
+        report_.baseline_link_distance += SafePlaneLinkDistance(
+                baseline_position, pass.positions.front(), start.z);
+        baseline_position = pass.positions.back();
+    }
+    report_.baseline_link_distance += SafePlaneLinkDistance(
+            baseline_position, start, start.z);
+
+    std::vector<LinkedPass> order = FindOrder(passes, start);
+    ImproveOrder(passes, start, order);
+
+    instructions.push_back(Instruction(id++, start,
+                                       InstructionSpeedMode::FAST));
+    glm::vec3 position = start;
+    for(auto& linked_pass : order){
+        auto& positions = passes[linked_pass.pass].positions;
+        report_.link_distance += AddLink(instructions, position,
+                                         Entry(passes, linked_pass), id);
+        for(unsigned int k = 1; k < positions.size(); k++){
+            int index = linked_pass.reversed ? positions.size() - 1 - k : k;
+            instructions.push_back(Instruction(id++, positions[index]));
+        }
+        position = Exit(passes, linked_pass);
+    }
+    report_.link_distance += AddLink(instructions, position, start, id);
+
+    return instructions;
+}
+
+float LinkOptimizer::Clearance(const glm::vec3& a, const glm::vec3& b) const{
+    glm::vec2 a2 = glm::vec2(a.x, a.y);
+    glm::vec2 b2 = glm::vec2(b.x, b.y);
+    float step = std::min(std::fabs(spacing_.x), std::fabs(spacing_.y));
+    int samples = std::ceil(ifx::EuclideanDistance(a2, b2) / step);
+
+    float max_height = StockHeight(a2);
+    for(int k = 1; k <= samples; k++){
+        float t = (float)k / samples;
+        max_height = std::max(max_height, StockHeight(a2 + t * (b2 - a2)));
+    }
+    return max_height + safety_margin_;
+}
+
+std::vector<LinkOptimizer::LinkedPass> LinkOptimizer::FindOrder(
+        const std::vector<LinkPass>& passes, const glm::vec3& start){
+    std::vector<LinkedPass> order;
+    std::vector<bool> visited(passes.size(), false);
+    for(unsigned int k = 0; k < passes.size(); k++)
+        visited[k] = passes[k].positions.empty();
+
+    glm::vec3 position = start;
+    while(true){
+        float min_distance = std::numeric_limits<float>::max();
+        LinkedPass closest{-1, false};
+        for(unsigned int k = 0; k < passes.size(); k++){
+            if(visited[k])
+                continue;
+            for(bool reversed : {false, true}){
+                if(reversed && !passes[k].reversible)
+                    continue;
+                LinkedPass candidate{(int)k, reversed};
+                float distance = ifx::EuclideanDistance(
+                        position, Entry(passes, candidate));
+                if(distance < min_distance){
+                    min_distance = distance;
+                    closest = candidate;
+                }
+            }
+        }
+        if(closest.pass == -1)
+            break;
+        visited[closest.pass] = true;
+        order.push_back(closest);
+        position = Exit(passes, closest);
+    }
+    return order;
+}
+
+void LinkOptimizer::ImproveOrder(const std::vector<LinkPass>& passes,
+                                 const glm::vec3& start,
+                                 std::vector<LinkedPass>& order){
+    int count = order.size();
+    const float epsilon = 1e-4f;
+    bool improved = true;
+    while(improved){
+        improved = false;
+        for(int i = 0; i < count; i++){
+            const glm::vec3& previous
+                    = i == 0 ? start : Exit(passes, order[i - 1]);
+            for(int j = i; j < count; j++){
+                if(!passes[order[j].pass].reversible)
+                    break;
+                // Reversing [i, j] also reverses direction of each pass.
+                float old_distance = ifx::EuclideanDistance(
+                        previous, Entry(passes, order[i]));
+                float new_distance = ifx::EuclideanDistance(
+                        previous, Exit(passes, order[j]));
+                const glm::vec3& next
+                        = j + 1 == count ? start : Entry(passes, order[j + 1]);
+                old_distance += ifx::EuclideanDistance(
+                        Exit(passes, order[j]), next);
+                new_distance += ifx::EuclideanDistance(
+                        Entry(passes, order[i]), next);
+                if(new_distance + epsilon < old_distance){
+                    std::reverse(order.begin() + i, order.begin() + j + 1);
+                    for(int k = i; k <= j; k++)
+                        order[k].reversed = !order[k].reversed;
+                    improved = true;
+                    break;
+                }
+            }
+            if(improved)
+                break;
+        }
+    }
+}
+
+const glm::vec3& LinkOptimizer::Entry(const std::vector<LinkPass>& passes,
+                                      const LinkedPass& linked_pass){
+    auto& positions = passes[linked_pass.pass].positions;
+    return linked_pass.reversed ? positions.back() : positions.front();
+}
+
+const glm::vec3& LinkOptimizer::Exit(const std::vector<LinkPass>& passes,
+                                     const LinkedPass& linked_pass){
+    auto& positions = passes[linked_pass.pass].positions;
+    return linked_pass.reversed ? positions.front() : positions.back();
+}
+
+float LinkOptimizer::AddLink(std::vector<Instruction>& instructions,
+                             const glm::vec3& a, const glm::vec3& b,
+                             int& id){
+    float clearance = Clearance(a, b);
+    glm::vec3 retract = glm::vec3(a.x, a.y, std::max(clearance, a.z));
+    glm::vec3 approach = glm::vec3(b.x, b.y, std::max(clearance, b.z));
+
+    if(retract != a){
+        instructions.push_back(Instruction(id++, retract,
+                                           InstructionSpeedMode::FAST));
+    }
+    instructions.push_back(Instruction(id++, approach,
+                                       InstructionSpeedMode::FAST));
+    if(approach != b)
+        instructions.push_back(Instruction(id++, b));
+
+    return ifx::EuclideanDistance(a, retract)
+           + ifx::EuclideanDistance(retract, approach)
+           + ifx::EuclideanDistance(approach, b);
+}
+
+float LinkOptimizer::SafePlaneLinkDistance(const glm::vec3& a,
+                                           const glm::vec3& b,
+                                           float safe_height){
+    return std::fabs(safe_height - a.z)
+           + ifx::EuclideanDistance(glm::vec2(a.x, a.y), glm::vec2(b.x, b.y))
+           + std::fabs(safe_height - b.z);
+}
+
+void LinkOptimizer::DilateStock(int radius_i, int radius_j){
+    // Square window, separable: along i, then along j.
+    std::vector<float> rows(heights_.size());
+    for(int j = 0; j < height_; j++){
+        for(int i = 0; i < width_; i++){
+            float max_height = heights_[j * width_ + i];
+            int first = std::max(i - radius_i, 0);
+            int last = std::min(i + radius_i, width_ - 1);
+            for(int k = first; k <= last; k++)
+                max_height = std::max(max_height, heights_[j * width_ + k]);
+            rows[j * width_ + i] = max_height;
+        }
+    }
+    for(int j = 0; j < height_; j++){
+        for(int i = 0; i < width_; i++){
+            float max_height = rows[j * width_ + i];
+            int first = std::max(j - radius_j, 0);
+            int last = std::min(j + radius_j, height_ - 1);
+            for(int k = first; k <= last; k++)
+                max_height = std::max(max_height, rows[k * width_ + i]);
+            heights_[j * width_ + i] = max_height;
+        }
+    }
+}
+
+float LinkOptimizer::StockHeight(const glm::vec2& position) const{
+    if(heights_.empty())
+        return 0.0f;
+    int i = std::round((position.x - origin_.x) / spacing_.x);
+    int j = std::round((position.y - origin_.y) / spacing_.y);
+
+    // Cutter still reaches stock just outside of the map.
+    int radius_i = std::ceil(cutter_radius_ / std::fabs(spacing_.x));
+    int radius_j = std::ceil(cutter_radius_ / std::fabs(spacing_.y));
+    if(i < -radius_i || i >= width_ + radius_i
+       || j < -radius_j || j >= height_ + radius_j)
+        return 0.0f;
+    i = std::min(std::max(i, 0), width_ - 1);
+    j = std::min(std::max(j, 0), height_ - 1);
+    return heights_[j * width_ + i];
+}
+
+}
@@ -0,0 +1,98 @@
+#include "ifc/path_generation/obstacle_distance_map.h"
+
+#include <ifc/path_generation/height_map_paths.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const float INFINITE_DISTANCE = 1e20f;
+}
+
+namespace ifc {
+
+ObstacleDistanceMap::ObstacleDistanceMap(
+        std::shared_ptr<HeightMapPath> height_map_path) :
+        row_count_(height_map_path->row_count),
+        column_count_(height_map_path->column_count){
+    int n = row_count_;
+    int m = column_count_;
+    distances_.resize(n * m);
+
+    // Pass 1: along rows.
+    std::vector<float> f(m);
+    std::vector<float> result;
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            bool is_obstacle = height_map_path->GetHeight(i, j) >
+                               height_map_path->init_height;
+            f[j] = is_obstacle ? 0.0f : INFINITE_DISTANCE;
+        }
+        Transform1D(f, height_map_path->column_width, result);
+        for(int j = 0; j < m; j++)
+            distances_[i * m + j] = result[j];
+    }
+
+    // Pass 2: along columns.
+    f.resize(n);
+    for(int j = 0; j < m; j++){
+        for(int i = 0; i < n; i++)
+            f[i] = distances_[i * m + j];
+        Transform1D(f, height_map_path->row_width, result);
+        for(int i = 0; i < n; i++)
+            distances_[i * m + j] = std::sqrt(result[i]);
+    }
+}
+
+ObstacleDistanceMap::~ObstacleDistanceMap(){}
+
+float ObstacleDistanceMap::GetDistance(int i, int j){
+    i = std::min(std::max(i, 0), row_count_ - 1);
+    j = std::min(std::max(j, 0), column_count_ - 1);
+    return distances_[i * column_count_ + j];
+}
+
+float ObstacleDistanceMap::Intersection(const std::vector<float>& f,
+                                        int q, int v, float spacing){
+    float xq = q * spacing;
+    float xv = v * spacing;
+    return ((f[q] + xq*xq) - (f[v] + xv*xv)) / (2.0f*xq - 2.0f*xv);
+}
+
+void ObstacleDistanceMap::Transform1D(const std::vector<float>& f,
+                                      float spacing,
+                                      std::vector<float>& result){
+    int size = f.size();
+    result.resize(size);
+    envelope_.resize(size);
+    boundaries_.resize(size + 1);
+
+    // k - index of the right most parabola in the lower envelope.
+    int k = 0;
+    envelope_[0] = 0;
+    boundaries_[0] = -std::numeric_limits<float>::infinity();
+    boundaries_[1] = std::numeric_limits<float>::infinity();
+    for(int q = 1; q < size; q++){
+        float s = Intersection(f, q, envelope_[k], spacing);
+        while(s <= boundaries_[k]){
+            k--;
+            s = Intersection(f, q, envelope_[k], spacing);
+        }
+        k++;
+        envelope_[k] = q;
+        boundaries_[k] = s;
+        boundaries_[k+1] = std::numeric_limits<float>::infinity();
+    }
+
+    k = 0;
+    for(int q = 0; q < size; q++){
+        float xq = q * spacing;
+        while(boundaries_[k+1] < xq)
+            k++;
+        float dx = xq - envelope_[k] * spacing;
+        result[q] = std::min(dx*dx + f[envelope_[k]], INFINITE_DISTANCE);
+    }
+}
+
+}
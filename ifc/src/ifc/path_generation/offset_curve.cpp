@@ -0,0 +1,64 @@
+#include "ifc/path_generation/offset_curve.h"
+
+#include <infinity_cad/geometry/intersection/intersection.h>
+#include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
+
+namespace ifc {
+
+OffsetCurve::OffsetCurve(const std::vector<TracePoint>& trace_points,
+                         float radius,
+                         std::shared_ptr<Surface> surface1, float normal_sign1,
+                         std::shared_ptr<Surface> surface2, float normal_sign2,
+                         float min_height) :
+        trace_points_(trace_points),
+        radius_(radius),
+        min_height_(min_height){
+    normals1_ = ComputeNormals(surface1.get(), normal_sign1, false);
+    normals2_ = ComputeNormals(surface2.get(), normal_sign2, true);
+}
+
+OffsetCurve::~OffsetCurve(){}
+
+const std::vector<TracePoint>& OffsetCurve::Offset(float factor1,
+                                                   float factor2){
+    auto key = std::make_pair(factor1, factor2);
+    auto found = offsets_.find(key);
+    if(found != offsets_.end())
+        return found->second;
+
+    std::vector<TracePoint> offset = trace_points_;
+    for(unsigned int i = 0; i < offset.size(); i++)
+        offset[i].point = OffsetPoint(i, factor1, factor2);
+
+    return offsets_[key] = offset;
+}
+
+glm::vec3 OffsetCurve::OffsetPoint(int index,
+                                   float factor1, float factor2) const{
+    glm::vec3 point = trace_points_[index].point
+                      + (factor1 * radius_ * normals1_[index])
+                      + (factor2 * radius_ * normals2_[index]);
+    if(point.y <= min_height_)
+        point.y = min_height_;
+    return point;
+}
+
+std::vector<glm::vec3> OffsetCurve::ComputeNormals(Surface* surface,
+                                                   float normal_sign,
+                                                   bool use_second_params){
+    std::vector<glm::vec3> normals(trace_points_.size(), glm::vec3(0, 0, 0));
+    if(!surface)
+        return normals;
+
+    for(unsigned int i = 0; i < trace_points_.size(); i++){
+        const glm::vec4& params = trace_points_[i].params;
+        float u = use_second_params ? params.z : params.x;
+        float v = use_second_params ? params.w : params.y;
+        glm::vec3 du = surface->computeDu(u, v);
+        glm::vec3 dv = surface->computeDv(u, v);
+        normals[i] = normal_sign * glm::normalize(glm::cross(dv, du));
+    }
+    return normals;
+}
+
+}
@@ -1,19 +1,33 @@
 #include "ifc/path_generation/path_generator.h"
 
 #include <ifc/path_generation/paths/roughing_path.h>
+#include <ifc/path_generation/paths/z_level_roughing_path.h>
 #include <ifc/path_generation/paths/flat_around_hm_path.h>
+#include <ifc/path_generation/paths/contour_flat_path.h>
 #include <ifc/path_generation/paths/flat_around_intersection_path.h>
 #include <ifc/path_generation/paths/parametrization_path.h>
+#include <ifc/path_generation/paths/rest_machining_path.h>
 
 #include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/drop_cutter.h>
+#include <ifc/geometry/distance_field.h>
+#include <ifc/geometry/surface_projector.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/parallel/task_graph.h>
 #include <ifc/material/material_box.h>
 #include <ifc/material/height_map.h>
+#include <ifc/material/deviation_map.h>
 #include <ifc/measures.h>
 #include <ifc/factory/cad_model_loader.h>
 #include <ifc/cutter/instruction.h>
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/machining_time.h>
+#include <ifc/cutter/gouge_check.h>
+#include <ifc/cutter/batch_simulation.h>
 #include <object/render_object.h>
 #include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace ifc{
@@ -21,35 +35,88 @@ namespace ifc{
 PathGenerator::PathGenerator(
         std::shared_ptr<CADModelLoaderResult> model_loader_result,
         std::shared_ptr<MaterialBox> material_box,
-        std::shared_ptr<ifx::Scene> scene) :
+        std::shared_ptr<ifx::Scene> scene,
+        std::shared_ptr<IntersectionService> intersection_service) :
         model_loader_result_(model_loader_result),
         material_box_(material_box){
     roughing_path_.reset(new RoughingPath(model_loader_result_,
                                           material_box_));
+    z_level_roughing_path_.reset(new ZLevelRoughingPath(model_loader_result_,
+                                                        material_box_));
     flat_around_hm_path_.reset(new FlatAroundHMPath(model_loader_result_,
                                                     material_box_));
+    contour_flat_path_.reset(new ContourFlatPath(model_loader_result_,
+                                                 material_box_));
     flat_around_intersection_path_.reset(
             new FlatAroundIntersectionPath(model_loader_result_,
-                                           material_box_, scene));
+                                           material_box_, scene,
+                                           intersection_service));
     parametrization_path_.reset(
             new ParametrizationPath(model_loader_result_,
-                                           material_box_, scene));
+                                    material_box_, scene,
+                                    intersection_service));
+    rest_machining_path_.reset(new RestMachiningPath(model_loader_result_,
+                                                     material_box_));
 }
 
 PathGenerator::~PathGenerator(){}
 
-Paths PathGenerator::GenerateAll(){
-    auto height_map_path = GenerateRequirements();
-
+Paths PathGenerator::GenerateAll(const PathFilenames& filenames){
     Paths paths;
+    std::shared_ptr<HeightMapPath> height_map_path;
 
-    paths.rough_cutter = roughing_path_->Generate(height_map_path);
-    paths.flat_heighmap_cutter
-            = flat_around_hm_path_->Generate(height_map_path);
-    paths.flat_intersection_cutter = flat_around_intersection_path_->Generate();
-    paths.parametrization_cutter
-            = parametrization_path_->Generate(
-            flat_around_intersection_path_->inside_hand_positions());
+    auto save = [](std::shared_ptr<Cutter> cutter, std::string filename){
+        if(cutter && !filename.empty())
+            cutter->SaveToFile(filename);
+    };
+
+    TaskGraph graph;
+    int height_map_task = graph.AddTask(
+            "0) Heightmap",
+            [this, &height_map_path]{
+                height_map_path = GenerateRequirements();
+            });
+    graph.AddTask(
+            "1) Roughing",
+            [this, &paths, &height_map_path, &filenames, save]{
+                paths.rough_cutter = roughing_path_->Generate(height_map_path);
+                save(paths.rough_cutter, filenames.rough);
+            }, {height_map_task});
+    graph.AddTask(
+            "2) Flat Heightmap",
+            [this, &paths, &height_map_path, &filenames, save]{
+                paths.flat_heighmap_cutter
+                        = flat_around_hm_path_->Generate(height_map_path);
+                save(paths.flat_heighmap_cutter, filenames.flat_heighmap);
+            }, {height_map_task});
+    int intersection_task = graph.AddTask(
+            "3) Flat Intersection",
+            [this, &paths, &filenames, save]{
+                paths.flat_intersection_cutter
+                        = flat_around_intersection_path_->Generate();
+                save(paths.flat_intersection_cutter,
+                     filenames.flat_intersection);
+            }, {}, TaskAffinity::MAIN_THREAD);
+    graph.AddTask(
+            "4) Parametrization",
+            [this, &paths, &filenames, save]{
+                paths.parametrization_cutter
+                        = parametrization_path_->Generate(
+                        flat_around_intersection_path_
+                                ->inside_hand_positions());
+                save(paths.parametrization_cutter,
+                     filenames.parametrization);
+            }, {intersection_task}, TaskAffinity::MAIN_THREAD);
+
+    // All traces run in the background from the start.
+    flat_around_intersection_path_->RequestIntersections();
+    parametrization_path_->RequestIntersections();
+
+    ThreadPool pool;
+    graph.Run(pool);
+    graph.PrintReport();
+
+    ReportGouges(paths);
 
     return paths;
 }
@@ -60,12 +127,55 @@ std::shared_ptr<Cutter> PathGenerator::GenerateRoughingPath(){
     return roughing_path_->Generate(height_map_path);
 }
 
+std::shared_ptr<Cutter> PathGenerator::GenerateZLevelRoughingPath(
+        float step_down){
+    auto height_map_path = GenerateRequirements();
+
+    z_level_roughing_path_->step_down(step_down);
+
+    auto cutter = z_level_roughing_path_->Generate(height_map_path);
+    auto zig_zag_cutter = roughing_path_->Generate(height_map_path);
+
+    MachiningTimeEstimate estimate
+            = EstimateMachiningTime(cutter->instructions());
+    MachiningTimeEstimate zig_zag_estimate
+            = EstimateMachiningTime(zig_zag_cutter->instructions());
+    std::cout << "Z-Level roughing: " << estimate.time_s << " [s], "
+    << estimate.normal_distance << " [mm] cutting, "
+    << estimate.fast_distance << " [mm] rapid" << std::endl;
+    std::cout << "Zig-zag roughing: " << zig_zag_estimate.time_s << " [s], "
+    << zig_zag_estimate.normal_distance << " [mm] cutting, "
+    << zig_zag_estimate.fast_distance << " [mm] rapid" << std::endl;
+
+    return cutter;
+}
+
 std::shared_ptr<Cutter> PathGenerator::GenerateFlatHeightmapPath(){
     auto height_map_path = GenerateRequirements();
 
     return flat_around_hm_path_->Generate(height_map_path);
 }
 
+std::shared_ptr<Cutter> PathGenerator::GenerateContourFlatPath(){
+    auto height_map_path = GenerateRequirements();
+
+    auto cutter = contour_flat_path_->Generate(height_map_path);
+    auto zig_zag_cutter = flat_around_hm_path_->Generate(height_map_path);
+
+    MachiningTimeEstimate estimate
+            = EstimateMachiningTime(cutter->instructions());
+    MachiningTimeEstimate zig_zag_estimate
+            = EstimateMachiningTime(zig_zag_cutter->instructions());
+    std::cout << "Contour flat: " << estimate.time_s << " [s], "
+    << estimate.normal_distance << " [mm] cutting, "
+    << estimate.fast_distance << " [mm] rapid" << std::endl;
+    std::cout << "Zig-zag flat: " << zig_zag_estimate.time_s << " [s], "
+    << zig_zag_estimate.normal_distance << " [mm] cutting, "
+    << zig_zag_estimate.fast_distance << " [mm] rapid" << std::endl;
+
+    return cutter;
+}
+
 std::shared_ptr<Cutter> PathGenerator::GenerateFlatIntersectionPath(){
     return flat_around_intersection_path_->Generate();
 }
@@ -75,6 +185,45 @@ std::shared_ptr<Cutter> PathGenerator::GenerateParametrizationPath(){
             flat_around_intersection_path_->inside_hand_positions());
 }
 
+std::shared_ptr<Cutter> PathGenerator::GenerateRestMachiningPath(
+        const std::vector<std::shared_ptr<Cutter>>& previous_cutters){
+    auto height_map_path = GenerateRequirements();
+    return rest_machining_path_->Generate(height_map_path, previous_cutters);
+}
+
+std::shared_ptr<DeviationMap> PathGenerator::GenerateDeviationMap(
+        const std::vector<std::shared_ptr<Cutter>>& cutters,
+        std::string filename){
+    auto height_map_path = GenerateRequirements();
+
+    BatchSimulation simulation(MaterialBoxCreateParams{
+            material_box_->dimensions(), material_box_->precision()});
+    for(unsigned int i = 0; i < cutters.size(); i++){
+        if(!cutters[i])
+            continue;
+        std::cout << "Simulating cutter[" << i << "]" << std::endl;
+        simulation.Run(cutters[i]);
+    }
+
+    ThreadPool pool;
+    auto deviation_map = std::shared_ptr<DeviationMap>(
+            new DeviationMap(simulation.height_map(), height_map_path, pool));
+
+    std::vector<Surface*> surfaces;
+    for(auto& surface : model_loader_result_->cad_model->surfaces)
+        surfaces.push_back(surface.get());
+    SurfaceProjector projector(surfaces);
+    deviation_map->ProjectOnSurfaces(
+            projector,
+            material_box_->dimensions().depth
+            - material_box_->dimensions().max_depth, pool);
+
+    deviation_map->PrintSummary();
+    if(!filename.empty() && !deviation_map->Save(filename))
+        std::cout << "Failed to save deviation map: " << filename << std::endl;
+    return deviation_map;
+}
+
 std::shared_ptr<HeightMapPath> PathGenerator::GenerateRequirements(){
     std::cout << std::endl;
     std::cout << "0.1) Generating Sample Points" << std::endl;
@@ -89,6 +238,43 @@ std::shared_ptr<HeightMapPath> PathGenerator::GenerateRequirements(){
     return GenerateHeightMap(points, material_box_);
 }
 
+void PathGenerator::ReportGouges(const Paths& paths){
+    std::vector<std::pair<std::string, std::shared_ptr<Cutter>>> cutters = {
+            {"1) Roughing", paths.rough_cutter},
+            {"2) Flat Heightmap", paths.flat_heighmap_cutter},
+            {"3) Flat Intersection", paths.flat_intersection_cutter},
+            {"4) Parametrization", paths.parametrization_cutter}
+    };
+    // Distances further than the largest radius are never needed.
+    float band = 0.0f;
+    for(auto& cutter : cutters){
+        if(cutter.second)
+            band = std::max(band, cutter.second->diameter() / 2.0f);
+    }
+    band += gouge_cell_size_;
+
+    ThreadPool pool;
+    auto distance_field = DistanceField::LoadOrBuild(
+            TessellateModel(model_loader_result_, gouge_tessellation_),
+            gouge_cell_size_, band, pool);
+
+    for(auto& cutter : cutters){
+        if(!cutter.second)
+            continue;
+        GougeReport report = CheckGouges(*distance_field,
+                                         cutter.second->type(),
+                                         cutter.second->diameter() / 2.0f,
+                                         cutter.second->instructions());
+        std::cout << cutter.first << " gouges: " << report.gouge_count
+        << " / " << report.position_count << " positions, max depth: "
+        << report.max_depth << " [mm]";
+        if(report.first_gouge_instruction != -1)
+            std::cout << ", first at instruction: "
+            << report.first_gouge_instruction;
+        std::cout << std::endl;
+    }
+}
+
 std::vector<glm::vec3> PathGenerator::GenerateSamplePoints(
         std::shared_ptr<CADModelLoaderResult> model_loader_result){
     std::vector<glm::vec3> points;
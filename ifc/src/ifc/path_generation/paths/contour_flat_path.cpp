@@ -0,0 +1,372 @@
+#include "ifc/path_generation/paths/contour_flat_path.h"
+
+#include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/obstacle_distance_map.h>
+#include <ifc/material/material_box.h>
+#include <ifc/measures.h>
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/machining_time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace {
+// Value of the padding around the height map.
+const float PADDING_DISTANCE = std::numeric_limits<float>::max();
+}
+
+namespace ifc {
+
+ContourFlatPath::ContourFlatPath(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        std::shared_ptr<MaterialBox> material_box) :
+        model_loader_result_(model_loader_result),
+        material_box_(material_box),
+        id_(0){}
+
+ContourFlatPath::~ContourFlatPath(){}
+
+std::shared_ptr<Cutter> ContourFlatPath::Generate(
+        std::shared_ptr<HeightMapPath> height_map_path){
+    std::cout << "2) Generating ContourFlatPath" << std::endl;
+    id_ = 0;
+
+    const float save_height = material_box_->dimensions().depth + 10.0f;
+    const float floor_height = GLToMillimeters(height_map_path->init_height);
+
+    auto obstacle_distance_map = std::shared_ptr<ObstacleDistanceMap>(
+            new ObstacleDistanceMap(height_map_path));
+
+    float max_distance = 0.0f;
+    for(int i = 0; i < obstacle_distance_map->row_count(); i++){
+        for(int j = 0; j < obstacle_distance_map->column_count(); j++){
+            max_distance = std::max(max_distance,
+                                    obstacle_distance_map->GetDistance(i, j));
+        }
+    }
+    // No level can be further from the model than box diagonal.
+    max_distance = std::min(max_distance,
+                            std::sqrt(height_map_path->width_mm
+                                      * height_map_path->width_mm
+                                      + height_map_path->height_mm
+                                      * height_map_path->height_mm));
+
+    // From the border inwards.
+    std::vector<std::vector<std::vector<glm::vec2>>> levels;
+    levels.push_back(CreateContours(obstacle_distance_map,
+                                    std::numeric_limits<float>::max()));
+    std::vector<float> level_distances;
+    for(float level = radius_ + epsilon_; level < max_distance;
+        level += radius_){
+        level_distances.push_back(level);
+    }
+    std::reverse(level_distances.begin(), level_distances.end());
+    for(unsigned int l = 0; l < level_distances.size(); l++){
+        levels.push_back(CreateContours(obstacle_distance_map,
+                                        level_distances[l]));
+    }
+
+    const float tolerance = 0.05f;
+    int contour_count = 0;
+    for(auto& contours : levels){
+        for(auto& contour : contours){
+            contour = SimplifyContour(height_map_path, contour, tolerance);
+            contour_count++;
+        }
+    }
+    std::cout << "Levels: " << levels.size()
+    << ", Contours: " << contour_count << std::endl;
+
+    auto instructions = LinkContours(height_map_path, obstacle_distance_map,
+                                     levels, save_height, floor_height);
+
+    MachiningTimeEstimate estimate = EstimateMachiningTime(instructions);
+    std::cout << "ContourFlatPath estimated time: "
+    << estimate.time_s << " [s]" << std::endl;
+
+    return std::shared_ptr<Cutter>(new Cutter(CutterType::Flat,
+                                              diameter_,
+                                              instructions));
+}
+
+std::vector<std::vector<glm::vec2>> ContourFlatPath::CreateContours(
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+        float level){
+    // Grid padded by one node on each side.
+    int n = obstacle_distance_map->row_count() + 2;
+    int m = obstacle_distance_map->column_count() + 2;
+
+    std::vector<float> values(n * m, PADDING_DISTANCE);
+    for(int i = 1; i < n - 1; i++){
+        for(int j = 1; j < m - 1; j++){
+            values[i * m + j] = obstacle_distance_map->GetDistance(i-1, j-1);
+        }
+    }
+
+    // Edge (i,j) -> (i,j+1) has id 2*(i*m + j),
+    // edge (i,j) -> (i+1,j) has id 2*(i*m + j) + 1.
+    auto horizontal_edge = [m](int i, int j){return 2*(i*m + j);};
+    auto vertical_edge = [m](int i, int j){return 2*(i*m + j) + 1;};
+
+    // Point where contour crosses the edge.
+    auto edge_point = [&values, m, level](int edge){
+        int node = edge / 2;
+        int i = node / m;
+        int j = node % m;
+        glm::vec2 a = glm::vec2(i, j);
+        glm::vec2 b = edge % 2 == 0 ? glm::vec2(i, j+1) : glm::vec2(i+1, j);
+        float va = values[(int)a.x * m + (int)a.y];
+        float vb = values[(int)b.x * m + (int)b.y];
+        float t;
+        // Border loop goes through the last node of the height map.
+        if(va == PADDING_DISTANCE)
+            t = 1.0f;
+        else if(vb == PADDING_DISTANCE)
+            t = 0.0f;
+        else
+            t = (level - va) / (vb - va);
+        // Back to not padded grid coordinates.
+        return a + t * (b - a) - glm::vec2(1, 1);
+    };
+
+    // Two segments for each edge crossed by a contour.
+    std::vector<int> edge_segments(4 * n * m, -1);
+    std::vector<int> segments;
+    auto add_segment = [&edge_segments, &segments](int e1, int e2){
+        int segment = segments.size() / 2;
+        segments.push_back(e1);
+        segments.push_back(e2);
+        for(int e : {e1, e2}){
+            if(edge_segments[2*e] == -1)
+                edge_segments[2*e] = segment;
+            else
+                edge_segments[2*e + 1] = segment;
+        }
+    };
+
+    for(int i = 0; i < n - 1; i++){
+        for(int j = 0; j < m - 1; j++){
+            float a = values[i * m + j];
+            float b = values[i * m + j + 1];
+            float c = values[(i+1) * m + j + 1];
+            float d = values[(i+1) * m + j];
+            int type = (a < level ? 1 : 0) | (b < level ? 2 : 0)
+                       | (c < level ? 4 : 0) | (d < level ? 8 : 0);
+            int e0 = horizontal_edge(i, j);
+            int e1 = vertical_edge(i, j+1);
+            int e2 = horizontal_edge(i+1, j);
+            int e3 = vertical_edge(i, j);
+            // Saddles are resolved by the value in the middle of the cell.
+            bool center_inside = (a/4.0f + b/4.0f + c/4.0f + d/4.0f) < level;
+            switch(type){
+                case 1: case 14: add_segment(e3, e0); break;
+                case 2: case 13: add_segment(e0, e1); break;
+                case 3: case 12: add_segment(e3, e1); break;
+                case 4: case 11: add_segment(e1, e2); break;
+                case 6: case 9: add_segment(e0, e2); break;
+                case 7: case 8: add_segment(e3, e2); break;
+                case 5:
+                    if(center_inside){
+                        add_segment(e0, e1);
+                        add_segment(e2, e3);
+                    }else{
+                        add_segment(e3, e0);
+                        add_segment(e1, e2);
+                    }
+                    break;
+                case 10:
+                    if(center_inside){
+                        add_segment(e3, e0);
+                        add_segment(e1, e2);
+                    }else{
+                        add_segment(e0, e1);
+                        add_segment(e2, e3);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    std::vector<std::vector<glm::vec2>> contours;
+    std::vector<bool> visited(segments.size() / 2, false);
+    for(unsigned int s = 0; s < visited.size(); s++){
+        if(visited[s])
+            continue;
+        std::vector<glm::vec2> contour;
+        int start_edge = segments[2*s];
+        int edge = segments[2*s + 1];
+        int segment = s;
+        contour.push_back(edge_point(start_edge));
+        visited[s] = true;
+        while(edge != start_edge){
+            contour.push_back(edge_point(edge));
+            int next = edge_segments[2*edge] == segment ?
+                       edge_segments[2*edge + 1] : edge_segments[2*edge];
+            if(next == -1 || visited[next])
+                break;
+            visited[next] = true;
+            segment = next;
+            edge = segments[2*next] == edge ?
+                   segments[2*next + 1] : segments[2*next];
+        }
+        contour.push_back(contour[0]);
+        contours.push_back(contour);
+    }
+
+    return contours;
+}
+
+std::vector<glm::vec2> ContourFlatPath::SimplifyContour(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        const std::vector<glm::vec2>& contour, float tolerance){
+    if(contour.size() < 3)
+        return contour;
+    std::vector<glm::vec2> simplified;
+    simplified.push_back(contour[0]);
+    unsigned int anchor = 0;
+    for(unsigned int k = 2; k < contour.size(); k++){
+        float length = Distance(height_map_path, contour[anchor], contour[k]);
+        bool is_within_tolerance = true;
+        for(unsigned int p = anchor + 1; p < k && length > 0.0f; p++){
+            // Distance from the line by area of triangle.
+            float a = Distance(height_map_path, contour[anchor], contour[p]);
+            float b = Distance(height_map_path, contour[p], contour[k]);
+            float s = (a + b + length) / 2.0f;
+            float area = std::sqrt(std::max(
+                    s * (s - a) * (s - b) * (s - length), 0.0f));
+            if(2.0f * area / length > tolerance){
+                is_within_tolerance = false;
+                break;
+            }
+        }
+        if(!is_within_tolerance){
+            anchor = k - 1;
+            simplified.push_back(contour[anchor]);
+        }
+    }
+    simplified.push_back(contour[contour.size() - 1]);
+
+    return simplified;
+}
+
+std::vector<Instruction> ContourFlatPath::LinkContours(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+        std::vector<std::vector<std::vector<glm::vec2>>>& levels,
+        float save_height, float floor_height){
+    std::vector<Instruction> instructions;
+
+    // Enter from outside of the material box.
+    const glm::vec2 save_position = glm::vec2(-MillimetersToGL(radius_*4),0);
+    glm::vec2 current = glm::vec2(0, 0);
+    AddInstruction(instructions,
+                   height_map_path->Position(0, 0) + save_position,
+                   save_height, true);
+    AddInstruction(instructions,
+                   height_map_path->Position(0, 0) + save_position,
+                   floor_height);
+    bool is_entering = true;
+
+    int retract_count = 0;
+    for(auto& contours : levels){
+        std::vector<bool> done(contours.size(), false);
+        for(unsigned int c = 0; c < contours.size(); c++){
+            // Closest point of remaining contours.
+            int best_contour = -1;
+            int best_point = 0;
+            float best_distance = std::numeric_limits<float>::max();
+            for(unsigned int k = 0; k < contours.size(); k++){
+                if(done[k])
+                    continue;
+                for(unsigned int p = 0; p < contours[k].size(); p++){
+                    float distance = Distance(height_map_path,
+                                              current, contours[k][p]);
+                    if(distance < best_distance){
+                        best_distance = distance;
+                        best_contour = k;
+                        best_point = p;
+                    }
+                }
+            }
+            done[best_contour] = true;
+
+            // Rotate closed loop to start at the closest point.
+            auto& contour = contours[best_contour];
+            contour.pop_back();
+            std::rotate(contour.begin(), contour.begin() + best_point,
+                        contour.end());
+            contour.push_back(contour[0]);
+
+            if(!is_entering
+               && IsLinkColliding(obstacle_distance_map, current, contour[0])){
+                AddInstruction(instructions,
+                               Position(height_map_path, current),
+                               save_height, true);
+                AddInstruction(instructions,
+                               Position(height_map_path, contour[0]),
+                               save_height, true);
+                retract_count++;
+            }
+            is_entering = false;
+            for(auto& point : contour){
+                AddInstruction(instructions,
+                               Position(height_map_path, point),
+                               floor_height);
+            }
+            current = contour[contour.size() - 1];
+        }
+    }
+    AddInstruction(instructions, Position(height_map_path, current),
+                   save_height, true);
+    std::cout << "Retracts: " << retract_count << std::endl;
+
+    return instructions;
+}
+
+bool ContourFlatPath::IsLinkColliding(
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+        const glm::vec2& a, const glm::vec2& b){
+    float cells = std::max(std::abs(b.x - a.x), std::abs(b.y - a.y));
+    int steps = std::ceil(2.0f * cells);
+    for(int s = 0; s <= steps; s++){
+        float t = steps == 0 ? 0.0f : (float)s / (float)steps;
+        glm::vec2 p = a + t * (b - a);
+        float distance = obstacle_distance_map->GetDistance(std::round(p.x),
+                                                            std::round(p.y));
+        if(distance < radius_)
+            return true;
+    }
+    return false;
+}
+
+float ContourFlatPath::Distance(std::shared_ptr<HeightMapPath> height_map_path,
+                                const glm::vec2& a, const glm::vec2& b){
+    float dx = (b.x - a.x) * height_map_path->row_width;
+    float dy = (b.y - a.y) * height_map_path->column_width;
+    return std::sqrt(dx*dx + dy*dy);
+}
+
+glm::vec2 ContourFlatPath::Position(
+        std::shared_ptr<HeightMapPath> height_map_path, const glm::vec2& p){
+    const glm::vec2& origin = height_map_path->Position(0, 0);
+    glm::vec2 row_direction = height_map_path->Position(1, 0) - origin;
+    glm::vec2 column_direction = height_map_path->Position(0, 1) - origin;
+    return origin + p.x * row_direction + p.y * column_direction;
+}
+
+void ContourFlatPath::AddInstruction(std::vector<Instruction>& instructions,
+                                     const glm::vec2& v, float height,
+                                     bool fast){
+    glm::vec3 pos = glm::vec3(GLToMillimeters(v.x),
+                              GLToMillimeters(v.y),
+                              height);
+    InstructionSpeedMode speed_mode = fast ? InstructionSpeedMode::FAST
+                                           : InstructionSpeedMode::NORMAL;
+    instructions.push_back(Instruction(id_++, pos, speed_mode));
+}
+
+}
@@ -1,6 +1,7 @@
 #include "ifc/path_generation/paths/flat_around_hm_path.h"
 
 #include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/obstacle_distance_map.h>
 #include <ifc/material/material_box.h>
 #include <ifc/cutter/cutter_loader.h>
 
@@ -32,28 +33,28 @@ std::shared_ptr<Cutter> FlatAroundHMPath::CreatePath(
     const float save_height = material_box->dimensions().depth + 10.0f;
     const float epsilon = 0.5f;
 
-    int look_ahead_radius_row
-            = (radius_ + epsilon) / height_map_path->row_width;
-    int look_ahead_radius_column
-            = (radius_ + epsilon) / height_map_path->column_width;
+    const float stop_distance = radius_ + epsilon;
+    auto obstacle_distance_map = std::shared_ptr<ObstacleDistanceMap>(
+            new ObstacleDistanceMap(height_map_path));
+
     int skip_columns = (radius_-epsilon) / height_map_path->column_width;
     int skip_rows = (radius_-epsilon) / height_map_path->row_width;
 
     float start_height
             = GLToMillimeters(height_map_path->init_height) + radius_;
     auto instructions = CreatePathFirstHalf(height_map_path,
+                                            obstacle_distance_map,
                                             save_height, start_height,
                                             radius_, n, m,
                                             skip_rows, skip_columns,
-                                            look_ahead_radius_row,
-                                            look_ahead_radius_column);
+                                            stop_distance);
 
     auto instructions2 = CreatePathSecondHalf(height_map_path,
+                                              obstacle_distance_map,
                                               save_height, start_height,
                                               radius_, n, m,
                                               skip_rows, skip_columns,
-                                              look_ahead_radius_row,
-                                              look_ahead_radius_column);
+                                              stop_distance);
     instructions.insert(instructions.end(),
                         instructions2.begin(),
                         instructions2.end());
@@ -65,10 +66,11 @@ std::shared_ptr<Cutter> FlatAroundHMPath::CreatePath(
 
 std::vector<Instruction> FlatAroundHMPath::CreatePathSecondHalf(
         std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
         float save_height, float start_height, float radius,
         int n, int m,
         int skip_rows, int skip_columns,
-        int look_ahead_radius_row, int look_ahead_radius_column){
+        float stop_distance){
     float current_height = start_height - radius;
 
     std::vector<std::vector<glm::vec3>> lines;
@@ -83,9 +85,7 @@ std::vector<Instruction> FlatAroundHMPath::CreatePathSecondHalf(
                     GLToMillimeters(height_map_path->Position(i,j).y),
                     current_height));
 
-            if(ShouldGoBack(i, j, n, m,
-                            look_ahead_radius_row,
-                            look_ahead_radius_column,height_map_path)){
+            if(ShouldGoBack(i, j, obstacle_distance_map, stop_distance)){
                 break;
             }
         }
@@ -151,10 +151,11 @@ std::vector<Instruction> FlatAroundHMPath::CreatePathSecondHalf(
 
 std::vector<Instruction> FlatAroundHMPath::CreatePathFirstHalf(
         std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
         float save_height, float start_height, float radius,
         int n, int m,
         int skip_rows, int skip_columns,
-        int look_ahead_radius_row, int look_ahead_radius_column){
+        float stop_distance){
     float current_height = start_height - radius;
 
     std::vector<std::vector<glm::vec3>> lines;
@@ -169,9 +170,7 @@ std::vector<Instruction> FlatAroundHMPath::CreatePathFirstHalf(
                     GLToMillimeters(height_map_path->Position(i,j).y),
                     current_height));
 
-            if(ShouldGoBack(i, j, n, m,
-                            look_ahead_radius_row,
-                            look_ahead_radius_column,height_map_path)){
+            if(ShouldGoBack(i, j, obstacle_distance_map, stop_distance)){
                 break;
             }
         }
@@ -234,24 +233,12 @@ std::vector<Instruction> FlatAroundHMPath::CreatePathFirstHalf(
     return instructions;
 }
 
-bool FlatAroundHMPath::ShouldGoBack(int i, int j, int n, int m,
-                                int look_ahead_radius_row,
-                                int look_ahead_radius_column,
-                                std::shared_ptr<HeightMapPath> height_map_path){
+bool FlatAroundHMPath::ShouldGoBack(
+        int i, int j,
+        std::shared_ptr<ObstacleDistanceMap> obstacle_distance_map,
+        float stop_distance){
     // Go back if encoutered obstacle
-    for(int ii = -look_ahead_radius_row; ii < look_ahead_radius_row; ii++){
-        if(ii + i < 0 || ii + i >= n)
-            continue;
-        for(int jj = -look_ahead_radius_column; jj < look_ahead_radius_column; jj++){
-            if(jj + j < 0 || jj + j >= m)
-                continue;
-            if(height_map_path->GetHeight(ii+i,jj+j) >
-               height_map_path->init_height){
-                return true;
-            }
-        }
-    }
-    return false;
+    return obstacle_distance_map->GetDistance(i, j) <= stop_distance;
 }
 
 Instruction FlatAroundHMPath::CreateInstruction(int id,
@@ -3,6 +3,9 @@
 #include <ifc/material/material_box.h>
 #include <ifc/factory/cad_model_loader.h>
 #include <ifc/cutter/cutter.h>
+#include <ifc/geometry/point_kd_tree.h>
+#include <ifc/path_generation/intersection_service.h>
+#include <ifc/path_generation/offset_curve.h>
 
 #include <infinity_cad/geometry/intersection/intersection.h>
 #include <infinity_cad/rendering/render_objects/surfaces/surface_c2_rect.h>
@@ -12,15 +15,19 @@
 #include <object/render_object.h>
 #include <factory/program_factory.h>
 
+#include <algorithm>
+
 namespace ifc {
 
 FlatAroundIntersectionPath::FlatAroundIntersectionPath(
         std::shared_ptr<CADModelLoaderResult> model_loader_result,
         std::shared_ptr<MaterialBox> material_box,
-        std::shared_ptr<ifx::Scene> scene) :
+        std::shared_ptr<ifx::Scene> scene,
+        std::shared_ptr<IntersectionService> intersection_service) :
         model_loader_result_(model_loader_result),
         material_box_(material_box),
         scene_(scene),
+        intersection_service_(intersection_service),
         generated_(false){}
 
 FlatAroundIntersectionPath::~FlatAroundIntersectionPath(){}
@@ -29,7 +36,8 @@ std::shared_ptr<Cutter> FlatAroundIntersectionPath::Generate(){
     generated_ = true;
     std::cout << "3) Generating FlatAroundIntersectionPath" << std::endl;
 
-    ComputeIntersections();
+    if(!ComputeIntersections())
+        return nullptr;
     CutterTrajectory trajectory = CreateTrajectory(intersections_data_);
 
     // Used in final stage
@@ -38,222 +46,147 @@ std::shared_ptr<Cutter> FlatAroundIntersectionPath::Generate(){
     return CreatePath(trajectory);
 }
 
-void FlatAroundIntersectionPath::ComputeIntersections(){
-    intersections_data_.base_top_intersection = ComputeBaseTopIntersection(
-            NormalDirection::DOWN);
-    intersections_data_.base_bottom_intersection = ComputeBaseBottomIntersection(
-            NormalDirection::DOWN);
-    intersections_data_.hand_top_intersection = ComputeHandTopIntersection(
-            NormalDirection::DOWN);
-    intersections_data_.hand_bottom_intersection
-            = ComputeHandBottomIntersection(NormalDirection::DOWN);
-    intersections_data_.drill_left_intersection = ComputeDrillLeftIntersection(
-            NormalDirection::UP);
-    intersections_data_.drill_right_intersection = ComputeDrillRightIntersection(
-            NormalDirection::UP);
-}
-
-std::vector<TracePoint> FlatAroundIntersectionPath::ComputeIntersection(
-        std::shared_ptr<SurfaceC2Cylind> surface1,
-        std::shared_ptr<SurfaceC2Rect> surface2,
-        glm::vec3 start_pos){
-    glm::vec4 init_point4 = glm::vec4(
-            start_pos.x, start_pos.y, start_pos.z, 1.0f);
-    init_point4
-            = model_loader_result_->cad_model->render_object->GetModelMatrix()
-              * init_point4;
-    glm::vec3 init_point = glm::vec3(init_point4.x,
-                                     init_point4.y,
-                                     init_point4.z);
-    auto intersection = std::unique_ptr<Intersection>(new Intersection(
-            surface1.get(),
-            surface2.get()));
-    intersection->start(init_point);
-
-    const std::vector<TracePoint>& trace_points
-            = intersection->getTracePoints();
-
-    return trace_points;
+void FlatAroundIntersectionPath::RequestIntersections(){
+    const int surface = IntersectionService::INTERSECTION_SURFACE;
+    intersection_service_->RequestAll(0, surface);
+    intersection_service_->RequestAll(1, surface);
+    intersection_service_->RequestAll(2, surface);
 }
 
-std::shared_ptr<BoxIntersectionData>
-        FlatAroundIntersectionPath::ComputeBaseTopIntersection(
-                NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[0];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, 1.89, 0.88));
-    //0, 1.68, -0.28))
-    auto render_object = CreateRenderObject(trace_points, "Base Top");
-    scene_->AddRenderObject(render_object);
-
-    auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
-    data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
-
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
-    data->double_equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction, 2.0f);
+bool FlatAroundIntersectionPath::ComputeIntersections(){
+    RequestIntersections();
+
+    const int surface = IntersectionService::INTERSECTION_SURFACE;
+    auto base = intersection_service_->TraceAll(0, surface);
+    auto hand = intersection_service_->TraceAll(1, surface);
+    auto drill = intersection_service_->TraceAll(2, surface);
+    if(base.size() != 2 || hand.size() != 2 || drill.size() != 2){
+        std::cout << "Expected 2 intersections of Base, Hand and Drill, "
+        << "found: " << base.size() << ", " << hand.size() << ", "
+        << drill.size() << std::endl;
+        return false;
+    }
 
-    return data;
+    // Hand is attached to the top of the base.
+    std::vector<TracePoint> hand_points = hand[0];
+    hand_points.insert(hand_points.end(), hand[1].begin(), hand[1].end());
+    if(GetDistance(base[0], hand_points) > GetDistance(base[1], hand_points))
+        std::swap(base[0], base[1]);
+    intersections_data_.base_top_intersection = ComputeIntersection(
+            base[0], 0, "Base Top", NormalDirection::DOWN);
+    AddOffsetRenderObject(intersections_data_.base_top_intersection, 2.0f);
+    intersections_data_.base_bottom_intersection = ComputeIntersection(
+            base[1], 0, "Base Bottom", NormalDirection::DOWN);
+
+    // Top of the hand is its outer edge, further from the base.
+    auto& base_top = intersections_data_.base_top_intersection->trace_points;
+    if(GetMeanDistance(hand[0], base_top) < GetMeanDistance(hand[1], base_top))
+        std::swap(hand[0], hand[1]);
+    intersections_data_.hand_top_intersection = ComputeIntersection(
+            hand[0], 1, "Hand Top", NormalDirection::DOWN);
+    intersections_data_.hand_bottom_intersection = ComputeIntersection(
+            hand[1], 1, "Hand Bottom", NormalDirection::DOWN);
+    AddOffsetRenderObject(intersections_data_.hand_bottom_intersection, 2.0f);
+
+    // Left side of the drill is met first along the base bottom.
+    auto& base_bottom
+            = intersections_data_.base_bottom_intersection->trace_points;
+    if(GetClosestPointsIndices(base_bottom, drill[0], 0, drill[0].size()).x
+       > GetClosestPointsIndices(base_bottom, drill[1], 0, drill[1].size()).x)
+        std::swap(drill[0], drill[1]);
+    intersections_data_.drill_left_intersection = ComputeIntersection(
+            drill[0], 2, "Drill Left", NormalDirection::UP);
+    intersections_data_.drill_right_intersection = ComputeIntersection(
+            drill[1], 2, "Drill Right", NormalDirection::UP);
+
+    return true;
 }
 
 std::shared_ptr<BoxIntersectionData>
-        FlatAroundIntersectionPath::ComputeBaseBottomIntersection(
+        FlatAroundIntersectionPath::ComputeIntersection(
+                const std::vector<TracePoint>& trace_points,
+                int surface, std::string name,
                 NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[0];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, 0.47, -0.35));
-    auto render_object = CreateRenderObject(trace_points, "Base Bottom");
-    scene_->AddRenderObject(render_object);
-
     auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
     data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
+    data->surface = model_loader_result_->cad_model->surfaces[surface];
+    data->offset_curve = CreateOffsetCurve(data, normal_direction);
+    Orient(data, normal_direction);
 
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
+    data->render_object = CreateRenderObject(data->trace_points, name);
+    scene_->AddRenderObject(data->render_object);
+    AddOffsetRenderObject(data);
 
     return data;
 }
 
-std::shared_ptr<BoxIntersectionData>
-FlatAroundIntersectionPath::ComputeDrillLeftIntersection(
+void FlatAroundIntersectionPath::Orient(
+        std::shared_ptr<BoxIntersectionData> intersection_data,
         NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[2];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, -0.25, 0.95));
-    // glm::vec3(0, -0.74, 0.83)
-    auto render_object = CreateRenderObject(trace_points, "Drill Left");
-    scene_->AddRenderObject(render_object);
-
-    auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
-    data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
-
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
+    const glm::vec3 up = glm::vec3(0, 1, 0);
+    auto& trace_points = intersection_data->trace_points;
+    auto& offset_points = intersection_data->offset_curve->Offset(1.0f);
+
+    float side = 0.0f;
+    for(unsigned int i = 0; i + 1 < trace_points.size(); i++){
+        glm::vec3 tangent = trace_points[i + 1].point - trace_points[i].point;
+        glm::vec3 offset = offset_points[i].point - trace_points[i].point;
+        side += glm::dot(glm::cross(tangent, up), offset);
+    }
+    if(side >= 0.0f)
+        return;
 
-    return data;
+    std::reverse(trace_points.begin(), trace_points.end());
+    intersection_data->offset_curve
+            = CreateOffsetCurve(intersection_data, normal_direction);
 }
 
-std::shared_ptr<BoxIntersectionData>
-FlatAroundIntersectionPath::ComputeDrillRightIntersection(
-        NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[2];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, -0.25, 0.69));
-    // glm::vec3(0, -0.74, 0.83)
-    auto render_object = CreateRenderObject(trace_points, "Drill Right");
-    scene_->AddRenderObject(render_object);
-
-    auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
-    data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
-
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
-
-    return data;
+float FlatAroundIntersectionPath::GetDistance(
+        const std::vector<TracePoint>& trace_points1,
+        const std::vector<TracePoint>& trace_points2){
+    std::vector<glm::vec3> points1;
+    std::vector<glm::vec3> points2;
+    for(auto& trace_point : trace_points1)
+        points1.push_back(trace_point.point);
+    for(auto& trace_point : trace_points2)
+        points2.push_back(trace_point.point);
+
+    return FindClosestPair(points1, points2, 0, points2.size()).distance;
 }
 
-std::shared_ptr<BoxIntersectionData>
-        FlatAroundIntersectionPath::ComputeHandTopIntersection(
-                NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[1];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, 2.60, -0.17));
-    auto render_object = CreateRenderObject(trace_points, "Hand Top");
-    scene_->AddRenderObject(render_object);
-
-    auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
-    data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
-
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
-
-    return data;
+float FlatAroundIntersectionPath::GetMeanDistance(
+        const std::vector<TracePoint>& trace_points1,
+        const std::vector<TracePoint>& trace_points2){
+    std::vector<glm::vec3> points2;
+    for(auto& trace_point : trace_points2)
+        points2.push_back(trace_point.point);
+    PointKDTree tree(points2);
+
+    float sum = 0.0f;
+    for(auto& trace_point : trace_points1){
+        sum += ifx::EuclideanDistance(
+                trace_point.point,
+                tree.point(tree.FindNearest(trace_point.point)));
+    }
+    return sum / trace_points1.size();
 }
-std::shared_ptr<BoxIntersectionData>
-        FlatAroundIntersectionPath::ComputeHandBottomIntersection(
-                NormalDirection normal_direction){
-    auto surface = model_loader_result_->cad_model->surfaces[1];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    surface,
-                    model_loader_result_->interection_model->surface,
-                    glm::vec3(0, 2.29, -0.17));
-    auto render_object = CreateRenderObject(trace_points, "Hand Bottom");
-    scene_->AddRenderObject(render_object);
-
-    auto data = std::shared_ptr<BoxIntersectionData>(new BoxIntersectionData());
-    data->trace_points = trace_points;
-    data->surface = surface;
-    data->render_object = render_object;
 
-    data->equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction);
-
-    data->double_equally_distanced
-            = ComputeEqualDistancedIntersections(data, normal_direction, 2.0f);
-
-    return data;
+std::shared_ptr<OffsetCurve> FlatAroundIntersectionPath::CreateOffsetCurve(
+        std::shared_ptr<BoxIntersectionData> intersection_data,
+        NormalDirection normal_direction){
+    float normal_sign = normal_direction == NormalDirection::UP ? -1.0f : 1.0f;
+    return std::shared_ptr<OffsetCurve>(new OffsetCurve(
+            intersection_data->trace_points, MillimetersToGL(radius_),
+            intersection_data->surface, normal_sign));
 }
 
-
-std::shared_ptr<BoxIntersectionData>
-FlatAroundIntersectionPath::ComputeEqualDistancedIntersections(
+void FlatAroundIntersectionPath::AddOffsetRenderObject(
         std::shared_ptr<BoxIntersectionData> intersection_data,
-        NormalDirection normal_direction,
         float distance_scalar){
-    auto equally_distanced_data = std::make_shared<BoxIntersectionData>();
-    int size = intersection_data->trace_points.size();
-    equally_distanced_data->trace_points = intersection_data->trace_points;
-    equally_distanced_data->surface = intersection_data->surface;
-
-    for(int i = 0; i < size; i++){
-        glm::vec4& params = equally_distanced_data->trace_points[i].params;
-        glm::vec3 du = equally_distanced_data->surface->computeDu(params.x,
-                                                                  params.y);
-        glm::vec3 dv = equally_distanced_data->surface->computeDv(params.x,
-                                                                  params.y);
-        glm::vec3 normal;
-        if(normal_direction == NormalDirection::UP)
-            normal = glm::normalize(glm::cross(du,dv));
-        if(normal_direction == NormalDirection::DOWN)
-            normal = glm::normalize(glm::cross(dv,du));
-
-        equally_distanced_data->trace_points[i].point
-                += distance_scalar * MillimetersToGL(radius_) * normal;
-    }
     std::string name = intersection_data->render_object->id().name();
     name += "_ed";
-    equally_distanced_data->render_object
-            = CreateRenderObject(equally_distanced_data->trace_points, name);
-    scene_->AddRenderObject(equally_distanced_data->render_object);
-
-    return equally_distanced_data;
+    scene_->AddRenderObject(CreateRenderObject(
+            intersection_data->offset_curve->Offset(distance_scalar), name));
 }
 
 std::shared_ptr<ifx::RenderObject> FlatAroundIntersectionPath::CreateRenderObject(
@@ -335,31 +268,33 @@ CutterTrajectory FlatAroundIntersectionPath::CreateTrajectory(
 std::vector<glm::vec3> FlatAroundIntersectionPath::CreateBaseHandTrajectory(
         BoxIntersectionsData& intersections_data_){
     std::vector<glm::vec3> positions;
-    auto base_top
-            = intersections_data_.base_top_intersection->equally_distanced;
-    auto hand_top
-            = intersections_data_.hand_top_intersection->equally_distanced;
+    auto& base_top
+            = intersections_data_.base_top_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& hand_top
+            = intersections_data_.hand_top_intersection
+                    ->offset_curve->Offset(1.0f);
 
     glm::vec2 base_hand_indicies1
-            = GetClosestPointsIndices(base_top->trace_points,
-                                      hand_top->trace_points,
-                                      0, hand_top->trace_points.size()/2);
+            = GetClosestPointsIndices(base_top,
+                                      hand_top,
+                                      0, hand_top.size()/2);
     glm::vec2 base_hand_indicies2
-            = GetClosestPointsIndices(base_top->trace_points,
-                                      hand_top->trace_points,
-                                      hand_top->trace_points.size()/2,
-                                      hand_top->trace_points.size());
+            = GetClosestPointsIndices(base_top,
+                                      hand_top,
+                                      hand_top.size()/2,
+                                      hand_top.size());
 
     for(int i = 0; i < base_hand_indicies1.x; i++){
-        positions.push_back(base_top->trace_points[i].point
+        positions.push_back(base_top[i].point
         );
     }
     for(int i = base_hand_indicies1.y; i < base_hand_indicies2.y; i++){
-        positions.push_back(hand_top->trace_points[i].point
+        positions.push_back(hand_top[i].point
         );
     }
-    for(int i = base_hand_indicies2.x; i < base_top->trace_points.size(); i++){
-        positions.push_back(base_top->trace_points[i].point
+    for(int i = base_hand_indicies2.x; i < base_top.size(); i++){
+        positions.push_back(base_top[i].point
         );
     }
 
@@ -371,15 +306,17 @@ FlatAroundIntersectionPath::CreateBaseTopBottomTrajectory(
         BoxIntersectionsData& intersections_data_){
     std::vector<glm::vec3> positions;
 
-    auto base_top
-            = intersections_data_.base_top_intersection->equally_distanced;
-    auto base_bottom
-            = intersections_data_.base_bottom_intersection->equally_distanced;
+    auto& base_top
+            = intersections_data_.base_top_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& base_bottom
+            = intersections_data_.base_bottom_intersection
+                    ->offset_curve->Offset(1.0f);
 
     positions.push_back(
-            base_top->trace_points[base_top->trace_points.size()-1].point);
+            base_top[base_top.size()-1].point);
     positions.push_back(
-            base_bottom->trace_points[0].point);
+            base_bottom[0].point);
 
     return positions;
 }
@@ -389,21 +326,23 @@ FlatAroundIntersectionPath::CreateBaseDrillLeftTrajectory(
         BoxIntersectionsData& intersections_data_){
     std::vector<glm::vec3> positions;
 
-    auto drill_left
-            = intersections_data_.drill_left_intersection->equally_distanced;
-    auto base_bottom
-            = intersections_data_.base_bottom_intersection->equally_distanced;
+    auto& drill_left
+            = intersections_data_.drill_left_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& base_bottom
+            = intersections_data_.base_bottom_intersection
+                    ->offset_curve->Offset(1.0f);
 
     glm::vec2 indicies
-            = GetClosestPointsIndices(base_bottom->trace_points,
-                                      drill_left->trace_points,
-                                      0, drill_left->trace_points.size());
+            = GetClosestPointsIndices(base_bottom,
+                                      drill_left,
+                                      0, drill_left.size());
 
     for(int i = 0; i < indicies.x; i++){
-        positions.push_back(base_bottom->trace_points[i].point);
+        positions.push_back(base_bottom[i].point);
     }
-    for(int i = indicies.y; i > 0; i--){
-        positions.push_back(drill_left->trace_points[i].point);
+    for(int i = indicies.y; i < (int)drill_left.size() - 1; i++){
+        positions.push_back(drill_left[i].point);
     }
 
     return positions;
@@ -412,16 +351,18 @@ FlatAroundIntersectionPath::CreateBaseDrillLeftTrajectory(
 std::vector<glm::vec3>
 FlatAroundIntersectionPath::CreateDrillLeftRightTrajectory(
         BoxIntersectionsData& intersections_data_){
-    auto drill_left
-            = intersections_data_.drill_left_intersection->equally_distanced;
-    auto drill_right
-            = intersections_data_.drill_right_intersection->equally_distanced;
+    auto& drill_left
+            = intersections_data_.drill_left_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& drill_right
+            = intersections_data_.drill_right_intersection
+                    ->offset_curve->Offset(1.0f);
 
     std::vector<glm::vec3> positions;
 
-    positions.push_back(drill_left->trace_points[0].point);
     positions.push_back(
-            drill_right->trace_points[drill_right->trace_points.size()-1].point);
+            drill_left[drill_left.size()-1].point);
+    positions.push_back(drill_right[0].point);
 
     return positions;
 }
@@ -429,21 +370,23 @@ FlatAroundIntersectionPath::CreateDrillLeftRightTrajectory(
 std::vector<glm::vec3>
 FlatAroundIntersectionPath::CreateDrillRightBaseBottomTrajectory(
         BoxIntersectionsData& intersections_data_){
-    auto drill_right
-            = intersections_data_.drill_right_intersection->equally_distanced;
-    auto base_bottom
-            = intersections_data_.base_bottom_intersection->equally_distanced;
+    auto& drill_right
+            = intersections_data_.drill_right_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& base_bottom
+            = intersections_data_.base_bottom_intersection
+                    ->offset_curve->Offset(1.0f);
 
     std::vector<glm::vec3> positions;
     glm::vec2 indicies
-            = GetClosestPointsIndices(drill_right->trace_points,
-                                      base_bottom->trace_points,
-                                      0, base_bottom->trace_points.size());
-    for(int i = drill_right->trace_points.size()-1; i > indicies.x; i--){
-        positions.push_back(drill_right->trace_points[i].point);
+            = GetClosestPointsIndices(drill_right,
+                                      base_bottom,
+                                      0, base_bottom.size());
+    for(int i = 0; i < indicies.x; i++){
+        positions.push_back(drill_right[i].point);
     }
-    for(int i = indicies.y; i < base_bottom->trace_points.size();i++){
-        positions.push_back(base_bottom->trace_points[i].point);
+    for(int i = indicies.y; i < base_bottom.size();i++){
+        positions.push_back(base_bottom[i].point);
     }
 
     return positions;
@@ -452,72 +395,78 @@ FlatAroundIntersectionPath::CreateDrillRightBaseBottomTrajectory(
 std::vector<glm::vec3>
 FlatAroundIntersectionPath::CreateBaseBottomTopTrajectory(
         BoxIntersectionsData& intersections_data_){
-    auto base_bottom
-            = intersections_data_.base_bottom_intersection->equally_distanced;
-    auto base_top
-            = intersections_data_.base_top_intersection->equally_distanced;
+    auto& base_bottom
+            = intersections_data_.base_bottom_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& base_top
+            = intersections_data_.base_top_intersection
+                    ->offset_curve->Offset(1.0f);
 
     std::vector<glm::vec3> positions;
 
     positions.push_back(
-            base_bottom->trace_points[base_bottom->trace_points.size()-1].point);
+            base_bottom[base_bottom.size()-1].point);
     positions.push_back(
-            base_top->trace_points[0].point);
+            base_top[0].point);
 
     return positions;
 }
 
 std::vector<glm::vec3> FlatAroundIntersectionPath::CreateInsideHandTrajectory(
         BoxIntersectionsData& intersections_data_){
-    auto curve1
-            = intersections_data_.hand_bottom_intersection->equally_distanced;
-    auto curve2
-            = intersections_data_.base_top_intersection->equally_distanced;
+    auto& curve1
+            = intersections_data_.hand_bottom_intersection
+                    ->offset_curve->Offset(1.0f);
+    auto& curve2
+            = intersections_data_.base_top_intersection
+                    ->offset_curve->Offset(1.0f);
 
     std::vector<glm::vec3> positions;
     glm::vec2 indicies1
-            = GetClosestPointsIndices(curve1->trace_points,
-                                      curve2->trace_points,
-                                      0, curve2->trace_points.size() / 2);
+            = GetClosestPointsIndices(curve1,
+                                      curve2,
+                                      0, curve2.size() / 2);
 
     glm::vec2 indicies2
-            = GetClosestPointsIndices(curve1->trace_points,
-                                      curve2->trace_points,
-                                      curve2->trace_points.size() / 2,
-                                      curve2->trace_points.size());
+            = GetClosestPointsIndices(curve1,
+                                      curve2,
+                                      curve2.size() / 2,
+                                      curve2.size());
 
     for(int i = indicies1.x;  i > indicies2.x; i--){
-        positions.push_back(curve1->trace_points[i].point);
+        positions.push_back(curve1[i].point);
     }
     for(int i = indicies2.y; i > indicies1.y ;i--){
-        positions.push_back(curve2->trace_points[i].point);
+        positions.push_back(curve2[i].point);
     }
 
 
 
 
 
-    auto curve11
-            = intersections_data_.hand_bottom_intersection->double_equally_distanced;
-    auto curve22
-            = intersections_data_.base_top_intersection->double_equally_distanced;
+    auto& curve11
+            = intersections_data_.hand_bottom_intersection
+                    ->offset_curve->Offset(2.0f);
+    auto& curve22
+            = intersections_data_.base_top_intersection
+                    ->offset_curve->Offset(2.0f);
 
     glm::vec2 indicies11
-            = GetClosestPointsIndices(curve11->trace_points,
-                                      curve22->trace_points,
-                                      0, curve22->trace_points.size() / 2);
+            = GetClosestPointsIndices(curve11,
+                                      curve22,
+                                      0, curve22.size() / 2);
 
     glm::vec2 indicies22
-            = GetClosestPointsIndices(curve11->trace_points,
-                                      curve22->trace_points,
-                                      curve22->trace_points.size() / 2,
-                                      curve22->trace_points.size());
+            = GetClosestPointsIndices(curve11,
+                                      curve22,
+                                      curve22.size() / 2,
+                                      curve22.size());
 
     for(int i = indicies11.x;  i > indicies22.x; i--){
-        positions.push_back(curve11->trace_points[i].point);
+        positions.push_back(curve11[i].point);
     }
     for(int i = indicies22.y; i > indicies11.y ;i--){
-        positions.push_back(curve22->trace_points[i].point);
+        positions.push_back(curve22[i].point);
     }
 
     for(unsigned int i = 0; i < positions.size(); i++){
@@ -532,24 +481,24 @@ std::vector<glm::vec3> FlatAroundIntersectionPath::CreateInsideHandTrajectory(
 }
 
 glm::vec2 FlatAroundIntersectionPath::GetClosestPointsIndices(
-        std::vector<TracePoint>& trace_points1,
-        std::vector<TracePoint>& trace_points2,
+        const std::vector<TracePoint>& trace_points1,
+        const std::vector<TracePoint>& trace_points2,
         int start2, int finish2){
+    std::vector<glm::vec3> points1;
+    std::vector<glm::vec3> points2;
+    for(auto& trace_point : trace_points1)
+        points1.push_back(trace_point.point);
+    for(auto& trace_point : trace_points2)
+        points2.push_back(trace_point.point);
+
+    auto closest_pair = FindClosestPair(points1, points2, start2, finish2);
+
     glm::vec2 smallest_indices;
-    float smallest_distance = 9999.0f;
     smallest_indices.x = 0;
     smallest_indices.y = 0;
-
-    for(int i = 0; i < trace_points1.size(); i++){
-        for(int j = start2; j < finish2; j++){
-            float distance = ifx::EuclideanDistance(trace_points1[i].point,
-                                                    trace_points2[j].point);
-            if(distance < smallest_distance){
-                smallest_distance = distance;
-                smallest_indices.x = i;
-                smallest_indices.y = j;
-            }
-        }
+    if(closest_pair.index1 != -1){
+        smallest_indices.x = closest_pair.index1;
+        smallest_indices.y = closest_pair.index2;
     }
     return smallest_indices;
 }
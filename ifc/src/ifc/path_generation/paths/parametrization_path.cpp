@@ -1,11 +1,18 @@
 #include "ifc/path_generation/paths/parametrization_path.h"
 
 #include <ifc/cutter/cutter.h>
+#include <ifc/cutter/machining_time.h>
+#include <ifc/geometry/point_kd_tree.h>
 #include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
 #include <infinity_cad/geometry/intersection/intersection.h>
 
 #include <ifc/path_generation/paths/flat_around_intersection_path.h>
+#include <ifc/path_generation/adaptive_step.h>
+#include <ifc/path_generation/intersection_service.h>
+#include <ifc/path_generation/link_optimizer.h>
+#include <ifc/path_generation/offset_curve.h>
 #include <ifc/material/material_box.h>
+#include <ifc/material/height_map.h>
 #include <ifc/factory/cad_model_loader.h>
 #include <rendering/scene/scene.h>
 #include <factory/program_factory.h>
@@ -14,15 +21,27 @@
 
 #include <algorithm>
 
+namespace {
+// Mean v of the second surface, params are (u1, v1, u2, v2).
+float MeanSecondV(const std::vector<TracePoint>& trace_points){
+    float sum = 0.0f;
+    for(auto& trace_point : trace_points)
+        sum += trace_point.params.w;
+    return sum / trace_points.size();
+}
+}
+
 namespace ifc{
 
 ParametrizationPath::ParametrizationPath(
         std::shared_ptr<CADModelLoaderResult> model_loader_result,
         std::shared_ptr<MaterialBox> material_box,
-        std::shared_ptr<ifx::Scene> scene) :
+        std::shared_ptr<ifx::Scene> scene,
+        std::shared_ptr<IntersectionService> intersection_service) :
         model_loader_result_(model_loader_result),
         material_box_(material_box),
         scene_(scene),
+        intersection_service_(intersection_service),
         id_(0) { }
 
 ParametrizationPath::~ParametrizationPath(){ }
@@ -30,49 +49,46 @@ ParametrizationPath::~ParametrizationPath(){ }
 std::shared_ptr<Cutter> ParametrizationPath::Generate(
         std::vector<glm::vec3>& positions){
     std::cout << "4) ParametrizationPath" << std::endl;
-    ComputeIntersections();
+    if(!ComputeIntersections())
+        return nullptr;
     return CreatePath(positions);
 }
 
-void ParametrizationPath::ComputeIntersections(){
-    std::cout << "Computing Intersections" << std::endl;
-    intersections_data_.base_hand_left_ = ComputeBaseHandLeftIntersection();
-    intersections_data_.base_hand_right_ = ComputeBaseHandRightIntersection();
-    intersections_data_.base_drill_ = ComputeBaseDrillIntersection();
+void ParametrizationPath::RequestIntersections(){
+    intersection_service_->RequestAll(0, 1);
+    intersection_service_->RequestAll(0, 2);
 }
 
-std::vector<TracePoint> ParametrizationPath::ComputeIntersection(
-        std::shared_ptr<SurfaceC2Cylind> surface1,
-        std::shared_ptr<SurfaceC2Cylind> surface2,
-        glm::vec3 start_pos){
-    glm::vec4 init_point4 = glm::vec4(
-            start_pos.x, start_pos.y, start_pos.z, 1.0f);
-    init_point4
-            = model_loader_result_->cad_model->render_object->GetModelMatrix()
-              * init_point4;
-    glm::vec3 init_point = glm::vec3(init_point4.x,
-                                     init_point4.y,
-                                     init_point4.z);
-    auto intersection = std::unique_ptr<Intersection>(new Intersection(
-            surface1.get(),
-            surface2.get()));
-    intersection->start(init_point);
-
-    const std::vector<TracePoint>& trace_points
-            = intersection->getTracePoints();
-
-    return trace_points;
+bool ParametrizationPath::ComputeIntersections(){
+    std::cout << "Computing Intersections" << std::endl;
+    RequestIntersections();
+    auto base_hand = intersection_service_->TraceAll(0, 1);
+    auto base_drill = intersection_service_->TraceAll(0, 2);
+    if(base_hand.size() != 2 || base_drill.size() != 1){
+        std::cout << "Expected 2 Base-Hand and 1 Base-Drill intersections, "
+        << "found: " << base_hand.size() << ", " << base_drill.size()
+        << std::endl;
+        return false;
+    }
+
+    // Hand rows run along its v, from the left intersection to the right.
+    if(MeanSecondV(base_hand[0]) > MeanSecondV(base_hand[1]))
+        std::swap(base_hand[0], base_hand[1]);
+
+    intersections_data_.base_hand_left_
+            = ComputeBaseHandLeftIntersection(base_hand[0]);
+    intersections_data_.base_hand_right_
+            = ComputeBaseHandRightIntersection(base_hand[1]);
+    intersections_data_.base_drill_
+            = ComputeBaseDrillIntersection(base_drill[0]);
+    return true;
 }
 
 std::shared_ptr<IntersectionData>
-        ParametrizationPath::ComputeBaseHandRightIntersection(){
+        ParametrizationPath::ComputeBaseHandRightIntersection(
+                std::vector<TracePoint> trace_points){
     auto base_surface = model_loader_result_->cad_model->surfaces[0];
     auto hand_surface = model_loader_result_->cad_model->surfaces[1];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    base_surface,
-                    hand_surface,
-                    glm::vec3(0.12, 1.78, 0.31));
     trace_points = TrimTracePoints(trace_points);
     auto render_object = CreateRenderObject(trace_points, "Base-Hand-R");
     scene_->AddRenderObject(render_object);
@@ -83,27 +99,23 @@ std::shared_ptr<IntersectionData>
     data->surface2 = hand_surface;
     data->render_object = render_object;
 
-    ComputeEqualDistanceTracePoints(data);
-    auto render_object2 = CreateRenderObject(data->eq_distanced_trace_points,
-                                            "Base-Hand-R-Eq");
+    data->offset_curve = CreateOffsetCurve(data);
+    auto render_object2 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 1.0f), "Base-Hand-R-Eq");
     scene_->AddRenderObject(render_object2);
 
-    auto render_object3 = CreateRenderObject(data->eq_distanced_trace_points1,
-                                             "Base-Hand-R-Eq1");
+    auto render_object3 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 0.5f), "Base-Hand-R-Eq1");
     scene_->AddRenderObject(render_object3);
 
     return data;
 }
 
 std::shared_ptr<IntersectionData>
-        ParametrizationPath::ComputeBaseHandLeftIntersection(){
+        ParametrizationPath::ComputeBaseHandLeftIntersection(
+                std::vector<TracePoint> trace_points){
     auto base_surface = model_loader_result_->cad_model->surfaces[0];
     auto hand_surface = model_loader_result_->cad_model->surfaces[1];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    base_surface,
-                    hand_surface,
-                    glm::vec3(0.00, 1.72, -0.91));
     trace_points = TrimTracePoints(trace_points);
     auto render_object = CreateRenderObject(trace_points, "Base-Hand-L");
     scene_->AddRenderObject(render_object);
@@ -114,27 +126,23 @@ std::shared_ptr<IntersectionData>
     data->surface2 = hand_surface;
     data->render_object = render_object;
 
-    ComputeEqualDistanceTracePoints(data);
-    auto render_object2 = CreateRenderObject(data->eq_distanced_trace_points,
-                                             "Base-Hand-L-Eq");
+    data->offset_curve = CreateOffsetCurve(data);
+    auto render_object2 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 1.0f), "Base-Hand-L-Eq");
     scene_->AddRenderObject(render_object2);
 
-    auto render_object3 = CreateRenderObject(data->eq_distanced_trace_points1,
-                                             "Base-Hand-L-Eq1");
+    auto render_object3 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 0.5f), "Base-Hand-L-Eq1");
     scene_->AddRenderObject(render_object3);
 
     return data;
 }
 
 std::shared_ptr<IntersectionData>
-        ParametrizationPath::ComputeBaseDrillIntersection(){
+        ParametrizationPath::ComputeBaseDrillIntersection(
+                std::vector<TracePoint> trace_points){
     auto base_surface = model_loader_result_->cad_model->surfaces[0];
     auto drill_surface = model_loader_result_->cad_model->surfaces[2];
-    std::vector<TracePoint> trace_points
-            = ComputeIntersection(
-                    base_surface,
-                    drill_surface,
-                    glm::vec3(0.12, 0.21, 0.77));
     trace_points = TrimTracePoints(trace_points);
     auto render_object = CreateRenderObject(trace_points, "Base-Drill");
     scene_->AddRenderObject(render_object);
@@ -145,18 +153,18 @@ std::shared_ptr<IntersectionData>
     data->surface2 = drill_surface;
     data->render_object = render_object;
 
-    ComputeEqualDistanceTracePoints(data, -1);
-    auto render_object2 = CreateRenderObject(data->eq_distanced_trace_points,
-                                             "Base-Drill-Eq");
+    data->offset_curve = CreateOffsetCurve(data, -1);
+    auto render_object2 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 1.0f), "Base-Drill-Eq");
     scene_->AddRenderObject(render_object2);
 
-    auto render_object3 = CreateRenderObject(data->eq_distanced_trace_points1,
-                                             "Base-Drill-Eq1");
+    auto render_object3 = CreateRenderObject(
+            data->offset_curve->Offset(1.0f, 0.5f), "Base-Drill-Eq1");
     scene_->AddRenderObject(render_object3);
 
 
-    auto render_object4 = CreateRenderObject(data->eq_distanced_trace_points2,
-                                             "Base-Drill-Eq2");
+    auto render_object4 = CreateRenderObject(
+            data->offset_curve->Offset(0.0f, 0.5f), "Base-Drill-Eq2");
     scene_->AddRenderObject(render_object4);
 
     return data;
@@ -175,173 +183,74 @@ std::shared_ptr<Cutter> ParametrizationPath::CreatePath(
             = CreateIntersectionCurveInstructions(
                     intersections_data_.base_drill_);
 
-    auto base_instructions = CreateBaseIntructions();
-    auto hand_instructions = CreateHandIntructions();
-    auto drill_instructions = CreateDrillIntructions();
-    auto inside_hand_instructions = CreateInsideHandInstructions(positions);
+    std::vector<LinkPass> passes;
+    passes.push_back(CreateBasePass());
+    passes.push_back(CreateDrillPass());
+    passes.push_back(CreateHandPass());
+    passes.push_back(CreateInsidePass(positions));
 
-    std::vector<Instruction> instructions;
-/*
-    instructions.insert(instructions.end(),
-                        base_hand_left_intructions.begin(),
-                        base_hand_left_intructions.end());
-
-    instructions.insert(instructions.end(),
-                        base_hand_right_intructions.begin(),
-                        base_hand_right_intructions.end());
-
-    instructions.insert(instructions.end(),
-                        base_drill_intructions.begin(),
-                        base_drill_intructions.end());
-*/
-
-
-
-    instructions.insert(instructions.end(),
-                        base_instructions.begin(),
-                        base_instructions.end());
-    instructions.insert(instructions.end(),
-                        drill_instructions.begin(),
-                        drill_instructions.end());
+    const float safety_adder = 15.0f;
+    const float save_height = material_box_->dimensions().depth + safety_adder;
+    glm::vec3 init_pos = glm::vec3(
+            -material_box_->dimensions().x/2.0f - safety_adder,
+            -material_box_->dimensions().z/2.0f - safety_adder,
+            save_height);
 
-    instructions.insert(instructions.end(),
-                        hand_instructions.begin(),
-                        hand_instructions.end());
+    LinkOptimizer link_optimizer(material_box_->height_map(), radius_);
+    std::vector<Instruction> instructions
+            = link_optimizer.Link(passes, init_pos, id_);
+    std::cout << "Links: "
+    << link_optimizer.report().link_distance << " [mm], safe plane: "
+    << link_optimizer.report().baseline_link_distance << " [mm]"
+    << std::endl;
 
-    instructions.insert(instructions.end(),
-                        inside_hand_instructions.begin(),
-                        inside_hand_instructions.end());
+    MachiningTimeEstimate estimate = EstimateMachiningTime(instructions);
+    std::cout << "ParametrizationPath estimated time: "
+    << estimate.time_s << " [s], scallop height: "
+    << scallop_height_ << " [mm]" << std::endl;
 
     return std::shared_ptr<Cutter>(new Cutter(CutterType::Sphere,
                                               diameter_,
                                               instructions));
 }
 
-std::vector<Instruction> ParametrizationPath::CreateBaseIntructions(){
+LinkPass ParametrizationPath::CreateBasePass(){
     std::vector<glm::vec3> trajectory = CreateBaseTrajectory();
 
-    const float safety_adder = 15.0f;
-    std::vector<Instruction> instructions;
-    const float save_height = material_box_->dimensions().depth + safety_adder;
-    const float start_height = material_box_->dimensions().max_depth;
-
-    glm::vec3 init_pos1 = glm::vec3(
-            -material_box_->dimensions().x/2.0f - safety_adder,
-            -material_box_->dimensions().z/2.0f - safety_adder,
-            save_height);
-
-    glm::vec3 init_pos2 = glm::vec3(
-            GLToMillimeters(trajectory[0].x),
-            GLToMillimeters(trajectory[0].z),
-            save_height);
-
-    instructions.push_back(Instruction(id_++, init_pos1));
-    instructions.push_back(Instruction(id_++, init_pos2));
-    for(unsigned int i = 0; i < trajectory.size(); i++){
-        instructions.push_back(Instruction(id_++,
-                                           GetInstructionPosition(
-                                                   trajectory[i])));
-    }
-
-    glm::vec3 last_pos = instructions[instructions.size()-1].position();
-    last_pos.z = save_height;
-    instructions.push_back(Instruction(id_++, last_pos));
+    LinkPass pass{std::vector<glm::vec3>(), true};
+    for(unsigned int i = 0; i < trajectory.size(); i++)
+        pass.positions.push_back(GetInstructionPosition(trajectory[i]));
 
-    return instructions;
+    return pass;
 }
 
-std::vector<Instruction> ParametrizationPath::CreateHandIntructions(){
+LinkPass ParametrizationPath::CreateHandPass(){
     std::vector<glm::vec3> trajectory = CreateHandTrajectory();
 
-    const float safety_adder = 15.0f;
-    std::vector<Instruction> instructions;
-    const float save_height = material_box_->dimensions().depth + safety_adder;
-    const float start_height = material_box_->dimensions().max_depth;
+    LinkPass pass{std::vector<glm::vec3>(), true};
+    for(unsigned int i = 0; i < trajectory.size(); i++)
+        pass.positions.push_back(GetInstructionPosition(trajectory[i]));
 
-    glm::vec3 init_pos1 = glm::vec3(
-            -material_box_->dimensions().x/2.0f - safety_adder,
-            -material_box_->dimensions().z/2.0f - safety_adder,
-            save_height);
-
-    glm::vec3 init_pos2 = glm::vec3(
-            GLToMillimeters(trajectory[0].x),
-            GLToMillimeters(trajectory[0].z),
-            save_height);
-
-    instructions.push_back(Instruction(id_++, init_pos1));
-    instructions.push_back(Instruction(id_++, init_pos2));
-    for(unsigned int i = 0; i < trajectory.size(); i++){
-        instructions.push_back(Instruction(id_++,
-                                           GetInstructionPosition(
-                                                   trajectory[i])));
-    }
-
-    glm::vec3 last_pos = instructions[instructions.size()-1].position();
-    last_pos.z = save_height;
-    instructions.push_back(Instruction(id_++, last_pos));
-
-    return instructions;
+    return pass;
 }
 
-std::vector<Instruction> ParametrizationPath::CreateDrillIntructions(){
+LinkPass ParametrizationPath::CreateDrillPass(){
     std::vector<glm::vec3> trajectory = CreateDrillTrajectory();
 
-    const float safety_adder = 15.0f;
-    std::vector<Instruction> instructions;
-    const float save_height = material_box_->dimensions().depth + safety_adder;
-    const float start_height = material_box_->dimensions().max_depth;
+    LinkPass pass{std::vector<glm::vec3>(), true};
+    for(unsigned int i = 0; i < trajectory.size(); i++)
+        pass.positions.push_back(GetInstructionPosition(trajectory[i]));
 
-    glm::vec3 init_pos1 = glm::vec3(
-            -material_box_->dimensions().x/2.0f - safety_adder,
-            -material_box_->dimensions().z/2.0f - safety_adder,
-            save_height);
-
-    glm::vec3 init_pos2 = glm::vec3(
-            GLToMillimeters(trajectory[0].x),
-            GLToMillimeters(trajectory[0].z),
-            save_height);
-
-    instructions.push_back(Instruction(id_++, init_pos1));
-    instructions.push_back(Instruction(id_++, init_pos2));
-    for(unsigned int i = 0; i < trajectory.size(); i++){
-        instructions.push_back(Instruction(id_++,
-                                           GetInstructionPosition(
-                                                   trajectory[i])));
-    }
-
-    glm::vec3 last_pos = instructions[instructions.size()-1].position();
-    last_pos.z = save_height;
-    instructions.push_back(Instruction(id_++, last_pos));
-
-    return instructions;
+    return pass;
 }
 
-std::vector<Instruction> ParametrizationPath::CreateInsideHandInstructions(
+LinkPass ParametrizationPath::CreateInsidePass(
         std::vector<glm::vec3>& positions){
-    const float safety_adder = 15.0f;
-    std::vector<Instruction> instructions;
-    if(positions.size() == 0)
-        return instructions;
+    LinkPass pass{std::vector<glm::vec3>(), true};
+    for(unsigned int i = 0; i < positions.size(); i++)
+        pass.positions.push_back(GetInstructionPosition(positions[i]));
 
-    const float save_height = material_box_->dimensions().depth + safety_adder;
-    glm::vec3 pos0 = GetInstructionPosition(positions[0]);
-    pos0.z = save_height;
-    glm::vec3 pos1 = GetInstructionPosition(positions[0]);
-
-    instructions.push_back(Instruction(id_++, pos0));
-    instructions.push_back(Instruction(id_++, pos1));
-
-    for(unsigned int i = 0; i < positions.size(); i++){
-        instructions.push_back(Instruction(id_++,
-                                           GetInstructionPosition
-                                                   (positions[i])));
-    }
-    glm::vec3 pos_last = GetInstructionPosition(positions[positions.size()-1]);
-    pos_last.z = save_height;
-
-    instructions.push_back(Instruction(id_++, pos_last));
-
-    return instructions;
+    return pass;
 }
 
 
@@ -354,8 +263,7 @@ ParametrizationPath::CreateIntersectionCurveInstructions(
 
     const float safety_adder = 15.0f;
     std::vector<Instruction> instructions;
-    auto trace_points = data->eq_distanced_trace_points3;
-    //auto trace_points = data->eq_distanced_trace_points2;
+    auto& trace_points = data->offset_curve->Offset(1.0f, 1.0f);
     if(trace_points.size() == 0)
         return instructions;
 
@@ -390,15 +298,29 @@ ParametrizationPath::CreateIntersectionCurveInstructions(
     return instructions;
 }
 
+AdaptiveStep ParametrizationPath::CreateAdaptiveStep(int surface,
+                                                     float du, float dv,
+                                                     float normal_sign){
+    return AdaptiveStep(
+            model_loader_result_->cad_model->surfaces[surface].get(),
+            radius_, scallop_height_, chordal_tolerance_,
+            glm::vec2(0.25f * du, 0.25f * dv),
+            glm::vec2(3.0f * du, 2.0f * dv),
+            normal_sign);
+}
+
 std::vector<glm::vec3> ParametrizationPath::CreateBaseTrajectory(){
     std::cout << "Base Trajectory " << std::endl;
 
-    auto base_drill_points
-            = intersections_data_.base_drill_->eq_distanced_trace_points1;
-    auto base_left_points
-            = intersections_data_.base_hand_left_->eq_distanced_trace_points1;
-    auto base_right_points
-            = intersections_data_.base_hand_right_->eq_distanced_trace_points1;
+    auto base_drill_points = CreatePointKDTree(
+            intersections_data_.base_drill_->offset_curve
+                    ->Offset(1.0f, 0.5f));
+    auto base_left_points = CreatePointKDTree(
+            intersections_data_.base_hand_left_->offset_curve
+                    ->Offset(1.0f, 0.5f));
+    auto base_right_points = CreatePointKDTree(
+            intersections_data_.base_hand_right_->offset_curve
+                    ->Offset(1.0f, 0.5f));
 
     std::vector<glm::vec3> positions;
     const float max_height = MillimetersToGL(
@@ -409,15 +331,16 @@ std::vector<glm::vec3> ParametrizationPath::CreateBaseTrajectory(){
     float dv = 0.005;
     const float start = 0.0f;
     const float end = 1.0f;
+    auto step = CreateAdaptiveStep(0, du, dv);
 
     //for(float u = start; u < 0.5f; u+=du){
     float start_u = 0.5f - (12.0f*du);
-    for(float u = start_u; u >= 0; u-=du){
+    for(float u = start_u; u >= 0; u-=step.StepOver(u, 0, end)){
         std::vector<glm::vec3> row_positions;
 
         bool has_collided = false;
 
-        for(float v = 0; v < end; v+=dv){
+        for(float v = 0; v < end; v+=step.StepAlong(u, v)){
         //for(float v = end; v >= 0; v-=dv){
             glm::vec3 pos = base_surface->compute(u,v);
 
@@ -501,11 +424,13 @@ std::vector<glm::vec3> ParametrizationPath::CreateBaseTrajectory(){
 }
 
 std::vector<glm::vec3> ParametrizationPath::CreateHandTrajectory(){
-    auto base_hand_left_points
-            = intersections_data_.base_hand_left_->eq_distanced_trace_points2;
+    auto base_hand_left_points = CreatePointKDTree(
+            intersections_data_.base_hand_left_->offset_curve
+                    ->Offset(0.0f, 0.5f));
 
-    auto base_hand_right_points
-            = intersections_data_.base_hand_right_->eq_distanced_trace_points2;
+    auto base_hand_right_points = CreatePointKDTree(
+            intersections_data_.base_hand_right_->offset_curve
+                    ->Offset(0.0f, 0.5f));
 
     std::cout << "Hand Trajectory " << std::endl;
     std::vector<glm::vec3> positions;
@@ -517,13 +442,14 @@ std::vector<glm::vec3> ParametrizationPath::CreateHandTrajectory(){
     float dv = 0.01;
     const float start = 0.0f;
     const float end = 1.0f;
+    auto step = CreateAdaptiveStep(1, du, dv);
 
-    for(float u = start; u < 0.5f; u+=du){
+    for(float u = start; u < 0.5f; u+=step.StepOver(u, 0, end)){
         std::vector<glm::vec3> row_positions;
 
         // <find non-colliding v>
         float start_v = 0.05;
-        for(; start_v < end; start_v+=dv){
+        for(; start_v < end; start_v+=step.StepAlong(u, start_v)){
             glm::vec3 pos = surface->compute(u,start_v);
             if(pos.y <= max_height)
                 continue;
@@ -540,7 +466,7 @@ std::vector<glm::vec3> ParametrizationPath::CreateHandTrajectory(){
         // </find non-colliding v>
         //start_v = 0.05;
 
-        for(float v = start_v; v < end; v+=dv){
+        for(float v = start_v; v < end; v+=step.StepAlong(u, v)){
             glm::vec3 pos = surface->compute(u,v);
             if(pos.y <= max_height)
                 continue;
@@ -571,8 +497,9 @@ std::vector<glm::vec3> ParametrizationPath::CreateHandTrajectory(){
 }
 
 std::vector<glm::vec3> ParametrizationPath::CreateDrillTrajectory(){
-    auto base_drill_points
-            = intersections_data_.base_drill_->eq_distanced_trace_points2;
+    auto base_drill_points = CreatePointKDTree(
+            intersections_data_.base_drill_->offset_curve
+                    ->Offset(0.0f, 0.5f));
     std::cout << "Drill Trajectory " << std::endl;
     std::vector<glm::vec3> positions;
     const float max_height = MillimetersToGL(
@@ -583,11 +510,13 @@ std::vector<glm::vec3> ParametrizationPath::CreateDrillTrajectory(){
     float dv = 0.009f * 1.5f;
     const float start = 0.0f;
     const float end = 1.0f;
+    // Drill normals point the other way, see cross(du, dv) below.
+    auto step = CreateAdaptiveStep(2, du, dv, -1.0f);
 
-    for(float u = 0; u < 0.5f; u+=du)
+    for(float u = 0; u < 0.5f; u+=step.StepOver(u, 0, end))
     {
         std::vector<glm::vec3> row_positions;
-        for(float v = 0; v < end; v+=dv){
+        for(float v = 0; v < end; v+=step.StepAlong(u, v)){
             glm::vec3 pos = surface->compute(u,v);
             if(pos.y <= max_height)
                 continue;
@@ -722,114 +651,41 @@ std::vector<TracePoint> ParametrizationPath::TrimTracePoints(
     return ordered_trace_points;
 }
 
+PointKDTree ParametrizationPath::CreatePointKDTree(
+        const std::vector<TracePoint>& trace_points){
+    std::vector<glm::vec3> points;
+    points.reserve(trace_points.size());
+    for(auto& trace_point : trace_points)
+        points.push_back(trace_point.point);
+    return PointKDTree(points);
+}
+
 bool ParametrizationPath::IsColliding(
-        const std::vector<TracePoint>& trace_points, const glm::vec3& point) {
-    auto center = point;
-    float distance = MillimetersToGL(radius_);
-
-    for (auto& trace_point : trace_points){
-        if(ifx::EuclideanDistance(trace_point.point, center) <=
-                distance){
-            return true;
-        }
-    }
-    return false;
+        const PointKDTree& trace_points, const glm::vec3& point) {
+    return trace_points.HasPointWithin(point, MillimetersToGL(radius_));
 }
 
 bool ParametrizationPath::IsColliding(
-        const std::vector<TracePoint>& trace_points,
+        const PointKDTree& trace_points,
         const glm::vec3& point, glm::vec3* colliding_point) {
     if(!IsColliding(trace_points, point))
         return false;
 
-    auto center = point;
-
-
-    float distance_min = 999999.0f;
-    for(unsigned int i = 0; i < trace_points.size(); i++){
-
-        float current_distance
-                = ifx::EuclideanDistance(trace_points[i].point, center);
-
-        if(current_distance < distance_min){
-            distance_min = current_distance;
-            *colliding_point = trace_points[i].point;
-        }
-    }
-
-    /*
-    float distance = MillimetersToGL(radius_);
-    for (auto& trace_point : trace_points){
-        if(ifx::EuclideanDistance(trace_point.point, center) <=
-           distance){
-            *colliding_point = trace_point.point;
-            return true;
-        }
-    }*/
+    *colliding_point = trace_points.point(trace_points.FindNearest(point));
     return true;
 }
 
-void ParametrizationPath::ComputeEqualDistanceTracePoints(
+std::shared_ptr<OffsetCurve> ParametrizationPath::CreateOffsetCurve(
         std::shared_ptr<IntersectionData> data, int direction){
     const float max_height = MillimetersToGL(
             material_box_->dimensions().depth -
             material_box_->dimensions().max_depth);
 
-    for(auto& trace_point : data->trace_points){
-        glm::vec3 surf_du1 = data->surface1->computeDu(
-                trace_point.params.x, trace_point.params.y);
-        glm::vec3 surf_dv1 = data->surface1->computeDv(
-                trace_point.params.x, trace_point.params.y);
-        glm::vec3 norm1 = glm::cross(surf_dv1, surf_du1);
-
-        norm1 = glm::normalize(norm1);
-
-        glm::vec3 surf_du2 = data->surface2->computeDu(
-                trace_point.params.z, trace_point.params.w);
-        glm::vec3 surf_dv2 = data->surface2->computeDv(
-                trace_point.params.z, trace_point.params.w);
-        glm::vec3 norm2 = glm::cross(surf_dv2, surf_du2);
-        if(direction == -1)
-            norm2 = glm::cross(surf_du2, surf_dv2);
-        norm2 = glm::normalize(norm2);
-
-        auto eq_distanced_trace_point = trace_point;
-
-        eq_distanced_trace_point.point
-                += (MillimetersToGL(radius_) * norm1) +
-                   (MillimetersToGL(radius_) * norm2);
-        if(eq_distanced_trace_point.point.y <= max_height)
-            eq_distanced_trace_point.point.y = max_height;
-        data->eq_distanced_trace_points.push_back(eq_distanced_trace_point);
-
-
-        auto eq_distanced_trace_point1 = trace_point;
-        eq_distanced_trace_point1.point
-                += (MillimetersToGL(radius_) * norm1) +
-                (MillimetersToGL(radius_) * 0.5f * norm2);
-        if(eq_distanced_trace_point1.point.y <= max_height)
-            eq_distanced_trace_point1.point.y = max_height;
-        data->eq_distanced_trace_points1.push_back(eq_distanced_trace_point1);
-
-
-
-        auto eq_distanced_trace_point2 = trace_point;
-        eq_distanced_trace_point2.point
-                += (MillimetersToGL(radius_) * 0.5f * norm2);
-        if(eq_distanced_trace_point2.point.y <= max_height)
-            eq_distanced_trace_point2.point.y = max_height;
-        data->eq_distanced_trace_points2.push_back(eq_distanced_trace_point2);
-
-
-
-        auto eq_distanced_trace_point3 = trace_point;
-        eq_distanced_trace_point3.point
-                += (MillimetersToGL(radius_) * 1.0f * norm1) +
-                   (MillimetersToGL(radius_) * 1.0f * norm2);
-        if(eq_distanced_trace_point3.point.y <= max_height)
-            eq_distanced_trace_point3.point.y = max_height;
-        data->eq_distanced_trace_points3.push_back(eq_distanced_trace_point3);
-    }
+    return std::shared_ptr<OffsetCurve>(new OffsetCurve(
+            data->trace_points, MillimetersToGL(radius_),
+            data->surface1, 1.0f,
+            data->surface2, direction == -1 ? -1.0f : 1.0f,
+            max_height));
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "ifc/path_generation/paths/rest_machining_path.h"
+
+#include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/tool_offset_map.h>
+#include <ifc/path_generation/drop_cutter.h>
+#include <ifc/parallel/thread_pool.h>
+#include <ifc/path_generation/adaptive_step.h>
+#include <ifc/material/material_box.h>
+#include <ifc/material/height_map.h>
+#include <ifc/measures.h>
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/batch_simulation.h>
+#include <ifc/cutter/machining_time.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ifc {
+
+RestMachiningPath::RestMachiningPath(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        std::shared_ptr<MaterialBox> material_box,
+        float diameter, float threshold) :
+        model_loader_result_(model_loader_result),
+        material_box_(material_box),
+        diameter_(diameter),
+        radius_(diameter / 2.0f),
+        threshold_(threshold){}
+
+RestMachiningPath::~RestMachiningPath(){}
+
+std::shared_ptr<Cutter> RestMachiningPath::Generate(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        const std::vector<std::shared_ptr<Cutter>>& previous_cutters){
+    std::cout << "5) Generating RestMachiningPath" << std::endl;
+
+    const float save_height = material_box_->dimensions().depth + 10.0f;
+
+    BatchSimulation simulation(MaterialBoxCreateParams{
+            material_box_->dimensions(), material_box_->precision()});
+    for(unsigned int i = 0; i < previous_cutters.size(); i++){
+        if(!previous_cutters[i])
+            continue;
+        std::cout << "Simulating previous cutter[" << i << "]" << std::endl;
+        simulation.Run(previous_cutters[i]);
+    }
+
+    // Small cutter reaches into details missed by the sampled height map,
+    // so its heights are dropped onto the model itself.
+    DropCutter drop_cutter(model_loader_result_,
+                           material_box_->dimensions().depth
+                           - material_box_->dimensions().max_depth);
+    ThreadPool pool;
+    auto tool_offset_map = std::shared_ptr<ToolOffsetMap>(
+            new ToolOffsetMap(height_map_path, drop_cutter,
+                              CutterType::Sphere, radius_, pool));
+
+    std::vector<bool> mask = CreateRestMask(height_map_path, tool_offset_map,
+                                            simulation.height_map());
+    std::vector<LinkPass> passes = CreatePasses(height_map_path,
+                                                tool_offset_map, mask);
+    std::cout << "Rest passes: " << passes.size() << std::endl;
+
+    glm::vec2 start = GLToMillimeters(height_map_path->Position(0, 0))
+                      + glm::vec2(-10, 0);
+    int id = 0;
+    LinkOptimizer link_optimizer(simulation.height_map(), radius_);
+    std::vector<Instruction> instructions = link_optimizer.Link(
+            passes, glm::vec3(start.x, start.y, save_height), id);
+
+    MachiningTimeEstimate estimate = EstimateMachiningTime(instructions);
+    std::cout << "RestMachiningPath estimated time: "
+    << estimate.time_s << " [s], links: "
+    << link_optimizer.report().link_distance << " [mm]" << std::endl;
+
+    return std::shared_ptr<Cutter>(new Cutter(CutterType::Sphere,
+                                              diameter_,
+                                              instructions));
+}
+
+std::vector<bool> RestMachiningPath::CreateRestMask(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        HeightMap* stock){
+    int n = height_map_path->row_count;
+    int m = height_map_path->column_count;
+    std::vector<bool> mask(n * m, false);
+
+    int rest_count = 0;
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            int index = height_map_path->index(i, j);
+            // Cutter leaves at least the target and its own offset height.
+            float lowest_height = GLToMillimeters(std::max(
+                    height_map_path->heights[index],
+                    tool_offset_map->GetHeight(i, j)));
+            float removable = stock->GetHeight(index) - lowest_height;
+            if(removable > threshold_){
+                mask[index] = true;
+                rest_count++;
+            }
+        }
+    }
+    std::cout << "Rest cells: " << rest_count << std::endl;
+
+    DilateMask(height_map_path, mask);
+    return mask;
+}
+
+void RestMachiningPath::DilateMask(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::vector<bool>& mask){
+    int n = height_map_path->row_count;
+    int m = height_map_path->column_count;
+    int radius_i = std::ceil(radius_ / height_map_path->row_width);
+    int radius_j = std::ceil(radius_ / height_map_path->column_width);
+
+    // Square window, separable: along j, then along i.
+    std::vector<bool> rows(mask.size(), false);
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            int first = std::max(j - radius_j, 0);
+            int last = std::min(j + radius_j, m - 1);
+            bool masked = false;
+            for(int k = first; k <= last && !masked; k++)
+                masked = mask[height_map_path->index(i, k)];
+            rows[height_map_path->index(i, j)] = masked;
+        }
+    }
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            int first = std::max(i - radius_i, 0);
+            int last = std::min(i + radius_i, n - 1);
+            bool masked = false;
+            for(int k = first; k <= last && !masked; k++)
+                masked = rows[height_map_path->index(k, j)];
+            mask[height_map_path->index(i, j)] = masked;
+        }
+    }
+}
+
+std::vector<LinkPass> RestMachiningPath::CreatePasses(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        const std::vector<bool>& mask){
+    int n = height_map_path->row_count;
+    int m = height_map_path->column_count;
+
+    float step_over = ScallopStepOver(scallop_height_, radius_, 0.0f);
+    int skip_rows = std::max((int)(step_over / height_map_path->row_width), 1);
+    int skip_columns = std::max(
+            (int)(point_distance_ / height_map_path->column_width), 1);
+
+    std::vector<LinkPass> passes;
+    int direction = 1;
+    for(int i = 0; i < n; i += skip_rows){
+        std::vector<LinkPass> row_passes;
+        int j = 0;
+        while(j < m){
+            if(!mask[height_map_path->index(i, j)]){
+                j++;
+                continue;
+            }
+            int first_j = j;
+            while(j < m && mask[height_map_path->index(i, j)])
+                j++;
+            int last_j = j - 1;
+
+            LinkPass pass{std::vector<glm::vec3>(), true};
+            for(int k = first_j; k < last_j; k += skip_columns){
+                pass.positions.push_back(PassPosition(height_map_path,
+                                                      tool_offset_map, i, k));
+            }
+            pass.positions.push_back(PassPosition(height_map_path,
+                                                  tool_offset_map, i, last_j));
+            if(direction == -1)
+                std::reverse(pass.positions.begin(), pass.positions.end());
+            row_passes.push_back(pass);
+        }
+        if(row_passes.empty())
+            continue;
+        if(direction == -1)
+            std::reverse(row_passes.begin(), row_passes.end());
+        passes.insert(passes.end(), row_passes.begin(), row_passes.end());
+        direction *= -1;
+    }
+    return passes;
+}
+
+glm::vec3 RestMachiningPath::PassPosition(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        int i, int j){
+    const glm::vec2& position = height_map_path->Position(i, j);
+    float height = GLToMillimeters(std::max(tool_offset_map->GetHeight(i, j),
+                                            height_map_path->init_height));
+    return glm::vec3(GLToMillimeters(position.x),
+                     GLToMillimeters(position.y),
+                     height);
+}
+
+}
@@ -1,6 +1,7 @@
 #include "ifc/path_generation/paths/roughing_path.h"
 
 #include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/tool_offset_map.h>
 #include <ifc/material/material_box.h>
 #include <ifc/material/height_map.h>
 #include <ifc/measures.h>
@@ -10,6 +11,9 @@
 #include <infinity_cad/rendering/render_objects/surfaces/surface_c2_cylind.h>
 #include <ifc/cutter/cutter.h>
 
+#include <algorithm>
+#include <utility>
+
 namespace ifc {
 
 RoughingPath::RoughingPath(
@@ -41,23 +45,22 @@ std::shared_ptr<Cutter> RoughingPath::CreatePath(
     const float diameter = 16.0f;
     const float radius = diameter / 2.0f;
     const float epsilon = 3.0f;
+    // Material left for finishing paths.
+    const float allowance = 0.5f;
 
-    int look_ahead_radius_row
-            = (radius + epsilon) / height_map_path->row_width;
-    int look_ahead_radius_column
-            = (radius + epsilon) / height_map_path->column_width;
     int skip_columns = (radius-epsilon) / height_map_path->column_width;
     int skip_rows = (radius-epsilon) / height_map_path->row_width;
 
     std::cout << "skip_columns: " << skip_columns << std::endl;
     float start_height = material_box->dimensions().depth;
 
-    auto instructions = CreatePathZigZag(height_map_path,
-                                            save_height, start_height,
-                                            radius, n, m,
-                                            skip_rows, skip_columns,
-                                            look_ahead_radius_row,
-                                            look_ahead_radius_column);
+    auto tool_offset_map = std::shared_ptr<ToolOffsetMap>(
+            new ToolOffsetMap(height_map_path, CutterType::Sphere, radius));
+
+    auto instructions = CreatePathZigZag(height_map_path, tool_offset_map,
+                                         save_height, start_height,
+                                         allowance, n, m,
+                                         skip_rows, skip_columns);
 
     auto cutter = std::shared_ptr<Cutter>(new Cutter(CutterType::Sphere,
                                                      diameter,
@@ -67,10 +70,10 @@ std::shared_ptr<Cutter> RoughingPath::CreatePath(
 
 std::vector<Instruction> RoughingPath::CreatePathFromAbove(
         std::shared_ptr<HeightMapPath> height_map_path,
-        float save_height, float start_height, float radius,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        float save_height, float start_height, float allowance,
         int n, int m,
-        int skip_rows, int skip_columns,
-        int look_ahead_radius_row, int look_ahead_radius_column){
+        int skip_rows, int skip_columns){
     std::vector<Instruction> instructions;
 
     int id = 0;
@@ -79,13 +82,11 @@ std::vector<Instruction> RoughingPath::CreatePathFromAbove(
                               save_height));
     for(int i = 0; i < n; i+=skip_rows){
         for(int j = 0; j < m-1; j+=skip_columns){
-            float max_height = MaxHeightInVicinity(i,j,n,m,
-                                                   look_ahead_radius_row,
-                                                   look_ahead_radius_column,
-                                                   height_map_path);
+            float max_height = tool_offset_map->GetHeight(i,j);
             instructions.push_back(
                     CreateInstruction(id++, height_map_path->Position(i,j),
-                                      GLToMillimeters(max_height)));
+                                      GLToMillimeters(max_height)
+                                      + allowance));
             instructions.push_back(
                     CreateInstruction(id++, height_map_path->Position(i,j),
                                       save_height));
@@ -103,10 +104,10 @@ std::vector<Instruction> RoughingPath::CreatePathFromAbove(
 
 std::vector<Instruction> RoughingPath::CreatePathZigZag(
         std::shared_ptr<HeightMapPath> height_map_path,
-        float save_height, float start_height, float radius,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        float save_height, float start_height, float allowance,
         int n, int m,
-        int skip_rows, int skip_columns,
-        int look_ahead_radius_row, int look_ahead_radius_column){
+        int skip_rows, int skip_columns){
     std::vector<Instruction> instructions;
 
     int id = 0;
@@ -125,50 +126,42 @@ std::vector<Instruction> RoughingPath::CreatePathZigZag(
                               + MillimetersToGL(glm::vec2(-10,0)),
                               min_height));
 
+    // Cells visited by the tip, row by row.
+    std::vector<std::pair<int, int>> cells;
     int direction = 1;
     for(int i = 0; i < n; i+=skip_rows){
         if(direction == 1){
-        for(int j = 0; j < m-1; j+=skip_columns){
-            float max_height1 = MaxHeightInVicinity(i,j,n,m,
-                                                   look_ahead_radius_row,
-                                                   look_ahead_radius_column,
-                                                   height_map_path);
-            float max_height2 = MaxHeightInVicinity(i,j+skip_columns,n,m,
-                                                    look_ahead_radius_row,
-                                                    look_ahead_radius_column,
-                                                    height_map_path);
-            instructions.push_back(
-                    CreateInstruction(id++, height_map_path->Position(i,j),
-                                      GLToMillimeters(max_height1)));
-            instructions.push_back(
-                    CreateInstruction(id++,
-                                      height_map_path->Position(
-                                              i,j + 1),
-                                      GLToMillimeters(max_height2)));
-            direction = -1;
-        }}
+            for(int j = 0; j < m-1; j+=skip_columns){
+                cells.push_back(std::make_pair(i, j));
+                cells.push_back(std::make_pair(i, j + 1));
+            }
+        }
         else if(direction == -1) {
             for (int j = m-1; j > 1; j -= skip_columns) {
-                float max_height1 = MaxHeightInVicinity(i, j, n, m,
-                                                        look_ahead_radius_row,
-                                                        look_ahead_radius_column,
-                                                        height_map_path);
-                float max_height2 = MaxHeightInVicinity(i, j - skip_columns, n,
-                                                        m,
-                                                        look_ahead_radius_row,
-                                                        look_ahead_radius_column,
-                                                        height_map_path);
-                instructions.push_back(
-                        CreateInstruction(id++, height_map_path->Position(i, j),
-                                          GLToMillimeters(max_height1)));
-                instructions.push_back(
-                        CreateInstruction(id++,
-                                          height_map_path->Position(
-                                                  i, j - 1),
-                                          GLToMillimeters(max_height2)));
-                direction = 1;
+                cells.push_back(std::make_pair(i, j));
+                cells.push_back(std::make_pair(i, j - 1));
             }
         }
+        direction = -direction;
+    }
+
+    // Both moves of a cell stay above every cell they sweep.
+    for(unsigned int k = 0; k < cells.size(); k++){
+        auto& cell = cells[k];
+        auto& previous_cell = cells[k > 0 ? k - 1 : k];
+        auto& next_cell = cells[k + 1 < cells.size() ? k + 1 : k];
+        float max_height = std::max(
+                tool_offset_map->GetMaxHeight(previous_cell.first,
+                                              previous_cell.second,
+                                              cell.first, cell.second),
+                tool_offset_map->GetMaxHeight(cell.first, cell.second,
+                                              next_cell.first,
+                                              next_cell.second));
+        instructions.push_back(
+                CreateInstruction(id++,
+                                  height_map_path->Position(cell.first,
+                                                            cell.second),
+                                  GLToMillimeters(max_height) + allowance));
     }
     auto last_instruction = instructions[instructions.size()-1];
     auto last_pos = last_instruction.position();
@@ -178,28 +171,6 @@ std::vector<Instruction> RoughingPath::CreatePathZigZag(
     return instructions;
 }
 
-float RoughingPath::MaxHeightInVicinity(
-        int i, int j, int n, int m,
-        int look_ahead_radius_row,
-        int look_ahead_radius_column,
-        std::shared_ptr<HeightMapPath> height_map_path){
-    float max = -1.0f;
-    // Go back if encoutered obstacle
-    for(int ii = -look_ahead_radius_row; ii < look_ahead_radius_row; ii++){
-        if(ii + i < 0 || ii + i >= n)
-            continue;
-        for(int jj = -look_ahead_radius_column; jj < look_ahead_radius_column; jj++){
-            if(jj + j < 0 || jj + j >= m)
-                continue;
-
-            float height = height_map_path->GetHeight(ii+i,jj+j);
-            if(height > max)
-                max = height;
-        }
-    }
-    return max;
-}
-
 Instruction RoughingPath::CreateInstruction(int id,
                                             const glm::vec2& v,
                                             float height){
@@ -0,0 +1,224 @@
+#include "ifc/path_generation/paths/z_level_roughing_path.h"
+
+#include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/tool_offset_map.h>
+#include <ifc/material/material_box.h>
+#include <ifc/measures.h>
+#include <ifc/cutter/cutter.h>
+#include <ifc/cutter/machining_time.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ifc {
+
+ZLevelRoughingPath::ZLevelRoughingPath(
+        std::shared_ptr<CADModelLoaderResult> model_loader_result,
+        std::shared_ptr<MaterialBox> material_box,
+        float step_down) :
+        model_loader_result_(model_loader_result),
+        material_box_(material_box),
+        step_down_(step_down),
+        id_(0){}
+
+ZLevelRoughingPath::~ZLevelRoughingPath(){}
+
+std::shared_ptr<Cutter> ZLevelRoughingPath::Generate(
+        std::shared_ptr<HeightMapPath> height_map_path){
+    std::cout << "1) Generating ZLevelRoughingPath" << std::endl;
+    id_ = 0;
+
+    const float epsilon = 3.0f;
+    const float save_height = material_box_->dimensions().depth + 10.0f;
+    const float min_height = material_box_->dimensions().depth -
+            material_box_->dimensions().max_depth;
+
+    int skip_columns = (radius_ - epsilon) / height_map_path->column_width;
+    int skip_rows = (radius_ - epsilon) / height_map_path->row_width;
+
+    auto tool_offset_map = std::shared_ptr<ToolOffsetMap>(
+            new ToolOffsetMap(height_map_path, CutterType::Sphere, radius_));
+
+    std::vector<Instruction> instructions;
+    AddInstruction(instructions,
+                   height_map_path->Position(0,0)
+                   + MillimetersToGL(glm::vec2(-10,0)),
+                   save_height, true);
+
+    std::vector<float> levels = CreateLevels(min_height);
+    float previous_level = material_box_->dimensions().depth;
+    for(unsigned int l = 0; l < levels.size(); l++){
+        std::cout << "Level[" << l << "]: " << levels[l] << std::endl;
+        auto level_instructions = CreateLevelPath(height_map_path,
+                                                  tool_offset_map,
+                                                  levels[l], previous_level,
+                                                  save_height,
+                                                  skip_rows, skip_columns);
+        instructions.insert(instructions.end(),
+                            level_instructions.begin(),
+                            level_instructions.end());
+        previous_level = levels[l];
+    }
+
+    MachiningTimeEstimate estimate = EstimateMachiningTime(instructions);
+    std::cout << "ZLevelRoughingPath estimated time: "
+    << estimate.time_s << " [s]" << std::endl;
+
+    return std::shared_ptr<Cutter>(new Cutter(CutterType::Sphere,
+                                              diameter_,
+                                              instructions));
+}
+
+std::vector<float> ZLevelRoughingPath::CreateLevels(float min_height){
+    std::vector<float> levels;
+    if(step_down_ <= 0.0f){
+        levels.push_back(min_height);
+        return levels;
+    }
+    float level = material_box_->dimensions().depth - step_down_;
+    for(; level > min_height; level -= step_down_)
+        levels.push_back(level);
+    levels.push_back(min_height);
+
+    return levels;
+}
+
+std::vector<Instruction> ZLevelRoughingPath::CreateLevelPath(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        float level, float previous_level, float save_height,
+        int skip_rows, int skip_columns){
+    int n = height_map_path->row_count;
+    int m = height_map_path->column_count;
+    skip_rows = std::max(skip_rows, 1);
+    skip_columns = std::max(skip_columns, 1);
+
+    std::vector<Instruction> instructions;
+
+    bool has_last = false;
+    int last_i = 0;
+    int last_j = 0;
+    float last_height = 0.0f;
+    int direction = 1;
+    for(int i = 0; i < n; i += skip_rows){
+        // Find the range of the row which still holds material.
+        int first_j = -1;
+        int last_active_j = -1;
+        for(int j = 0; j < m; j += skip_columns){
+            if(HasMaterial(tool_offset_map, i, j,
+                           skip_rows, skip_columns, previous_level)){
+                if(first_j == -1)
+                    first_j = j;
+                last_active_j = j;
+            }
+        }
+        if(first_j == -1)
+            continue;
+
+        std::vector<int> columns;
+        for(int j = first_j; j <= last_active_j; j += skip_columns)
+            columns.push_back(j);
+        if(direction == -1)
+            std::reverse(columns.begin(), columns.end());
+        direction = -direction;
+
+        // Moves to both neighbours stay above every column they sweep.
+        std::vector<float> heights(columns.size());
+        for(unsigned int c = 0; c < columns.size(); c++){
+            int previous_j = columns[c > 0 ? c - 1 : c];
+            int next_j = columns[c + 1 < columns.size() ? c + 1 : c];
+            heights[c] = std::max(
+                    LinkHeight(tool_offset_map,
+                               i, previous_j, i, columns[c], level),
+                    LinkHeight(tool_offset_map,
+                               i, columns[c], i, next_j, level));
+        }
+
+        int start_j = columns[0];
+        float start_height = heights[0];
+        if(!has_last){
+            AddInstruction(instructions, height_map_path->Position(i, start_j),
+                           save_height, true);
+            AddInstruction(instructions, height_map_path->Position(i, start_j),
+                           start_height);
+        }else{
+            float link_height = LinkHeight(tool_offset_map,
+                                           last_i, last_j, i, start_j, level);
+            if(link_height > std::min(last_height, start_height)){
+                AddInstruction(instructions,
+                               height_map_path->Position(last_i, last_j),
+                               link_height);
+                AddInstruction(instructions,
+                               height_map_path->Position(i, start_j),
+                               link_height);
+            }
+        }
+
+        for(unsigned int c = 0; c < columns.size(); c++){
+            AddInstruction(instructions,
+                           height_map_path->Position(i, columns[c]),
+                           heights[c]);
+        }
+        has_last = true;
+        last_i = i;
+        last_j = columns[columns.size() - 1];
+        last_height = heights[heights.size() - 1];
+    }
+    if(has_last){
+        AddInstruction(instructions,
+                       height_map_path->Position(last_i, last_j),
+                       save_height, true);
+    }
+
+    return instructions;
+}
+
+bool ZLevelRoughingPath::HasMaterial(
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        int i, int j, int skip_rows, int skip_columns,
+        float previous_level){
+    for(int ii = -skip_rows / 2; ii <= skip_rows / 2; ii++){
+        for(int jj = -skip_columns / 2; jj <= skip_columns / 2; jj++){
+            float height = GLToMillimeters(
+                    tool_offset_map->GetHeight(i + ii, j + jj)) + allowance_;
+            if(height < previous_level)
+                return true;
+        }
+    }
+    return false;
+}
+
+float ZLevelRoughingPath::TargetHeight(
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        int i, int j, float level){
+    float height = GLToMillimeters(tool_offset_map->GetHeight(i, j))
+                   + allowance_;
+    return std::max(height, level);
+}
+
+float ZLevelRoughingPath::LinkHeight(
+        std::shared_ptr<ToolOffsetMap> tool_offset_map,
+        int i1, int j1, int i2, int j2, float level){
+    int steps = std::max(std::abs(i2 - i1), std::abs(j2 - j1));
+    float height = level;
+    for(int s = 0; s <= steps; s++){
+        float t = steps == 0 ? 0.0f : (float)s / (float)steps;
+        int i = std::round(i1 + t * (i2 - i1));
+        int j = std::round(j1 + t * (j2 - j1));
+        height = std::max(height, TargetHeight(tool_offset_map, i, j, level));
+    }
+    return height;
+}
+
+void ZLevelRoughingPath::AddInstruction(std::vector<Instruction>& instructions,
+                                        const glm::vec2& v, float height,
+                                        bool fast){
+    glm::vec3 pos = glm::vec3(GLToMillimeters(v.x),
+                              GLToMillimeters(v.y),
+                              height);
+    InstructionSpeedMode speed_mode = fast ? InstructionSpeedMode::FAST
+                                           : InstructionSpeedMode::NORMAL;
+    instructions.push_back(Instruction(id_++, pos, speed_mode));
+}
+
+}
@@ -0,0 +1,180 @@
+#include "ifc/path_generation/tool_offset_map.h"
+
+#include <ifc/path_generation/height_map_paths.h>
+#include <ifc/path_generation/drop_cutter.h>
+#include <ifc/measures.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ifc {
+
+ToolOffsetMap::ToolOffsetMap(std::shared_ptr<HeightMapPath> height_map_path,
+                             CutterType type, float radius,
+                             int sphere_levels) :
+        type_(type),
+        radius_(radius),
+        row_count_(height_map_path->row_count),
+        column_count_(height_map_path->column_count){
+    std::vector<Chord> chords = CreateChords(height_map_path, sphere_levels);
+    std::cout << "ToolOffsetMap chords: " << chords.size() << std::endl;
+
+    Compute(height_map_path, chords);
+}
+
+ToolOffsetMap::ToolOffsetMap(std::shared_ptr<HeightMapPath> height_map_path,
+                             const DropCutter& drop_cutter,
+                             CutterType type, float radius,
+                             ThreadPool& pool) :
+        type_(type),
+        radius_(radius),
+        row_count_(height_map_path->row_count),
+        column_count_(height_map_path->column_count){
+    std::vector<glm::vec2> positions(row_count_ * column_count_);
+    for(int i = 0; i < row_count_; i++){
+        for(int j = 0; j < column_count_; j++){
+            positions[i * column_count_ + j]
+                    = GLToMillimeters(height_map_path->Position(i, j));
+        }
+    }
+
+    heights_ = drop_cutter.Heights(positions, type_, radius_, pool);
+    for(auto& height : heights_)
+        height = MillimetersToGL(height);
+}
+
+ToolOffsetMap::~ToolOffsetMap(){}
+
+float ToolOffsetMap::GetHeight(int i, int j){
+    i = std::min(std::max(i, 0), row_count_ - 1);
+    j = std::min(std::max(j, 0), column_count_ - 1);
+    return heights_[i * column_count_ + j];
+}
+
+float ToolOffsetMap::GetMaxHeight(int i1, int j1, int i2, int j2){
+    float height = std::numeric_limits<float>::lowest();
+    for(int i = std::min(i1, i2); i <= std::max(i1, i2); i++){
+        for(int j = std::min(j1, j2); j <= std::max(j1, j2); j++)
+            height = std::max(height, GetHeight(i, j));
+    }
+    return height;
+}
+
+std::vector<ToolOffsetMap::Chord> ToolOffsetMap::CreateChords(
+        std::shared_ptr<HeightMapPath> height_map_path,
+        int sphere_levels){
+    std::vector<Chord> chords;
+
+    int levels = 1;
+    if(type_ == CutterType::Sphere)
+        levels = std::max(sphere_levels, 1);
+
+    for(int k = 0; k < levels; k++){
+        // Each level is a disc, covering the annulus where sphere profile
+        // lies between levels k and k+1. Upper value of the profile is used.
+        float profile_height = -radius_ * (float)k / (float)levels;
+        float disc_radius = radius_;
+        if(type_ == CutterType::Sphere){
+            float next_height = -radius_ * (float)(k + 1) / (float)levels;
+            float c = radius_ + next_height;
+            disc_radius = std::sqrt(std::max(radius_*radius_ - c*c, 0.0f));
+        }
+
+        int row_radius = disc_radius / height_map_path->row_width;
+        for(int di = -row_radius; di <= row_radius; di++){
+            float dy = di * height_map_path->row_width;
+            float half_width = std::sqrt(
+                    std::max(disc_radius*disc_radius - dy*dy, 0.0f));
+            int column_radius = half_width / height_map_path->column_width;
+
+            chords.push_back(Chord{di, column_radius,
+                                   MillimetersToGL(profile_height)});
+        }
+    }
+    std::sort(chords.begin(), chords.end(),
+              [](const Chord& a, const Chord& b){
+                  return a.half_width < b.half_width;
+              });
+    return chords;
+}
+
+void ToolOffsetMap::Compute(std::shared_ptr<HeightMapPath> height_map_path,
+                            const std::vector<Chord>& chords){
+    int n = row_count_;
+    int m = column_count_;
+
+    std::vector<float> surface(n * m);
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++){
+            surface[i * m + j] = height_map_path->GetHeight(i, j);
+        }
+    }
+    heights_.assign(n * m, std::numeric_limits<float>::lowest());
+
+    std::vector<float> row_maximum;
+    unsigned int c = 0;
+    while(c < chords.size()){
+        int half_width = chords[c].half_width;
+        RowMaximum(surface, half_width, row_maximum);
+
+        // All chords of the same width reuse the same row maximum.
+        for(; c < chords.size() && chords[c].half_width == half_width; c++){
+            const Chord& chord = chords[c];
+            for(int i = 0; i < n; i++){
+                int source_i = i + chord.row_offset;
+                if(source_i < 0 || source_i >= n)
+                    continue;
+                float* destination = &heights_[i * m];
+                const float* source = &row_maximum[source_i * m];
+                for(int j = 0; j < m; j++){
+                    float height = source[j] + chord.height;
+                    if(height > destination[j])
+                        destination[j] = height;
+                }
+            }
+        }
+    }
+}
+
+void ToolOffsetMap::RowMaximum(const std::vector<float>& heights,
+                               int half_width,
+                               std::vector<float>& result){
+    int n = row_count_;
+    int m = column_count_;
+    int window = 2*half_width + 1;
+    int block_count = (m + 2*half_width + window - 1) / window;
+    int padded_size = block_count * window;
+    const float lowest = std::numeric_limits<float>::lowest();
+
+    std::vector<float> padded(padded_size);
+    std::vector<float> prefix_max(padded_size);
+    std::vector<float> suffix_max(padded_size);
+    result.resize(n * m);
+
+    for(int i = 0; i < n; i++){
+        for(int k = 0; k < padded_size; k++){
+            int j = k - half_width;
+            padded[k] = (j >= 0 && j < m) ? heights[i * m + j] : lowest;
+        }
+        for(int k = 0; k < padded_size; k++){
+            if(k % window == 0)
+                prefix_max[k] = padded[k];
+            else
+                prefix_max[k] = std::max(prefix_max[k-1], padded[k]);
+        }
+        for(int k = padded_size - 1; k >= 0; k--){
+            if(k % window == window - 1)
+                suffix_max[k] = padded[k];
+            else
+                suffix_max[k] = std::max(suffix_max[k+1], padded[k]);
+        }
+        // window of j in padded coordinates is [j, j + 2*half_width].
+        for(int j = 0; j < m; j++){
+            result[i * m + j] = std::max(suffix_max[j],
+                                         prefix_max[j + 2*half_width]);
+        }
+    }
+}
+
+}